@@ -0,0 +1,103 @@
+#pragma once
+
+#include <utils/macro.hpp>
+#include <utils/pointers/unique_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace nlang::ast {
+
+/**
+ * Deleter for objects, placed in arena.
+ * Only destroys the object, memory is released by the arena itself.
+ */
+struct ArenaDeleter {
+    template<typename T>
+    void operator()(T* object) const noexcept {
+        object->~T();
+    }
+};
+
+/**
+ * Unique pointer to the object, placed in arena
+ */
+template<typename T>
+using ArenaPtr = UniquePtr<T, ArenaDeleter>;
+
+/**
+ * Arena (bump allocator) for AST nodes.
+ * Nodes are placed one after another in big blocks, which are freed all at once with the arena.
+ * Arena must outlive all the objects, placed in it.
+ */
+class Arena final {
+public:
+    /**
+     * Default size of the block in bytes
+     */
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena(Arena&&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena& operator=(Arena&&) = delete;
+
+    /**
+     * Allocates uninitialized memory
+     * @param size Size in bytes
+     * @param alignment Alignment, not greater than alignment of std::max_align_t
+     * @return Pointer to allocated memory
+     */
+    NLANG_FORCE_INLINE void* Allocate(size_t size, size_t alignment) {
+        NLANG_ASSERT(alignment <= alignof(std::max_align_t));
+        uintptr_t address = (current + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (NLANG_UNLIKELY(address + size > end)) {
+            AllocateBlock(size);
+            address = current;
+        }
+        current = address + size;
+        return reinterpret_cast<void*>(address);
+    }
+
+    /**
+     * Creates new object in arena
+     * @tparam T Object type
+     * @param args Constructor arguments
+     * @return Pointer to created object
+     */
+    template<typename T, typename ...Args>
+    ArenaPtr<T> New(Args&&... args) {
+        return ArenaPtr<T>(new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...));
+    }
+
+    /**
+     * Returns amount of memory, reserved by arena
+     * @return Size in bytes
+     */
+    size_t GetReservedSize() const {
+        return reserved;
+    }
+
+private:
+    void AllocateBlock(size_t size) {
+        const size_t block_size = std::max(size, BLOCK_SIZE);
+        // memory, returned by new[], is aligned to std::max_align_t
+        blocks.emplace_back(new std::byte[block_size]);
+        current = reinterpret_cast<uintptr_t>(blocks.back().get());
+        end = current + block_size;
+        reserved += block_size;
+    }
+
+private:
+    std::vector<UniquePtr<std::byte[]>> blocks;
+    uintptr_t current = 0;
+    uintptr_t end = 0;
+    size_t reserved = 0;
+};
+
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <common/arena.hpp>
+#include <common/source.hpp>
 #include <common/token.hpp>
 
 #include <utils/macro.hpp>
@@ -9,6 +11,7 @@
 #include <utility>
 #include <cctype>
 #include <vector>
+#include <string>
 
 /**
  * Namespace for AST classes
@@ -121,7 +124,7 @@ virtual void Accept(IASTVisitor& visitor) {     \
 /**
  * AST node class
  */
-class INode : public IntrusivePtrRefCounter {
+class INode {
 public:
     VISITOR_ACCEPT
 
@@ -143,8 +146,8 @@ protected:
     INode() {};
 };
 
-INode::IMeta::~IMeta() = default;
-INode::~INode() = default;
+inline INode::IMeta::~IMeta() = default;
+inline INode::~INode() = default;
 
 
 class IExpression : public INode {
@@ -154,7 +157,7 @@ public:
     virtual ~IExpression() = 0;
 };
 
-IExpression::~IExpression() = default;
+inline IExpression::~IExpression() = default;
 
 
 class IStatement : public INode {
@@ -164,7 +167,7 @@ public:
     virtual ~IStatement() = 0;
 };
 
-IStatement::~IStatement() = default;
+inline IStatement::~IStatement() = default;
 
 
 class ILiteral : public INode {
@@ -174,7 +177,7 @@ public:
     virtual ~ILiteral() = 0;
 };
 
-ILiteral::~ILiteral() = default;
+inline ILiteral::~ILiteral() = default;
 
 
 class NullLiteral : public ILiteral {
@@ -213,7 +216,9 @@ public:
     explicit NumberLiteral(TokenInstance&& token)
         : token(std::move(token))
     {
-        number = std::stod(token.text.GetStdStr());
+        // number literals consist of ASCII digits and dot only
+        const auto text = this->token.GetTextView();
+        number = std::stod(std::string(text.begin(), text.end()));
     }
 };
 
@@ -227,7 +232,7 @@ public:
 
     explicit StringLiteral(TokenInstance&& token)
         : token(std::move(token))
-        , string(UString(this->token.text, 1, this->token.text.GetLength() - 2).Unescape())
+        , string(UString::Alias(this->token.GetTextView().substr(1, this->token.length - 2)).Unescape())
     {
 
     }
@@ -243,7 +248,7 @@ public:
 
     explicit IdentifierLiteral(TokenInstance&& token)
         : token(std::move(token))
-        , identifier(this->token.text.SubStringView())
+        , identifier(UString::Alias(this->token.GetTextView()))
     {}
 };
 
@@ -253,9 +258,9 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance colon;
-    UniquePtr<IdentifierLiteral> name;
+    ArenaPtr<IdentifierLiteral> name;
 
-    TypeHint(TokenInstance&& colon, UniquePtr<IdentifierLiteral>&& name)
+    TypeHint(TokenInstance&& colon, ArenaPtr<IdentifierLiteral>&& name)
         : colon(std::move(colon))
         , name(std::move(name))
     {}
@@ -267,9 +272,9 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance assignment;
-    UniquePtr<IExpression> value;
+    ArenaPtr<IExpression> value;
 
-    DefaultValue(TokenInstance&& assignment, UniquePtr<IExpression>&& value)
+    DefaultValue(TokenInstance&& assignment, ArenaPtr<IExpression>&& value)
         : assignment(std::move(assignment))
         , value(std::move(value))
     {}
@@ -280,9 +285,9 @@ class LiteralExpression : public IExpression {
 public:
     VISITOR_ACCEPT
 
-    UniquePtr<ILiteral> literal;
+    ArenaPtr<ILiteral> literal;
 
-    LiteralExpression(UniquePtr<ILiteral>&& literal)
+    LiteralExpression(ArenaPtr<ILiteral>&& literal)
         : literal(std::move(literal))
     {}
 };
@@ -293,10 +298,10 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance left_par;
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
     TokenInstance right_par;
 
-    ParenthesizedExpression(TokenInstance&& left_par, UniquePtr<IExpression>&& expression, TokenInstance&& right_par)
+    ParenthesizedExpression(TokenInstance&& left_par, ArenaPtr<IExpression>&& expression, TokenInstance&& right_par)
         : left_par(std::move(left_par))
         , expression(std::move(expression))
         , right_par(std::move(right_par))
@@ -309,9 +314,9 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance prefix;
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
 
-    PrefixExpression(TokenInstance&& prefix, UniquePtr<IExpression>&& expression)
+    PrefixExpression(TokenInstance&& prefix, ArenaPtr<IExpression>&& expression)
         : prefix(std::move(prefix))
         , expression(std::move(expression))
     {}
@@ -322,10 +327,10 @@ class PostfixExpression : public IExpression {
 public:
     VISITOR_ACCEPT
 
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
     TokenInstance postfix;
 
-    PostfixExpression(UniquePtr<IExpression>&& expression, TokenInstance&& postfix)
+    PostfixExpression(ArenaPtr<IExpression>&& expression, TokenInstance&& postfix)
         : expression(std::move(expression))
         , postfix(std::move(postfix))
     {}
@@ -336,11 +341,11 @@ class BinaryExpression : public IExpression {
 public:
     VISITOR_ACCEPT
 
-    UniquePtr<IExpression> left;
+    ArenaPtr<IExpression> left;
     TokenInstance op;
-    UniquePtr<IExpression> right;
+    ArenaPtr<IExpression> right;
 
-    BinaryExpression(UniquePtr<IExpression>&& left, TokenInstance&& op, UniquePtr<IExpression>&& right)
+    BinaryExpression(ArenaPtr<IExpression>&& left, TokenInstance&& op, ArenaPtr<IExpression>&& right)
         : left(std::move(left))
         , op(std::move(op))
         , right(std::move(right))
@@ -353,15 +358,15 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance let;
-    UniquePtr<IdentifierLiteral> name;
-    UniquePtr<TypeHint> type_hint;
-    UniquePtr<DefaultValue> default_value;
+    ArenaPtr<IdentifierLiteral> name;
+    ArenaPtr<TypeHint> type_hint;
+    ArenaPtr<DefaultValue> default_value;
 
     explicit VariableDefinitionStatement(
         TokenInstance&& let,
-        UniquePtr<IdentifierLiteral>&& name,
-        UniquePtr<TypeHint>&& type_hint,
-        UniquePtr<DefaultValue>&& default_value)
+        ArenaPtr<IdentifierLiteral>&& name,
+        ArenaPtr<TypeHint>&& type_hint,
+        ArenaPtr<DefaultValue>&& default_value)
 
         : let(std::move(let))
         , name(std::move(name))
@@ -375,15 +380,15 @@ class ArgumentDefinitionStatementPart : public INode {
 public:
     VISITOR_ACCEPT
 
-    UniquePtr<IdentifierLiteral> name;
-    UniquePtr<TypeHint> type_hint;
-    UniquePtr<DefaultValue> default_value;
+    ArenaPtr<IdentifierLiteral> name;
+    ArenaPtr<TypeHint> type_hint;
+    ArenaPtr<DefaultValue> default_value;
     int32_t index = 0;
 
     explicit ArgumentDefinitionStatementPart(
-        UniquePtr<IdentifierLiteral>&& name,
-        UniquePtr<TypeHint>&& type_hint,
-        UniquePtr<DefaultValue>&& default_value)
+        ArenaPtr<IdentifierLiteral>&& name,
+        ArenaPtr<TypeHint>&& type_hint,
+        ArenaPtr<DefaultValue>&& default_value)
 
         : name(std::move(name))
         , type_hint(std::move(type_hint))
@@ -433,21 +438,21 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance fn;
-    UniquePtr<IdentifierLiteral> name;
+    ArenaPtr<IdentifierLiteral> name;
     TokenInstance left_par;
-    std::vector<UniquePtr<ArgumentDefinitionStatementPart>> arguments;
+    std::vector<ArenaPtr<ArgumentDefinitionStatementPart>> arguments;
     TokenInstance right_par;
-    UniquePtr<TypeHint> type_hint;
-    UniquePtr<IStatement> body;
+    ArenaPtr<TypeHint> type_hint;
+    ArenaPtr<IStatement> body;
 
     FunctionDefinitionExpression(
         TokenInstance&& fn,
-        UniquePtr<IdentifierLiteral>&& name,
+        ArenaPtr<IdentifierLiteral>&& name,
         TokenInstance&& left_par,
-        std::vector<UniquePtr<ArgumentDefinitionStatementPart>>&& arguments,
+        std::vector<ArenaPtr<ArgumentDefinitionStatementPart>>&& arguments,
         TokenInstance&& right_par,
-        UniquePtr<TypeHint>&& type_hint,
-        UniquePtr<IStatement>&& body)
+        ArenaPtr<TypeHint>&& type_hint,
+        ArenaPtr<IStatement>&& body)
 
         : fn(std::move(fn))
         , name(std::move(name))
@@ -465,21 +470,21 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance fn;
-    UniquePtr<IdentifierLiteral> name;
+    ArenaPtr<IdentifierLiteral> name;
     TokenInstance left_par;
-    std::vector<UniquePtr<ArgumentDefinitionStatementPart>> arguments;
+    std::vector<ArenaPtr<ArgumentDefinitionStatementPart>> arguments;
     TokenInstance right_par;
-    UniquePtr<TypeHint> type_hint;
-    UniquePtr<IStatement> body;
+    ArenaPtr<TypeHint> type_hint;
+    ArenaPtr<IStatement> body;
 
     FunctionDefinitionStatement(
         TokenInstance&& fn,
-        UniquePtr<IdentifierLiteral>&& name,
+        ArenaPtr<IdentifierLiteral>&& name,
         TokenInstance&& left_par,
-        std::vector<UniquePtr<ArgumentDefinitionStatementPart>>&& arguments,
+        std::vector<ArenaPtr<ArgumentDefinitionStatementPart>>&& arguments,
         TokenInstance&& right_par,
-        UniquePtr<TypeHint>&& type_hint,
-        UniquePtr<IStatement>&& body)
+        ArenaPtr<TypeHint>&& type_hint,
+        ArenaPtr<IStatement>&& body)
 
         : fn(std::move(fn))
         , name(std::move(name))
@@ -496,12 +501,12 @@ class FunctionCallExpression : public IExpression {
 public:
     VISITOR_ACCEPT
 
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
     TokenInstance left_par;
-    std::vector<UniquePtr<IExpression>> arguments;
+    std::vector<ArenaPtr<IExpression>> arguments;
     TokenInstance right_par;
 
-    FunctionCallExpression(UniquePtr<IExpression>&& expression, TokenInstance&& left_par, std::vector<UniquePtr<IExpression>>&& arguments, TokenInstance&& right_par)
+    FunctionCallExpression(ArenaPtr<IExpression>&& expression, TokenInstance&& left_par, std::vector<ArenaPtr<IExpression>>&& arguments, TokenInstance&& right_par)
         : expression(std::move(expression))
         , left_par(std::move(left_par))
         , arguments(std::move(arguments))
@@ -514,12 +519,12 @@ class SubscriptExpression : public IExpression {
 public:
     VISITOR_ACCEPT
 
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
     TokenInstance left_bracket;
-    std::vector<UniquePtr<IExpression>> arguments;
+    std::vector<ArenaPtr<IExpression>> arguments;
     TokenInstance right_bracket;
 
-    SubscriptExpression(UniquePtr<IExpression>&& expression, TokenInstance&& left_bracket, std::vector<UniquePtr<IExpression>>&& arguments, TokenInstance&& right_bracket)
+    SubscriptExpression(ArenaPtr<IExpression>&& expression, TokenInstance&& left_bracket, std::vector<ArenaPtr<IExpression>>&& arguments, TokenInstance&& right_bracket)
         : expression(std::move(expression))
         , left_bracket(std::move(left_bracket))
         , arguments(std::move(arguments))
@@ -532,11 +537,11 @@ class MemberAccessExpression : public IExpression {
 public:
     VISITOR_ACCEPT
 
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
     TokenInstance dot;
-    UniquePtr<IdentifierLiteral> name;
+    ArenaPtr<IdentifierLiteral> name;
 
-    MemberAccessExpression(UniquePtr<IExpression>&& expression, TokenInstance&& dot, UniquePtr<IdentifierLiteral>&& name)
+    MemberAccessExpression(ArenaPtr<IExpression>&& expression, TokenInstance&& dot, ArenaPtr<IdentifierLiteral>&& name)
         : expression(std::move(expression))
         , dot(std::move(dot))
         , name(std::move(name))
@@ -573,9 +578,9 @@ class ExpressionStatement : public IStatement {
 public:
     VISITOR_ACCEPT
 
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
 
-    explicit ExpressionStatement(UniquePtr<IExpression>&& expression)
+    explicit ExpressionStatement(ArenaPtr<IExpression>&& expression)
         : expression(std::move(expression))
     {}
 };
@@ -586,10 +591,10 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance left_brace;
-    std::vector<UniquePtr<IStatement>> statements;
+    std::vector<ArenaPtr<IStatement>> statements;
     TokenInstance right_brace;
 
-    explicit BlockStatement(TokenInstance&& right_brace, std::vector<UniquePtr<IStatement>>&& statements, TokenInstance&& left_brace)
+    explicit BlockStatement(TokenInstance&& right_brace, std::vector<ArenaPtr<IStatement>>&& statements, TokenInstance&& left_brace)
         : left_brace(std::move(left_brace))
         , statements(std::move(statements))
         , right_brace(std::move(right_brace))
@@ -602,9 +607,9 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance else_token;
-    UniquePtr<IStatement> body;
+    ArenaPtr<IStatement> body;
 
-    ElseStatementPart(TokenInstance&& else_token, UniquePtr<IStatement>&& body)
+    ElseStatementPart(TokenInstance&& else_token, ArenaPtr<IStatement>&& body)
         : else_token(std::move(else_token))
         , body(std::move(body))
     {}
@@ -616,18 +621,18 @@ public:
 
     TokenInstance if_token;
     TokenInstance left_par;
-    UniquePtr<IExpression> condition;
+    ArenaPtr<IExpression> condition;
     TokenInstance right_par;
-    UniquePtr<IStatement> body;
-    UniquePtr<ElseStatementPart> else_branch;
+    ArenaPtr<IStatement> body;
+    ArenaPtr<ElseStatementPart> else_branch;
 
     explicit IfElseStatement(
         TokenInstance&& if_token,
         TokenInstance&& left_par,
-        UniquePtr<IExpression>&& condition,
+        ArenaPtr<IExpression>&& condition,
         TokenInstance&& right_par,
-        UniquePtr<IStatement>&& body,
-        UniquePtr<ElseStatementPart>&& else_branch)
+        ArenaPtr<IStatement>&& body,
+        ArenaPtr<ElseStatementPart>&& else_branch)
 
         : if_token(std::move(if_token))
         , left_par(std::move(left_par))
@@ -645,16 +650,16 @@ public:
 
     TokenInstance while_token;
     TokenInstance left_par;
-    UniquePtr<IExpression> condition;
+    ArenaPtr<IExpression> condition;
     TokenInstance right_par;
-    UniquePtr<IStatement> body;
+    ArenaPtr<IStatement> body;
 
     explicit WhileStatement(
         TokenInstance&& while_token,
         TokenInstance&& left_par,
-        UniquePtr<IExpression>&& condition,
+        ArenaPtr<IExpression>&& condition,
         TokenInstance&& right_par,
-        UniquePtr<IStatement>&& body)
+        ArenaPtr<IStatement>&& body)
 
         : while_token(std::move(while_token))
         , left_par(std::move(left_par))
@@ -670,9 +675,9 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance return_token;
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
 
-    explicit ReturnStatement(TokenInstance&& return_token, UniquePtr<IExpression>&& expression)
+    explicit ReturnStatement(TokenInstance&& return_token, ArenaPtr<IExpression>&& expression)
         : return_token(std::move(return_token))
         , expression(std::move(expression))
     {}
@@ -684,9 +689,9 @@ public:
     VISITOR_ACCEPT
 
     TokenInstance break_token;
-    UniquePtr<IExpression> expression;
+    ArenaPtr<IExpression> expression;
 
-    explicit BreakStatement(TokenInstance&& break_token, UniquePtr<IExpression>&& expression)
+    explicit BreakStatement(TokenInstance&& break_token, ArenaPtr<IExpression>&& expression)
         : break_token(std::move(break_token))
         , expression(std::move(expression))
     {}
@@ -709,10 +714,20 @@ class Module : public INode {
 public:
     VISITOR_ACCEPT
 
-    std::vector<UniquePtr<IStatement>> statements;
+    /**
+     * Arena, that holds all nodes of the module. Declared first to be destroyed after them.
+     */
+    UniquePtr<Arena> arena;
+    std::vector<ArenaPtr<IStatement>> statements;
+    /**
+     * Source code of the module. Tokens and identifiers of the module refer to it.
+     */
+    SharedPtr<const Source> source;
 
-    explicit Module(std::vector<UniquePtr<IStatement>>&& statements)
-        : statements(std::move(statements))
+    Module(UniquePtr<Arena>&& arena, std::vector<ArenaPtr<IStatement>>&& statements, SharedPtr<const Source> source = nullptr)
+        : arena(std::move(arena))
+        , statements(std::move(statements))
+        , source(std::move(source))
     {}
 };
 
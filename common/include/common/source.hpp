@@ -0,0 +1,109 @@
+#pragma once
+
+#include <utils/alloc/page.hpp>
+#include <utils/macro.hpp>
+#include <utils/pointers/shared_ptr.hpp>
+#include <utils/strings.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace nlang {
+
+/**
+ * Source code of a module.
+ * Provides UTF-16 code units to the token stream. Source, that is read from a UTF-8 file, is memory-mapped and
+ * decoded lazily, chunk by chunk, as the token stream advances, so first tokens are available before the whole
+ * file is decoded. Decoded code units never move in memory, so tokens and AST nodes may refer to them.
+ */
+class Source final {
+public:
+    /**
+     * Default amount of UTF-8 bytes, decoded at once
+     */
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    Source(const Source&) = delete;
+    Source(Source&&) = delete;
+    Source& operator=(const Source&) = delete;
+    Source& operator=(Source&&) = delete;
+
+    ~Source();
+
+    /**
+     * Creates source from already decoded string
+     * @param text Source code
+     * @return Shared pointer to created source
+     */
+    static SharedPtr<Source> New(UString&& text);
+    static SharedPtr<Source> New(const UString& text) {
+        return New(UString(text));
+    }
+
+    /**
+     * Creates source from UTF-8 file. The file is mapped into memory and is not decoded until requested.
+     * Throws a runtime error if the file can't be opened.
+     * @param path Path to the file
+     * @param chunk_size Amount of UTF-8 bytes, decoded at once
+     * @return Shared pointer to created source
+     */
+    static SharedPtr<Source> FromFile(const std::string& path, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    /**
+     * Returns buffer with decoded code units. Buffer address never changes.
+     * @return Pointer to the first code unit
+     */
+    NLANG_FORCE_INLINE const char16_t* GetBuffer() const {
+        return buffer;
+    }
+
+    /**
+     * Returns amount of already decoded code units
+     * @return Decoded length
+     */
+    NLANG_FORCE_INLINE int32_t GetLength() const {
+        return length;
+    }
+
+    /**
+     * Checks if whole source was decoded
+     * @return True if nothing left to decode, otherwise false
+     */
+    NLANG_FORCE_INLINE bool IsDecoded() const {
+        return decoded == size;
+    }
+
+    /**
+     * Decodes next chunk of the source
+     * @return True if anything was decoded, false if whole source was already decoded
+     */
+    bool DecodeNextChunk();
+
+private:
+    Source() = default;
+
+    void Map(const std::string& path);
+    void Unmap();
+
+private:
+    /// Decoded text of the string source
+    UString text;
+
+    /// UTF-8 data of the file source
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t decoded = 0;
+    size_t chunk_size = DEFAULT_CHUNK_SIZE;
+    void* mapping = nullptr;
+    /// File content on platforms without memory mapping
+    std::string content;
+    /// Pages, that hold decoded file source
+    std::pair<Page::PageIterator, Page::PageIterator> pages;
+
+    const char16_t* buffer = nullptr;
+    int32_t length = 0;
+};
+
+}
\ No newline at end of file
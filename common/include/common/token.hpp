@@ -4,6 +4,11 @@
 #include <utils/strings.hpp>
 
 #include <unordered_map>
+#include <optional>
+#include <string_view>
+#include <array>
+#include <stdexcept>
+#include <algorithm>
 
 namespace nlang {
 
@@ -96,11 +101,35 @@ enum class Token : uint8_t {
  */
 struct TokenInstance {
     Token token;
+    /**
+     * True if there is a line break (newline or line comment) between this and previous significant token
+     */
+    bool preceded_by_newline;
     int32_t pos;
     int32_t length;
     int32_t row;
     int32_t column;
-    UString text;
+    /**
+     * Pointer to the first code unit of the token in the source buffer.
+     * Token does not own its text: the buffer is owned by the Source, that is shared with the parsed module.
+     */
+    const char16_t* source = nullptr;
+
+    /**
+     * Returns view of the token text, pointing right into the source buffer
+     * @return Token text view
+     */
+    std::u16string_view GetTextView() const {
+        return std::u16string_view(source, length);
+    }
+
+    /**
+     * Materializes the token text
+     * @return Copy of the token text
+     */
+    UString GetText() const {
+        return UString(GetTextView());
+    }
 };
 
 /**
@@ -120,27 +149,119 @@ public:
 
     static Token GetTokenByText(const UString& text) {
         NLANG_ASSERT(text);
-        return text_to_token.at(text);
+        if (auto token = FindTokenByText(std::u16string_view(text.getBuffer(), text.GetLength()))) {
+            return *token;
+        }
+        throw std::out_of_range("no token with such text");
+    }
+
+    /**
+     * Looks for keyword or operator token with given text.
+     * Uses compile-time generated perfect hash, so it neither allocates nor throws.
+     * @param text Token text
+     * @return Found token or nullopt if there is no token with such text
+     */
+    static std::optional<Token> FindTokenByText(std::u16string_view text) noexcept {
+        if (text.empty() || text.length() > max_text_length) {
+            return std::nullopt;
+        }
+        const uint8_t index = texts_table.slots[Hash(texts_table.seed, text.data(), text.length())];
+        if (!index) {
+            return std::nullopt;
+        }
+        const TextEntry& entry = text_entries[index - 1];
+        if (entry.text.length() != text.length()) {
+            return std::nullopt;
+        }
+        for (size_t i = 0; i < text.length(); ++i) {
+            if (text[i] != static_cast<char16_t>(entry.text[i])) {
+                return std::nullopt;
+            }
+        }
+        return entry.token;
     }
 
 private:
-    inline static const std::unordered_map<Token, UString> token_to_name {
-#define T(token, value) { Token::token, #token },
+    struct TextEntry {
+        std::string_view text;
+        Token token;
+    };
+
+    struct TextsTable {
+        uint32_t seed;
+        std::array<uint8_t, 256> slots;
+    };
+
+    static constexpr TextEntry text_entries[] {
+#define T(token, value) { value, Token::token },
         TOKENS_LIST
 #undef T
     };
 
-    inline static const std::unordered_map<Token, UString> token_to_text {
-#define T(token, value) { Token::token, value },
+    static constexpr size_t MaxTextLength() {
+        size_t length = 0;
+        for (const auto& entry : text_entries) {
+            length = std::max(length, entry.text.length());
+        }
+        return length;
+    }
+
+    /**
+     * Hashes first, middle and last characters and the length of the text.
+     */
+    template<typename C>
+    static constexpr uint8_t Hash(uint32_t seed, const C* text, size_t length) noexcept {
+        uint32_t h = (static_cast<uint32_t>(text[0]) |
+                      static_cast<uint32_t>(text[length - 1]) << 8u |
+                      static_cast<uint32_t>(text[length / 2]) << 16u |
+                      static_cast<uint32_t>(length) << 24u) ^ seed;
+        h ^= h >> 16u;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13u;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16u;
+        return static_cast<uint8_t>(h);
+    }
+
+    /**
+     * Searches for the seed, that makes the hash collision-free on all token texts
+     */
+    static constexpr TextsTable MakeTextsTable() {
+        for (uint32_t seed = 0; ; ++seed) {
+            TextsTable table { seed, {} };
+            bool collision = false;
+            for (size_t i = 0; i < std::size(text_entries) && !collision; ++i) {
+                const std::string_view text = text_entries[i].text;
+                if (text.empty()) {
+                    continue;
+                }
+                uint8_t& slot = table.slots[Hash(seed, text.data(), text.length())];
+                collision = slot != 0;
+                slot = static_cast<uint8_t>(i + 1);
+            }
+            if (!collision) {
+                return table;
+            }
+        }
+    }
+
+    static const size_t max_text_length;
+    static const TextsTable texts_table;
+
+    inline static const std::unordered_map<Token, UString> token_to_name {
+#define T(token, value) { Token::token, #token },
         TOKENS_LIST
 #undef T
     };
 
-    inline static const std::unordered_map<UString, Token> text_to_token {
-#define T(token, value) { value, Token::token },
+    inline static const std::unordered_map<Token, UString> token_to_text {
+#define T(token, value) { Token::token, value },
         TOKENS_LIST
 #undef T
     };
 };
 
-}
+inline constexpr size_t TokenUtils::max_text_length = TokenUtils::MaxTextLength();
+inline constexpr TokenUtils::TextsTable TokenUtils::texts_table = TokenUtils::MakeTextsTable();
+
+}
\ No newline at end of file
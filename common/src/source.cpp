@@ -0,0 +1,165 @@
+#include <common/source.hpp>
+
+#include <unicode/ustring.h>
+#include <unicode/utf8.h>
+
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(NLANG_PLATFORM_LINUX) || defined(NLANG_PLATFORM_MACOS)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#elif defined(NLANG_PLATFORM_WINDOWS)
+// Sets minimal API level requirement to Windows 7
+#define WINVER 0x0601
+#define _WIN32_WINNT 0x0601
+#include <Windows.h>
+#endif
+
+namespace nlang {
+
+Source::~Source() {
+    Unmap();
+    if (pages.first != pages.second) {
+        Page::FreeRange(pages);
+    }
+}
+
+SharedPtr<Source> Source::New(UString&& text) {
+    SharedPtr<Source> source(new Source());
+    source->text = std::move(text);
+    source->buffer = source->text.getBuffer();
+    source->length = source->text.GetLength();
+    return source;
+}
+
+SharedPtr<Source> Source::FromFile(const std::string& path, size_t chunk_size) {
+    NLANG_ASSERT(chunk_size > 0);
+    SharedPtr<Source> source(new Source());
+    source->chunk_size = chunk_size;
+    source->Map(path);
+
+    // skip byte order mark
+    if (source->size >= 3 && source->data[0] == 0xEF && source->data[1] == 0xBB && source->data[2] == 0xBF) {
+        source->decoded = 3;
+    }
+
+    // UTF-8 sequence never decodes to more code units than it has bytes
+    if (source->size > (size_t)INT32_MAX) {
+        throw std::runtime_error("Source file is too big: " + path);
+    }
+    if (source->size != 0) {
+        const size_t pages_count = (source->size * sizeof(char16_t) + Page::size() - 1) / Page::size();
+        source->pages = Page::AllocateRange(pages_count);
+        source->buffer = static_cast<const char16_t*>(source->pages.first->data());
+    }
+    return source;
+}
+
+bool Source::DecodeNextChunk() {
+    if (IsDecoded()) {
+        return false;
+    }
+
+    size_t end = std::min(size, decoded + chunk_size);
+    // do not split multibyte sequences between chunks
+    while (end > decoded && end < size && U8_IS_TRAIL(data[end])) {
+        --end;
+    }
+    if (end == decoded) {
+        end = std::min(size, decoded + chunk_size);
+    }
+
+    int32_t written = 0;
+    UErrorCode status = U_ZERO_ERROR;
+    char16_t* const decoded_buffer = static_cast<char16_t*>(pages.first->data());
+    u_strFromUTF8WithSub(decoded_buffer + length, (int32_t)(size - length), &written,
+                         reinterpret_cast<const char*>(data + decoded), (int32_t)(end - decoded),
+                         0xFFFD, nullptr, &status);
+    if (U_FAILURE(status)) {
+        throw std::runtime_error(std::string("Can't decode source: ") + u_errorName(status));
+    }
+
+    length += written;
+    decoded = end;
+    return true;
+}
+
+void Source::Map(const std::string& path) {
+#if defined(NLANG_PLATFORM_LINUX) || defined(NLANG_PLATFORM_MACOS)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Can't open source file: " + path);
+    }
+    struct stat info {};
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        throw std::runtime_error("Can't open source file: " + path);
+    }
+    size = (size_t)info.st_size;
+    if (size != 0) {
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            close(fd);
+            throw std::runtime_error("Can't map source file: " + path);
+        }
+        // file is read sequentially
+        madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    data = static_cast<const uint8_t*>(mapping);
+#elif defined(NLANG_PLATFORM_WINDOWS)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Can't open source file: " + path);
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        throw std::runtime_error("Can't open source file: " + path);
+    }
+    size = (size_t)file_size.QuadPart;
+    if (size != 0) {
+        HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (file_mapping) {
+            mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(file_mapping);
+        }
+        if (!mapping) {
+            CloseHandle(file);
+            throw std::runtime_error("Can't map source file: " + path);
+        }
+    }
+    CloseHandle(file);
+    data = static_cast<const uint8_t*>(mapping);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Can't open source file: " + path);
+    }
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    size = content.size();
+    data = reinterpret_cast<const uint8_t*>(content.data());
+#endif
+}
+
+void Source::Unmap() {
+    if (!mapping) {
+        return;
+    }
+#if defined(NLANG_PLATFORM_LINUX) || defined(NLANG_PLATFORM_MACOS)
+    munmap(mapping, size);
+#elif defined(NLANG_PLATFORM_WINDOWS)
+    UnmapViewOfFile(mapping);
+#endif
+    mapping = nullptr;
+}
+
+}
\ No newline at end of file
@@ -3,10 +3,14 @@
 #include <interpreter/handle.hpp>
 #include <interpreter/value.hpp>
 
+#include <utils/macro.hpp>
 #include <utils/strings.hpp>
 #include <utils/pointers.hpp>
 
 #include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <vector>
 #include <type_traits>
 #include <unordered_map>
@@ -23,7 +27,6 @@ using Offset = int32_t ;
 using Register = int32_t;
 using ConstantIndex = int32_t;
 using ImmediateInt32 = int32_t;
-using ImmediateDouble = double;
 using NoOperand = std::nullptr_t;
 
 /**
@@ -34,6 +37,14 @@ struct RegistersRange {
     int32_t count;
 };
 
+/**
+ * Represents conditional jump, which compares the accumulator with a register
+ */
+struct RegisterJump {
+    Register reg;
+    Offset offset;
+};
+
 /**
  * Represents context
  */
@@ -42,50 +53,119 @@ struct ContextDescriptor {
     int32_t depth;
 };
 
+/**
+ * List of all opcodes with their operand types.
+ * Expands O(opcode, OperandType) for each opcode, is used to generate opcode tables (e.g. dispatch table of the VM).
+ * Opcodes with Number suffix are not emitted by the compiler: the executor rewrites generic arithmetic and comparison
+ * instructions to them, when it sees numeric operands (quickening), and back, when it sees other ones.
+ * JumpIfXxx opcodes with RegisterJump operand compare the accumulator with the register and jump, if the result is as
+ * named, without materializing the Bool in the accumulator.
+ * Wide is a prefix of an instruction, which scalar operands don't fit in 1 byte (see EncodeInstruction).
+ * LoadNumber loads integer immediate, other numbers are loaded from the constant pool.
+ * TailCall calls the closure in the accumulator and returns its result, so it ends the function like Return.
+ */
+#define OPCODES                                   \
+                                                  \
+O(NoOperation,               NoOperand)           \
+O(Wide,                      NoOperand)           \
+                                                  \
+O(LoadRegister,              Register)            \
+O(StoreRegister,             Register)            \
+                                                  \
+O(Add,                       Register)            \
+O(Sub,                       Register)            \
+O(Mul,                       Register)            \
+O(Div,                       Register)            \
+                                                  \
+O(DeclareContext,            ContextDescriptor)   \
+O(LoadContext,               ContextDescriptor)   \
+O(StoreContext,              ContextDescriptor)   \
+                                                  \
+O(LoadConstant,              ConstantIndex)       \
+                                                  \
+O(Call,                      RegistersRange)      \
+O(TailCall,                  RegistersRange)      \
+                                                  \
+O(Jump,                      Offset)              \
+O(JumpIfTrue,                Offset)              \
+O(JumpIfFalse,               Offset)              \
+O(JumpIfEqual,               RegisterJump)        \
+O(JumpIfNotEqual,            RegisterJump)        \
+O(JumpIfLess,                RegisterJump)        \
+O(JumpIfGreater,             RegisterJump)        \
+O(JumpIfLessOrEqual,         RegisterJump)        \
+O(JumpIfGreaterOrEqual,      RegisterJump)        \
+O(JumpIfNotLess,             RegisterJump)        \
+O(JumpIfNotGreater,          RegisterJump)        \
+O(JumpIfNotLessOrEqual,      RegisterJump)        \
+O(JumpIfNotGreaterOrEqual,   RegisterJump)        \
+                                                  \
+O(CheckEqual,                Register)            \
+O(CheckNotEqual,             Register)            \
+O(CheckLess,                 Register)            \
+O(CheckGreater,              Register)            \
+O(CheckLessOrEqual,          Register)            \
+O(CheckGreaterOrEqual,       Register)            \
+O(CheckTypeEqual,            Register)            \
+                                                  \
+O(AddNumber,                 Register)            \
+O(SubNumber,                 Register)            \
+O(MulNumber,                 Register)            \
+O(DivNumber,                 Register)            \
+O(CheckEqualNumber,          Register)            \
+O(CheckNotEqualNumber,       Register)            \
+O(CheckLessNumber,           Register)            \
+O(CheckGreaterNumber,        Register)            \
+O(CheckLessOrEqualNumber,    Register)            \
+O(CheckGreaterOrEqualNumber, Register)            \
+                                                  \
+O(PushContext,               ImmediateInt32)      \
+                                                  \
+O(LoadNumber,                ImmediateInt32)      \
+                                                  \
+O(PopContext,                NoOperand)           \
+O(CreateClosure,             NoOperand)           \
+O(Return,                    NoOperand)           \
+                                                  \
+O(LoadNull,                  NoOperand)           \
+O(LoadTrue,                  NoOperand)           \
+O(LoadFalse,                 NoOperand)           \
 
-#define OPCODES                                \
-                                               \
-O(NoOperation,         NoOperand)              \
-                                               \
-O(LoadRegister,        Register)               \
-O(StoreRegister,       Register)               \
-                                               \
-O(Add,                 Register)               \
-O(Sub,                 Register)               \
-O(Mul,                 Register)               \
-O(Div,                 Register)               \
-                                               \
-O(DeclareContext,      ContextDescriptor)      \
-O(LoadContext,         ContextDescriptor)      \
-O(StoreContext,        ContextDescriptor)      \
-                                               \
-O(LoadConstant,        ConstantIndex)          \
-                                               \
-O(Call,                RegistersRange)         \
-                                               \
-O(Jump,                Offset)                 \
-O(JumpIfTrue,          Offset)                 \
-O(JumpIfFalse,         Offset)                 \
-                                               \
-O(CheckEqual,          Register)               \
-O(CheckNotEqual,       Register)               \
-O(CheckLess,           Register)               \
-O(CheckGreater,        Register)               \
-O(CheckLessOrEqual,    Register)               \
-O(CheckGreaterOrEqual, Register)               \
-O(CheckTypeEqual,      Register)               \
-                                               \
-O(PushContext,         ImmediateInt32)         \
-                                               \
-O(LoadNumber,          ImmediateDouble)        \
-                                               \
-O(PopContext,          NoOperand)              \
-O(CreateClosure,       NoOperand)              \
-O(Return,              NoOperand)              \
-                                               \
-O(LoadNull,            NoOperand)              \
-O(LoadTrue,            NoOperand)              \
-O(LoadFalse,           NoOperand)              \
+/**
+ * Kind of the registers, which the operand refers to
+ */
+enum class RegisterOperand : uint8_t {
+    None,
+    /** First scalar is a register */
+    Register,
+    /** Scalars are the first register and the count of consecutive registers */
+    Range,
+};
+
+/**
+ * Describes how the operand is encoded: scalars (registers, counts, indices and immediates) go first, then the jump
+ * offset, if any
+ */
+struct OperandFormat {
+    int32_t scalars;
+    bool offset;
+    RegisterOperand registers;
+};
+
+/**
+ * Formats of the operand types, named as the types (which are aliases of the same integer type, so they can't be told
+ * apart by templates)
+ */
+namespace formats {
+inline constexpr OperandFormat NoOperand { 0, false, RegisterOperand::None };
+inline constexpr OperandFormat Register { 1, false, RegisterOperand::Register };
+inline constexpr OperandFormat ConstantIndex { 1, false, RegisterOperand::None };
+inline constexpr OperandFormat ImmediateInt32 { 1, false, RegisterOperand::None };
+inline constexpr OperandFormat RegistersRange { 2, false, RegisterOperand::Range };
+inline constexpr OperandFormat ContextDescriptor { 2, false, RegisterOperand::None };
+inline constexpr OperandFormat Offset { 0, true, RegisterOperand::None };
+inline constexpr OperandFormat RegisterJump { 1, true, RegisterOperand::Register };
+}
 
 /**
  * Contains all opcode values, that are used by compiler and VM.
@@ -99,18 +179,28 @@ OPCODES
 template<Opcode opcode>
 struct OpcodeTraits {};
 
-#define O(op, OpType)                       \
-template<>                                  \
-struct OpcodeTraits<Opcode::op> {           \
-    using OperandType = OpType;             \
+#define O(op, OpType)                                               \
+template<>                                                          \
+struct OpcodeTraits<Opcode::op> {                                   \
+    using OperandType = OpType;                                     \
+    static constexpr OperandFormat format = formats::OpType;        \
 };
 OPCODES
 #undef O
 
+/**
+ * Table of operand formats, indexed by opcode
+ */
+inline constexpr OperandFormat operand_formats[] = {
+#define O(op, OpType) formats::OpType,
+OPCODES
+#undef O
+};
 
 /**
- * Represents bytecode instruction.
- * Contains instruction opcode and the operand.
+ * Represents decoded bytecode instruction.
+ * Contains instruction opcode and the operand. Every operand is a sequence of int32_t fields in the order, described
+ * by OperandFormat.
  */
 struct Instruction {
     Opcode opcode;
@@ -120,18 +210,156 @@ struct Instruction {
         RegistersRange reg_range;
         ConstantIndex const_index;
         ContextDescriptor context_descriptor;
+        RegisterJump register_jump;
         ImmediateInt32 immediate_int32;
-        ImmediateDouble immediate_double;
+        int32_t fields[2];
     };
 };
 
+/**
+ * Size of the scalar operand field of the instruction without and with Wide prefix
+ */
+inline constexpr size_t NARROW_SCALAR_SIZE = sizeof(int8_t);
+inline constexpr size_t WIDE_SCALAR_SIZE = sizeof(int32_t);
+
+/**
+ * Checks whether the number can be loaded with LoadNumber immediate (integer, not -0)
+ * @param number The number
+ * @return Whether the number is representable as int32_t
+ */
+inline bool IsImmediateInt32(double number) {
+    return number >= std::numeric_limits<int32_t>::min() && number <= std::numeric_limits<int32_t>::max() &&
+           number == static_cast<int32_t>(number) && !(number == 0 && std::signbit(number));
+}
+
+template<typename T>
+NLANG_FORCE_INLINE T ReadOperand(const uint8_t* code) {
+    T value;
+    std::memcpy(&value, code, sizeof(T));
+    return value;
+}
+
+template<typename T>
+NLANG_FORCE_INLINE void WriteOperand(uint8_t* code, T value) {
+    std::memcpy(code, &value, sizeof(T));
+}
+
+/**
+ * Encodes instruction to the end of the byte stream.
+ * Opcode takes 1 byte, scalar operands take 1 byte each, jump offset takes 4 bytes. If any scalar doesn't fit in
+ * 1 byte, the instruction is prefixed with Wide and all its scalars take 4 bytes. Offsets are always 4 bytes, so
+ * forward jumps can be patched after emission. Offset is relative to the end of the jump instruction.
+ * @param instruction The instruction
+ * @param code The byte stream
+ */
+inline void EncodeInstruction(const Instruction& instruction, std::vector<uint8_t>& code) {
+    const OperandFormat format = operand_formats[static_cast<uint8_t>(instruction.opcode)];
+    bool wide = false;
+    for (int32_t i = 0; i < format.scalars; ++i) {
+        wide |= instruction.fields[i] < std::numeric_limits<int8_t>::min() ||
+                instruction.fields[i] > std::numeric_limits<int8_t>::max();
+    }
+
+    if (wide) {
+        code.push_back(static_cast<uint8_t>(Opcode::Wide));
+    }
+    code.push_back(static_cast<uint8_t>(instruction.opcode));
+    for (int32_t i = 0; i < format.scalars; ++i) {
+        if (wide) {
+            code.resize(code.size() + WIDE_SCALAR_SIZE);
+            WriteOperand<int32_t>(code.data() + code.size() - WIDE_SCALAR_SIZE, instruction.fields[i]);
+        } else {
+            code.push_back(static_cast<uint8_t>(static_cast<int8_t>(instruction.fields[i])));
+        }
+    }
+    if (format.offset) {
+        code.resize(code.size() + sizeof(Offset));
+        WriteOperand<Offset>(code.data() + code.size() - sizeof(Offset), instruction.fields[format.scalars]);
+    }
+}
+
+/**
+ * Decodes instruction, that starts at the given position of the byte stream
+ * @param code Pointer to the first byte of the instruction (Wide prefix, if any)
+ * @param instruction Decoded instruction
+ * @return Size of the encoded instruction in bytes
+ */
+inline size_t DecodeInstruction(const uint8_t* code, Instruction& instruction) {
+    const bool wide = code[0] == static_cast<uint8_t>(Opcode::Wide);
+    const uint8_t* current = code + wide;
+    instruction = {};
+    instruction.opcode = static_cast<Opcode>(*current++);
+    const OperandFormat format = operand_formats[static_cast<uint8_t>(instruction.opcode)];
+    for (int32_t i = 0; i < format.scalars; ++i) {
+        if (wide) {
+            instruction.fields[i] = ReadOperand<int32_t>(current);
+            current += WIDE_SCALAR_SIZE;
+        } else {
+            instruction.fields[i] = static_cast<int8_t>(*current);
+            current += NARROW_SCALAR_SIZE;
+        }
+    }
+    if (format.offset) {
+        instruction.fields[format.scalars] = ReadOperand<Offset>(current);
+        current += sizeof(Offset);
+    }
+    return current - code;
+}
+
+/**
+ * Returns size of the encoded instruction
+ * @param format Operand format of the instruction
+ * @param wide Whether instruction is prefixed with Wide
+ * @return Size in bytes, including the prefix
+ */
+constexpr size_t GetInstructionSize(OperandFormat format, bool wide) {
+    return wide + 1 + format.scalars * (wide ? WIDE_SCALAR_SIZE : NARROW_SCALAR_SIZE) +
+            (format.offset ? sizeof(Offset) : 0);
+}
+
+/**
+ * Reads operand fields of the instruction without Wide prefix. Is used by the executor, where opcode is known at
+ * compile time, so it compiles to a couple of loads.
+ * @tparam opcode Opcode of the instruction
+ * @param code Pointer to the opcode
+ * @param operand0 First field of the operand
+ * @param operand1 Second field of the operand
+ */
+template<Opcode opcode>
+NLANG_FORCE_INLINE void ReadNarrowOperands(const uint8_t* code, int32_t& operand0, int32_t& operand1) {
+    constexpr OperandFormat format = OpcodeTraits<opcode>::format;
+    if constexpr (format.scalars > 0) {
+        operand0 = static_cast<int8_t>(code[1]);
+    }
+    if constexpr (format.scalars > 1) {
+        operand1 = static_cast<int8_t>(code[2]);
+    }
+    if constexpr (format.offset) {
+        (format.scalars == 0 ? operand0 : operand1) = ReadOperand<Offset>(code + 1 + format.scalars);
+    }
+}
+
+/**
+ * Decodes all the instructions of the byte stream
+ * @param code The byte stream
+ * @return Decoded instructions
+ */
+inline std::vector<Instruction> DecodeInstructions(const std::vector<uint8_t>& code) {
+    std::vector<Instruction> instructions;
+    for (size_t position = 0; position < code.size();) {
+        instructions.emplace_back();
+        position += DecodeInstruction(code.data() + position, instructions.back());
+    }
+    return instructions;
+}
+
 /**
  * Represents bytecode sequence with constant pool and agument & register use info.
  */
 struct BytecodeChunk {
     int32_t arguments_count;
     int32_t registers_count;
-    std::vector<Instruction> bytecode;
+    std::vector<uint8_t> bytecode;
     std::vector<Handle<Value>> constant_pool;
 };
 
@@ -146,8 +374,9 @@ public:
     }
 
     Label EmitInstruction(const Instruction& instruction) {
-        chunk.bytecode.push_back(instruction);
-        return chunk.bytecode.size() - 1;
+        last_label = GetLabel();
+        EncodeInstruction(instruction, chunk.bytecode);
+        return last_label;
     }
 
     template<Opcode opcode>
@@ -168,14 +397,8 @@ public:
             instruction.context_descriptor = operand;
         } else if constexpr (std::is_same_v<Operand, RegistersRange>) {
             instruction.reg_range = operand;
-        } else if constexpr (std::is_same_v<Operand, Offset>) {
-            instruction.offset = operand;
-        } else if constexpr (std::is_same_v<Operand, ConstantIndex>) {
-            instruction.const_index = operand;
-        } else if constexpr (std::is_same_v<Operand, ImmediateDouble>) {
-            instruction.immediate_double = operand;
-        } else if constexpr (std::is_same_v<Operand, ImmediateInt32>) {
-            instruction.immediate_int32 = operand;
+        } else if constexpr (std::is_same_v<Operand, RegisterJump>) {
+            instruction.register_jump = operand;
         }
         return EmitInstruction(instruction);
     }
@@ -189,11 +412,30 @@ public:
 
         Instruction instruction {};
         instruction.opcode = jump_opcode;
-        instruction.offset = to - chunk.bytecode.size();
+        const JumpLabel jump_label = EmitInstruction(instruction);
+        UpdateJump(jump_label, to);
 
-        EmitInstruction(instruction);
+        return jump_label;
+    }
+
+    /**
+     * Emits jump, which compares the accumulator with the register
+     * @tparam jump_opcode Opcode with RegisterJump operand
+     * @param reg Register to compare with
+     * @param to Jump destination, may be updated later
+     * @return Label of the jump
+     */
+    template<Opcode jump_opcode>
+    JumpLabel EmitRegisterJump(Register reg, Label to = 0) {
+        static_assert(std::is_same_v<typename OpcodeTraits<jump_opcode>::OperandType, RegisterJump>);
 
-        return chunk.bytecode.size() - 1;
+        Instruction instruction {};
+        instruction.opcode = jump_opcode;
+        instruction.register_jump = { reg, 0 };
+        const JumpLabel jump_label = EmitInstruction(instruction);
+        UpdateJump(jump_label, to);
+
+        return jump_label;
     }
 
     void UpdateJumpToHere(JumpLabel jump_label) {
@@ -201,7 +443,13 @@ public:
     }
 
     void UpdateJump(JumpLabel jump_label, Label to) {
-        chunk.bytecode[jump_label].offset = to - jump_label;
+        // offset is the last field of the jump, patched in place, so it doesn't change size of the code
+        uint8_t* jump = chunk.bytecode.data() + jump_label;
+        const bool wide = jump[0] == static_cast<uint8_t>(Opcode::Wide);
+        const OperandFormat format = operand_formats[jump[wide]];
+        NLANG_ASSERT(format.offset);
+        const Label end = jump_label + GetInstructionSize(format, wide);
+        WriteOperand<Offset>(chunk.bytecode.data() + end - sizeof(Offset), to - end);
     }
 
     int32_t StoreConstant(Handle<Value> constant) {
@@ -218,18 +466,20 @@ public:
     }
 
     int32_t GetLastEmmittedInstructionAddress() const {
-        return chunk.bytecode.size() - 1;
+        return last_label;
     }
 
     BytecodeChunk Flush() {
         chunk.bytecode.shrink_to_fit();
         BytecodeChunk old_chunk;
         std::swap(chunk, old_chunk);
+        last_label = -1;
         return old_chunk;
     }
 
 private:
     BytecodeChunk chunk;
+    Label last_label = -1;
 };
 
 /**
@@ -246,55 +496,35 @@ public:
      */
     static UString Disassemble(BytecodeChunk& bytecode_chunk) {
         UString result = "arguments: " + std::to_string(bytecode_chunk.arguments_count) + " registers: " + std::to_string(bytecode_chunk.registers_count) + "\n";
-        for (auto& i : bytecode_chunk.bytecode) {
-            result += "\n" + names[i.opcode] + " " + printers[i.opcode](i);
+        for (auto& i : DecodeInstructions(bytecode_chunk.bytecode)) {
+            result += "\n" + names[i.opcode] + " " + PrintOperand(i);
         }
         return result;
     }
 
 private:
     /**
-     * Selects function that will be used to get text representation of an operand
-     * @tparam Operand Operand type
-     * @return Lambda object with selected function
+     * Returns text representation of the operand: its fields, separated by spaces
+     * @param instruction The instruction
+     * @return Text representation of the operand
      */
-    template<typename Operand>
-    static std::function<UString(Instruction)> GetPrinter() {
-        if constexpr (std::is_same_v<Operand, Register>) {
-            return [](Instruction instruction) -> UString { return std::to_string(instruction.reg); };
-        } else if constexpr (std::is_same_v<Operand, ContextDescriptor>) {
-            return [](Instruction instruction) -> UString { return std::to_string(instruction.context_descriptor.index) + " " + std::to_string(instruction.context_descriptor.depth); };
-        } else if constexpr (std::is_same_v<Operand, RegistersRange>) {
-            return [](Instruction instruction) -> UString { return std::to_string(instruction.reg_range.first) + " " + std::to_string(instruction.reg_range.count); };
-        } else if constexpr (std::is_same_v<Operand, Offset>) {
-            return [](Instruction instruction) -> UString { return std::to_string(instruction.offset); };
-        } else if constexpr (std::is_same_v<Operand, ConstantIndex>) {
-            return [](Instruction instruction) -> UString { return std::to_string(instruction.const_index); };
-        } else if constexpr (std::is_same_v<Operand, ImmediateDouble>) {
-            return [](Instruction instruction) -> UString { return std::to_string(instruction.immediate_double); };
-        } else if constexpr (std::is_same_v<Operand, ImmediateInt32>) {
-            return [](Instruction instruction) -> UString { return std::to_string(instruction.immediate_int32); };
-        } else if constexpr (std::is_same_v<Operand, NoOperand>) {
-            return [](Instruction instruction) -> UString { return ""; };
+    static UString PrintOperand(const Instruction& instruction) {
+        const OperandFormat format = operand_formats[static_cast<uint8_t>(instruction.opcode)];
+        std::string result;
+        for (int32_t i = 0; i < format.scalars + format.offset; ++i) {
+            result += (i ? " " : "") + std::to_string(instruction.fields[i]);
         }
-        throw;
+        return result;
     }
+
     /**
      * Maps opcodes values from enum to its text representation
      */
     static inline std::unordered_map<Opcode, UString> names {
 #define O(op, OpType) { Opcode::op, #op },
         OPCODES
-#undef O
-    };
-
-    static inline std::unordered_map<Opcode, std::function<UString(Instruction)>> printers {
-#define O(op, OpType) { Opcode::op, GetPrinter<typename OpcodeTraits<Opcode::op>::OperandType>() },
-        OPCODES
 #undef O
     };
 };
 
-#undef OPCODES
-
 }
\ No newline at end of file
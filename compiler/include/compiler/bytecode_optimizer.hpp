@@ -0,0 +1,165 @@
+#pragma once
+
+#include <compiler/bytecode.hpp>
+
+#include <utils/pointers/unique_ptr.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace nlang::bytecode {
+
+/**
+ * Decoded instruction of the chunk being optimized
+ */
+struct OptimizedInstruction {
+    Instruction instruction;
+    /** Index of the jump destination, -1 if the instruction isn't a jump */
+    int32_t target;
+    /** Whether any jump leads to the instruction */
+    bool is_target;
+    /** Whether the instruction is removed by the pass, removed instructions are erased after each pass */
+    bool removed;
+};
+
+/**
+ * Decodes the bytecode, resolving jump offsets to indices of the destinations
+ * @param code The bytecode
+ * @return Decoded instructions
+ */
+std::vector<OptimizedInstruction> DecodeForOptimization(const std::vector<uint8_t>& code);
+
+/**
+ * Encodes the instructions, laying out the jump offsets by the destinations
+ * @param instructions The instructions without removed ones, their offsets are updated
+ * @return The bytecode
+ */
+std::vector<uint8_t> EncodeOptimized(std::vector<OptimizedInstruction>& instructions);
+
+/**
+ * Returns indices of the instructions, which may be executed right after the given one
+ * @param instructions The instructions
+ * @param index Index of the instruction
+ * @param successors Indices of the successors
+ */
+void GetSuccessors(const std::vector<OptimizedInstruction>& instructions, size_t index, std::vector<size_t>& successors);
+
+/**
+ * Computes registers, which are live (may be read before they are stored) at the entry of each instruction
+ * @param instructions The instructions
+ * @param arguments_count Count of arguments (negative registers)
+ * @param registers_count Count of registers
+ * @return Flags of the registers for each instruction, register r has index r + arguments_count
+ */
+std::vector<std::vector<bool>> ComputeLiveness(const std::vector<OptimizedInstruction>& instructions,
+                                               int32_t arguments_count,
+                                               int32_t registers_count);
+
+/**
+ * Optimization pass over the decoded instructions
+ */
+class IBytecodePass {
+public:
+    virtual ~IBytecodePass() = default;
+
+    /**
+     * @return Name of the pass, which is used in the statistics
+     */
+    virtual const char* GetName() const = 0;
+
+    /**
+     * Runs the pass. Pass changes instructions in place or marks them removed, jumps to a removed instruction lead to
+     * the next one. Pass may add constants to the chunk.
+     * @param instructions The instructions, jump destinations and flags are up to date
+     * @param chunk The chunk, whose bytecode is being optimized
+     * @return Number of changes, 0 if nothing is changed
+     */
+    virtual size_t Run(std::vector<OptimizedInstruction>& instructions, BytecodeChunk& chunk) = 0;
+};
+
+/**
+ * Peephole optimizer of the flushed bytecode chunks.
+ * Decodes the bytecode, resolving jump offsets to instructions, runs the pipeline of passes until none of them changes
+ * anything and encodes the bytecode back with the new jump offsets.
+ */
+class BytecodeOptimizer {
+public:
+    /**
+     * Flags of the built-in passes
+     */
+    struct Options {
+        /** Folds arithmetic and comparison of two LoadNumber immediates */
+        bool fold_constants = true;
+        /** Removes loads of the value, which is already in the accumulator, overwritten loads and dead stores */
+        bool eliminate_redundant_loads_stores = true;
+        /** Retargets jumps to unconditional jumps and removes jumps to the next instruction */
+        bool thread_jumps = true;
+        /** Removes unreachable instructions (e.g. after Return or Jump) */
+        bool eliminate_dead_code = true;
+    };
+
+    /**
+     * Statistics of the pass
+     */
+    struct PassStats {
+        std::string name;
+        /** Total number of changes, made by the pass */
+        size_t changes;
+    };
+
+    /**
+     * Creates optimizer with all the built-in passes
+     */
+    BytecodeOptimizer();
+
+    /**
+     * Creates optimizer with the enabled built-in passes
+     * @param options Flags of the passes
+     */
+    explicit BytecodeOptimizer(const Options& options);
+
+    BytecodeOptimizer(const BytecodeOptimizer&) = delete;
+    BytecodeOptimizer(BytecodeOptimizer&&) = default;
+    BytecodeOptimizer& operator=(const BytecodeOptimizer&) = delete;
+    BytecodeOptimizer& operator=(BytecodeOptimizer&&) = default;
+
+    /**
+     * Adds the pass to the end of the pipeline
+     * @param pass The pass
+     */
+    void AddPass(UniquePtr<IBytecodePass> pass);
+
+    /**
+     * Optimizes bytecode of the chunk in place
+     * @param chunk The chunk
+     */
+    void Optimize(BytecodeChunk& chunk);
+
+    /**
+     * @return Statistics of the passes in order of the pipeline
+     */
+    std::vector<PassStats> GetStats() const;
+
+    /**
+     * Returns number of changes, made by the pass
+     * @param name Name of the pass
+     * @return Number of changes, 0 if there is no such pass
+     */
+    size_t GetChanges(const std::string& name) const;
+
+    static constexpr const char* CONSTANT_FOLDING = "constant folding";
+    static constexpr const char* REDUNDANT_LOAD_STORE_ELIMINATION = "redundant load/store elimination";
+    static constexpr const char* JUMP_THREADING = "jump threading";
+    static constexpr const char* DEAD_CODE_ELIMINATION = "dead code elimination";
+
+private:
+    struct Pass {
+        UniquePtr<IBytecodePass> pass;
+        size_t changes;
+    };
+
+    std::vector<Pass> passes;
+};
+
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/ast.hpp>
+#include <compiler/bytecode_optimizer.hpp>
 #include <compiler/scope.hpp>
 
 #include <interpreter/bytecode_function.hpp>
@@ -8,6 +9,7 @@
 #include <utils/pointers/shared_ptr.hpp>
 #include <utils/macro.hpp>
 
+#include <cstdint>
 #include <deque>
 
 namespace nlang {
@@ -18,19 +20,37 @@ namespace nlang {
  */
 class Compiler : public ast::IASTVisitor {
 public:
+    /**
+     * Creates compiler
+     * @param optimizer_options Passes of the optimizer, which runs over each compiled function
+     */
+    explicit Compiler(const bytecode::BytecodeOptimizer::Options& optimizer_options = {})
+        : optimizer(optimizer_options)
+    {}
+
     /**
      * Compiles the passed AST vertex to bytecode and creates an internal function instance for it.
      * @param heap_ Heap to use while compiling
      * @param module AST tree vertex (module)
-     * @return Function, created from compiled AST
+     * @return Function, created from compiled AST, it is a persistent root of the heap, until it is passed to
+     * Heap::RemoveRoot
      */
     Handle<Function> Compile(Heap* heap_, ast::Module& module) {
         heap = heap_;
         module.Accept(*this);
         NLANG_ASSERT(scope_stack.empty());
+        // functions of the module are in its constant pools, so they live as long as the module function is a root
+        heap->AddRoot(result);
         return result;
     }
 
+    /**
+     * @return Statistics of the optimizer passes over all the compiled functions
+     */
+    std::vector<bytecode::BytecodeOptimizer::PassStats> GetOptimizerStats() const {
+        return optimizer.GetStats();
+    }
+
 private:
     void Visit(ast::INode& node) override {
         throw;
@@ -57,7 +77,14 @@ private:
     }
 
     void Visit(ast::NumberLiteral& literal) override {
-        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::LoadNumber>(literal.number);
+        // integers are encoded in the instruction, other numbers go to the constant pool
+        const double number = literal.number;
+        if (bytecode::IsImmediateInt32(number)) {
+            GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::LoadNumber>(static_cast<int32_t>(number));
+        } else {
+            auto index = GetScope()->GetBytecodeGenerator()->StoreConstant(Number::New(number));
+            GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::LoadConstant>(index);
+        }
     }
 
     void Visit(ast::StringLiteral& literal) override {
@@ -137,59 +164,52 @@ private:
             return;
         }
 
-        expression.left->Accept(*this);
-        auto left = GetScope()->GetRegistersShape()->LockRegisters(1);
-        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(left.first);
-        expression.right->Accept(*this);
-        auto right = GetScope()->GetRegistersShape()->LockRegisters(1);
-        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(right.first);
-        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::LoadRegister>(left.first);
-        GetScope()->GetRegistersShape()->ReleaseRegisters(left);
-        switch (expression.op.token) {
+        auto operands = CompileOperands(expression);
+        const Token token = operands.swapped ? SwapOperands(expression.op.token) : expression.op.token;
+        switch (token) {
             case Token::ADD: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Add>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Add>(operands.reg);
                 break;
             }
             case Token::SUB: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Sub>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Sub>(operands.reg);
                 break;
             }
             case Token::MUL: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Mul>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Mul>(operands.reg);
                 break;
             }
             case Token::DIV: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Div>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Div>(operands.reg);
                 break;
             }
             case Token::EQUALS: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckEqual>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckEqual>(operands.reg);
                 break;
             }
             case Token::NOT_EQUALS: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckNotEqual>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckNotEqual>(operands.reg);
                 break;
             }
             case Token::GREATER: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckGreater>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckGreater>(operands.reg);
                 break;
             }
             case Token::GREATER_EQUALS: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckGreaterOrEqual>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckGreaterOrEqual>(operands.reg);
                 break;
             }
             case Token::LESS: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckLess>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckLess>(operands.reg);
                 break;
             }
             case Token::LESS_EQUALS: {
-                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckLessOrEqual>(right.first);
+                GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::CheckLessOrEqual>(operands.reg);
                 break;
             }
             default:
                 throw;
         }
-        GetScope()->GetRegistersShape()->ReleaseRegisters(right);
     }
 
     void Visit(ast::OperatorDefinitionExpression& expression) override {
@@ -220,18 +240,7 @@ private:
     }
 
     void Visit(ast::FunctionCallExpression& expression) override {
-        expression.expression->Accept(*this);
-        auto f = GetScope()->GetRegistersShape()->LockRegisters(1);
-        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(f.first);
-        auto args = GetScope()->GetRegistersShape()->LockRegisters(expression.arguments.size());
-        for (int32_t i = 0; i < expression.arguments.size(); ++i) {
-            expression.arguments[i]->Accept(*this);
-            GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(args.first + i);
-        }
-        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::LoadRegister>(f.first);
-        GetScope()->GetRegistersShape()->ReleaseRegisters(f);
-        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::Call>(args);
-        GetScope()->GetRegistersShape()->ReleaseRegisters(args);
+        CompileCall<bytecode::Opcode::Call>(expression);
     }
 
     void Visit(ast::SubscriptExpression& expression) override {
@@ -266,7 +275,7 @@ private:
         auto context = GetScope();
         PopScope();
 
-        auto f = BytecodeFunction::New(heap, context->GetBytecodeGenerator()->Flush());
+        auto f = BytecodeFunction::New(heap, Flush(*context));
         auto f_index = GetScope()->GetBytecodeGenerator()->StoreConstant(f);
 
         GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::LoadConstant>(f_index);
@@ -323,9 +332,7 @@ private:
     }
 
     void Visit(ast::IfElseStatement& statement) override {
-        statement.condition->Accept(*this);
-
-        auto if_false_label = GetScope()->GetBytecodeGenerator()->EmitJump<bytecode::Opcode::JumpIfFalse>(0);
+        auto if_false_label = EmitConditionalJump(*statement.condition, false);
 
         statement.body->Accept(*this);
 
@@ -342,15 +349,21 @@ private:
     }
 
     void Visit(ast::WhileStatement& statement) override {
-        bytecode::Label first_while_instruction = GetScope()->GetBytecodeGenerator()->GetLabel();
-        statement.condition->Accept(*this);
-        auto if_false_label = GetScope()->GetBytecodeGenerator()->EmitJump<bytecode::Opcode::JumpIfFalse>(0);
+        // condition is placed after the body, so the back edge is the single conditional jump
+        auto condition_jump = GetScope()->GetBytecodeGenerator()->EmitJump<bytecode::Opcode::Jump>(0);
+        bytecode::Label first_body_instruction = GetScope()->GetBytecodeGenerator()->GetLabel();
         statement.body->Accept(*this);
-        GetScope()->GetBytecodeGenerator()->EmitJump<bytecode::Opcode::Jump>(first_while_instruction);
-        GetScope()->GetBytecodeGenerator()->UpdateJumpToHere(if_false_label);
+        GetScope()->GetBytecodeGenerator()->UpdateJumpToHere(condition_jump);
+        auto if_true_label = EmitConditionalJump(*statement.condition, true);
+        GetScope()->GetBytecodeGenerator()->UpdateJump(if_true_label, first_body_instruction);
     }
 
     void Visit(ast::ReturnStatement& statement) override {
+        if (auto call = dynamic_cast<ast::FunctionCallExpression*>(statement.expression.get())) {
+            // result of the callee is returned by it, frame of the function is reused
+            CompileCall<bytecode::Opcode::TailCall>(*call);
+            return;
+        }
         if (statement.expression) {
             statement.expression->Accept(*this);
         } else {
@@ -383,10 +396,232 @@ private:
         auto context = GetScope();
         PopScope();
 
-        result = BytecodeFunction::New(heap, context->GetBytecodeGenerator()->Flush());
+        result = BytecodeFunction::New(heap, Flush(*context));
     }
 
 private:
+    /**
+     * Operands of the binary instruction: one of them is in the accumulator, the other one is in the register
+     */
+    struct Operands {
+        /** Register with the right operand, or with the left one, if swapped */
+        bytecode::Register reg;
+        /** Whether the accumulator holds the right operand, so the operation must be swapped (see SwapOperands) */
+        bool swapped;
+    };
+
+    /**
+     * Compiles operands of the binary expression.
+     * Local variable in a register is used in place and constant is loaded right before the operation, so they don't
+     * need temporaries. Operands of commutative operations and comparisons are swapped, when the left one is a local
+     * variable. Otherwise the left operand is evaluated first and is stored to an anonymous register.
+     * @param expression The expression
+     * @return Operands of the instruction
+     */
+    Operands CompileOperands(ast::BinaryExpression& expression) {
+        ast::IExpression& left = *expression.left;
+        ast::IExpression& right = *expression.right;
+
+        bytecode::Register reg;
+        if (GetLocalRegister(right, reg)) {
+            left.Accept(*this);
+            return { reg, false };
+        }
+        const bool swappable = SwapOperands(expression.op.token) != Token::INVALID;
+        if (swappable && GetLocalRegister(left, reg) && IsPure(right)) {
+            right.Accept(*this);
+            return { reg, true };
+        }
+        if (IsConstant(right) || (IsPure(left) && IsPure(right))) {
+            // order of evaluation doesn't matter
+            right.Accept(*this);
+            auto temporary = GetScope()->GetRegistersShape()->LockRegisters(1);
+            GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(temporary.first);
+            left.Accept(*this);
+            return { temporary.first, false };
+        }
+
+        left.Accept(*this);
+        auto left_temporary = GetScope()->GetRegistersShape()->LockRegisters(1);
+        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(left_temporary.first);
+        right.Accept(*this);
+        if (swappable) {
+            return { left_temporary.first, true };
+        }
+        auto right_temporary = GetScope()->GetRegistersShape()->LockRegisters(1);
+        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(right_temporary.first);
+        GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::LoadRegister>(left_temporary.first);
+        return { right_temporary.first, false };
+    }
+
+    /**
+     * Compiles call of the function with the arguments in consecutive registers
+     * @tparam call_opcode Call or TailCall
+     * @param expression The call
+     */
+    template<bytecode::Opcode call_opcode>
+    void CompileCall(ast::FunctionCallExpression& expression) {
+        // variable, that is called, is loaded after the arguments, if they can't change it
+        bool arguments_are_pure = true;
+        for (auto& argument : expression.arguments) {
+            arguments_are_pure = arguments_are_pure && IsPure(*argument);
+        }
+        const bool load_after_arguments = arguments_are_pure && IsPure(*expression.expression);
+
+        bytecode::RegistersRange f { 0, 0 };
+        if (!load_after_arguments) {
+            expression.expression->Accept(*this);
+            f = GetScope()->GetRegistersShape()->LockRegisters(1);
+            GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(f.first);
+        }
+        const auto arguments_count = static_cast<int32_t>(expression.arguments.size());
+        auto args = GetScope()->GetRegistersShape()->LockRegisters(arguments_count);
+        for (int32_t i = 0; i < arguments_count; ++i) {
+            expression.arguments[i]->Accept(*this);
+            GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::StoreRegister>(args.first + i);
+        }
+        if (load_after_arguments) {
+            expression.expression->Accept(*this);
+        } else {
+            GetScope()->GetBytecodeGenerator()->EmitInstruction<bytecode::Opcode::LoadRegister>(f.first);
+        }
+        GetScope()->GetBytecodeGenerator()->EmitInstruction<call_opcode>(args);
+    }
+
+    /**
+     * Returns operator, which gives the same result with swapped operands
+     * @param token The operator
+     * @return Swapped operator, or INVALID, if the operator isn't commutative (e.g. + concatenates strings)
+     */
+    static Token SwapOperands(Token token) {
+        switch (token) {
+            case Token::MUL:
+            case Token::EQUALS:
+            case Token::NOT_EQUALS:
+                return token;
+            case Token::LESS: return Token::GREATER;
+            case Token::GREATER: return Token::LESS;
+            case Token::LESS_EQUALS: return Token::GREATER_EQUALS;
+            case Token::GREATER_EQUALS: return Token::LESS_EQUALS;
+            default: return Token::INVALID;
+        }
+    }
+
+    /**
+     * Checks whether the expression is a local variable in a register, which can be used as an operand in place
+     * @param expression The expression
+     * @param reg Register of the variable
+     * @return Whether the expression is a declared local variable in a register
+     */
+    bool GetLocalRegister(ast::IExpression& expression, bytecode::Register& reg) {
+        auto literal = GetLiteral(expression);
+        auto identifier = dynamic_cast<ast::IdentifierLiteral*>(literal);
+        if (!identifier) {
+            return false;
+        }
+        auto location = GetScope()->GetLocation(identifier->identifier);
+        if (location.storage_type != Scope::StorageType::Register ||
+            !GetScope()->GetRegistersShape()->IsDeclared(identifier->identifier)) {
+            return false;
+        }
+        reg = location.reg;
+        return true;
+    }
+
+    /**
+     * Checks whether the expression is a literal of a constant (not a variable)
+     */
+    static bool IsConstant(ast::IExpression& expression) {
+        auto literal = GetLiteral(expression);
+        return literal && !dynamic_cast<ast::IdentifierLiteral*>(literal);
+    }
+
+    /**
+     * Checks whether the expression has no side effects (assignments, calls), so it can be evaluated out of order
+     */
+    static bool IsPure(ast::IExpression& expression) {
+        if (GetLiteral(expression)) {
+            return true;
+        }
+        if (auto binary = dynamic_cast<ast::BinaryExpression*>(&expression)) {
+            return binary->op.token != Token::ASSIGN && IsPure(*binary->left) && IsPure(*binary->right);
+        }
+        return false;
+    }
+
+    static ast::ILiteral* GetLiteral(ast::IExpression& expression) {
+        ast::IExpression* current = &expression;
+        while (auto parenthesized = dynamic_cast<ast::ParenthesizedExpression*>(current)) {
+            current = parenthesized->expression.get();
+        }
+        auto literal = dynamic_cast<ast::LiteralExpression*>(current);
+        return literal ? literal->literal.get() : nullptr;
+    }
+
+    /**
+     * Compiles the condition and emits jump, which is taken if the condition is equal to jump_if.
+     * Comparison is fused with the jump, so the Bool result isn't materialized in the accumulator.
+     * @param condition The condition
+     * @param jump_if Value of the condition, when the jump is taken
+     * @return Label of the jump to update
+     */
+    bytecode::JumpLabel EmitConditionalJump(ast::IExpression& condition, bool jump_if) {
+        using bytecode::Opcode;
+
+        auto binary = dynamic_cast<ast::BinaryExpression*>(&condition);
+        if (binary && IsComparison(binary->op.token)) {
+            auto operands = CompileOperands(*binary);
+            const Token token = operands.swapped ? SwapOperands(binary->op.token) : binary->op.token;
+            bytecode::JumpLabel label;
+            switch (token) {
+                case Token::EQUALS:
+                    label = EmitComparisonJump<Opcode::JumpIfEqual, Opcode::JumpIfNotEqual>(operands.reg, jump_if);
+                    break;
+                case Token::NOT_EQUALS:
+                    label = EmitComparisonJump<Opcode::JumpIfNotEqual, Opcode::JumpIfEqual>(operands.reg, jump_if);
+                    break;
+                case Token::LESS:
+                    label = EmitComparisonJump<Opcode::JumpIfLess, Opcode::JumpIfNotLess>(operands.reg, jump_if);
+                    break;
+                case Token::GREATER:
+                    label = EmitComparisonJump<Opcode::JumpIfGreater, Opcode::JumpIfNotGreater>(operands.reg, jump_if);
+                    break;
+                case Token::LESS_EQUALS:
+                    label = EmitComparisonJump<Opcode::JumpIfLessOrEqual, Opcode::JumpIfNotLessOrEqual>(operands.reg, jump_if);
+                    break;
+                default:
+                    label = EmitComparisonJump<Opcode::JumpIfGreaterOrEqual, Opcode::JumpIfNotGreaterOrEqual>(operands.reg, jump_if);
+                    break;
+            }
+            return label;
+        }
+
+        condition.Accept(*this);
+        if (jump_if) {
+            return GetScope()->GetBytecodeGenerator()->EmitJump<Opcode::JumpIfTrue>(0);
+        }
+        return GetScope()->GetBytecodeGenerator()->EmitJump<Opcode::JumpIfFalse>(0);
+    }
+
+    static bool IsComparison(Token token) {
+        return token == Token::EQUALS || token == Token::NOT_EQUALS || token == Token::LESS ||
+               token == Token::GREATER || token == Token::LESS_EQUALS || token == Token::GREATER_EQUALS;
+    }
+
+    template<bytecode::Opcode if_true, bytecode::Opcode if_false>
+    bytecode::JumpLabel EmitComparisonJump(bytecode::Register reg, bool jump_if) {
+        return jump_if
+                ? GetScope()->GetBytecodeGenerator()->EmitRegisterJump<if_true>(reg)
+                : GetScope()->GetBytecodeGenerator()->EmitRegisterJump<if_false>(reg);
+    }
+
+    bytecode::BytecodeChunk Flush(Scope& scope) {
+        auto chunk = scope.GetBytecodeGenerator()->Flush();
+        optimizer.Optimize(chunk);
+        scope.GetRegistersShape()->Allocate(chunk);
+        return chunk;
+    }
+
     template<bool weak>
     NLANG_FORCE_INLINE void PushScopeImpl(ast::INode& node) {
         NLANG_ASSERT(node.meta);
@@ -415,6 +650,7 @@ private:
         return scope_stack[depth];
     }
 
+    bytecode::BytecodeOptimizer optimizer;
     Handle<Function> result;
     Heap* heap;
     std::deque<IntrusivePtr<Scope>> scope_stack;
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <common/ast.hpp>
+#include <common/source.hpp>
+
+#include <interpreter/function.hpp>
+#include <interpreter/heap.hpp>
+
+#include <utils/pointers/shared_ptr.hpp>
+#include <utils/pointers/unique_ptr.hpp>
+#include <utils/threading/thread_pool.hpp>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nlang {
+
+/**
+ * Front end for a set of modules.
+ * Modules are independent until compilation, so reading, scanning, parsing and semantic analysis of each module run
+ * as a separate task of the thread pool. Compilation allocates on the heap, so it runs on the calling thread.
+ */
+class ModuleLoader final {
+public:
+    /**
+     * Creates loader
+     * @param threads Amount of worker threads
+     */
+    explicit ModuleLoader(size_t threads = std::max(std::thread::hardware_concurrency(), 1u))
+        : pool(threads)
+    {}
+
+    ModuleLoader(const ModuleLoader&) = delete;
+    ModuleLoader(ModuleLoader&&) = delete;
+    ModuleLoader& operator=(const ModuleLoader&) = delete;
+    ModuleLoader& operator=(ModuleLoader&&) = delete;
+
+    /**
+     * Reads, parses and analyses modules in parallel.
+     * If any module fails, the first error (in order of paths) is rethrown after all the tasks are finished.
+     * @param paths Paths to UTF-8 source files
+     * @return Analysed ASTs in order of paths
+     */
+    std::vector<UniquePtr<ast::Module>> Load(const std::vector<std::string>& paths);
+
+    /**
+     * Compiles analysed modules in dependency order.
+     * Modules can't import each other yet, so the dependency order is the order of loading.
+     * @param heap Heap to use while compiling
+     * @param modules Analysed ASTs
+     * @return Compiled module functions, they are persistent roots of the heap until they are passed to Heap::RemoveRoot
+     */
+    static std::vector<Handle<Function>> Compile(Heap* heap, const std::vector<UniquePtr<ast::Module>>& modules);
+
+    /**
+     * Parses and analyses single module on the calling thread
+     * @param source Source code of the module
+     * @return Analysed AST
+     */
+    static UniquePtr<ast::Module> LoadModule(SharedPtr<Source> source);
+
+private:
+    ThreadPool pool;
+};
+
+}
\ No newline at end of file
@@ -5,7 +5,6 @@
 #include <utils/pointers.hpp>
 #include <utils/strings.hpp>
 
-#include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <cstddef>
@@ -14,7 +13,10 @@ namespace nlang {
 
 /**
  * Register shape
- * Handles local variables creation and register used in each moment of compilation
+ * Handles local variables creation and registers used in each moment of compilation.
+ * While the function is compiled, each local variable and each temporary gets its own virtual register. After that,
+ * Allocate computes live ranges of the virtual registers and packs them to the frame registers with linear scan, so
+ * variables and temporaries with disjoint lifetimes share a register.
  */
 class RegistersShape : public IntrusivePtrRefCounter {
 public:
@@ -27,11 +29,11 @@ public:
     // building
 
     void StoreLocal(const UString& name) {
-        auto p = registers.try_emplace(name, locals_count);
+        auto p = registers.try_emplace(name, virtual_registers_count);
         if (!p.second) {
             throw; // redeclaration
         }
-        ++locals_count;
+        ++virtual_registers_count;
     }
 
     void StoreArgument(const UString& name, int32_t index) {
@@ -43,17 +45,8 @@ public:
     }
 
     void RemoveName(const UString& name) {
-        if (auto it = registers.find(name); it != registers.end()) {
-            int32_t removed_index = it->second;
-            registers.erase(it);
-            if (removed_index >= 0) {
-                --locals_count;
-                for (auto& [name, index] : registers) {
-                    if (index > removed_index) {
-                        --index;
-                    }
-                }
-            }
+        // virtual register of the name is just left unused
+        if (registers.erase(name)) {
             return;
         }
         throw; // no such name
@@ -61,47 +54,39 @@ public:
 
     // using
 
+    /**
+     * Locks consecutive registers for temporary values.
+     * Registers are never reused before the allocation, which finds out when they are dead.
+     * @param count Count of the registers
+     * @return The registers
+     */
     bytecode::RegistersRange LockRegisters(int32_t count) {
-        bytecode::RegistersRange current_range { locals_count, 0 };
-        for (int32_t i = 0; i < anonymous_registers.size(); ++i) {
-            if (anonymous_registers[i]) {
-                current_range = { locals_count + i + 1, 0 };
-            } else {
-                ++current_range.count;
-            }
-            if (current_range.count == count) {
-                break;
-            }
-        }
-
-        if (current_range.count < count) {
-            anonymous_registers.resize(current_range.first - locals_count + count);
-            current_range.count = count;
-        }
-
-        for (int32_t i = 0; i < count; ++i) {
-            anonymous_registers[current_range.first - locals_count + i] = true;
-        }
-
-        return current_range;
-    }
-
-    void ReleaseRegisters(bytecode::RegistersRange range) {
-        for (int32_t i = 0; i < range.count; ++i) {
-            anonymous_registers[range.first - locals_count + i] = false;
-        }
+        bytecode::RegistersRange range { virtual_registers_count, count };
+        virtual_registers_count += count;
+        return range;
     }
 
+    /**
+     * Returns count of the virtual registers, which is the count of registers of the chunk before the allocation
+     */
     int32_t GetRegistersCount() const {
-        return locals_count + anonymous_registers.size();
+        return virtual_registers_count;
     }
 
     int32_t GetArgumentsCount() const {
         return arguments_count;
     }
 
+    /**
+     * Returns register of the name.
+     * Arguments are right below the registers of the frame in order of declaration, so the first of n arguments is
+     * register -n and the last one is register -1.
+     * @param name The name
+     * @return The register
+     */
     int32_t GetIndex(const UString& name) const {
-        return registers.at(name);
+        const int32_t reg = registers.at(name);
+        return reg < 0 ? -reg - 1 - arguments_count : reg;
     }
 
     void Declare(const UString& name) {
@@ -112,12 +97,22 @@ public:
         return declared_registers.count(name);
     }
 
+    /**
+     * Replaces virtual registers of the chunk with the frame registers.
+     * Live range of a virtual register spans from the first to the last instruction, where it is live or used
+     * (liveness analysis over the control flow graph, so loops are accounted). Ranges are assigned to the lowest free
+     * registers in order of their start (linear scan). Registers of the call arguments are allocated as one window of
+     * consecutive registers after the others. Frame of the callee starts at the window, so it is placed above all the
+     * registers, which are live after the call.
+     * @param chunk Flushed chunk of the function, compiled with this shape, its registers count is updated
+     */
+    void Allocate(bytecode::BytecodeChunk& chunk) const;
+
 private:
     std::unordered_map<UString, int32_t> registers;
     std::unordered_set<UString> declared_registers;
     int32_t arguments_count = 0;
-    int32_t locals_count = 0;
-    std::vector<bool> anonymous_registers;
+    int32_t virtual_registers_count = 0;
 };
 
 
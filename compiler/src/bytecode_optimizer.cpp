@@ -0,0 +1,487 @@
+#include <compiler/bytecode_optimizer.hpp>
+
+#include <interpreter/objects/primitives.hpp>
+
+#include <utils/macro.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace nlang::bytecode {
+
+namespace {
+
+OperandFormat GetFormat(const Instruction& instruction) {
+    return operand_formats[static_cast<uint8_t>(instruction.opcode)];
+}
+
+bool IsWide(const Instruction& instruction) {
+    const OperandFormat format = GetFormat(instruction);
+    for (int32_t i = 0; i < format.scalars; ++i) {
+        if (instruction.fields[i] < std::numeric_limits<int8_t>::min() ||
+            instruction.fields[i] > std::numeric_limits<int8_t>::max()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t GetSize(const Instruction& instruction) {
+    return GetInstructionSize(GetFormat(instruction), IsWide(instruction));
+}
+
+bool ReadsRegister(const Instruction& instruction) {
+    return GetFormat(instruction).registers == RegisterOperand::Register && instruction.opcode != Opcode::StoreRegister;
+}
+
+/**
+ * Registers, live at the exit of the instruction, by the liveness at the entry of the successors
+ */
+void LiveOut(const std::vector<OptimizedInstruction>& instructions,
+                    const std::vector<std::vector<bool>>& live,
+                    size_t index,
+                    std::vector<bool>& out,
+                    std::vector<size_t>& successors) {
+    std::fill(out.begin(), out.end(), false);
+    GetSuccessors(instructions, index, successors);
+    for (size_t successor : successors) {
+        for (size_t reg = 0; reg < out.size(); ++reg) {
+            out[reg] = out[reg] || live[successor][reg];
+        }
+    }
+}
+
+/**
+ * Checks whether the instruction only loads a value to the accumulator, without side effects
+ */
+bool IsAccumulatorLoad(Opcode opcode) {
+    switch (opcode) {
+        case Opcode::LoadRegister:
+        case Opcode::LoadConstant:
+        case Opcode::LoadNumber:
+        case Opcode::LoadNull:
+        case Opcode::LoadTrue:
+        case Opcode::LoadFalse:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Erases removed instructions and updates jump destinations and flags
+ */
+void Compact(std::vector<OptimizedInstruction>& instructions) {
+    // jump to the removed instruction leads to the next instruction, that is left
+    std::vector<int32_t> new_indices(instructions.size() + 1);
+    int32_t left = 0;
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        new_indices[i] = left;
+        left += !instructions[i].removed;
+    }
+    new_indices[instructions.size()] = left;
+
+    std::vector<OptimizedInstruction> compacted;
+    compacted.reserve(left);
+    for (auto& instruction : instructions) {
+        if (!instruction.removed) {
+            compacted.push_back(instruction);
+            compacted.back().is_target = false;
+            if (compacted.back().target >= 0) {
+                compacted.back().target = new_indices[compacted.back().target];
+            }
+        }
+    }
+    for (auto& instruction : compacted) {
+        if (instruction.target >= 0 && static_cast<size_t>(instruction.target) < compacted.size()) {
+            compacted[instruction.target].is_target = true;
+        }
+    }
+    instructions = std::move(compacted);
+}
+
+/**
+ * Replaces `LoadNumber b; StoreRegister r; LoadNumber a; Op r` with `LoadNumber b; StoreRegister r; Load (a op b)`.
+ * The store is left for the redundant load/store elimination, which removes it, if the register is dead.
+ */
+class ConstantFoldingPass : public IBytecodePass {
+public:
+    const char* GetName() const override {
+        return BytecodeOptimizer::CONSTANT_FOLDING;
+    }
+
+    size_t Run(std::vector<OptimizedInstruction>& instructions, BytecodeChunk& chunk) override {
+        size_t changes = 0;
+        for (size_t i = 0; i + 3 < instructions.size(); ++i) {
+            const Instruction& right = instructions[i].instruction;
+            const Instruction& store = instructions[i + 1].instruction;
+            Instruction& left = instructions[i + 2].instruction;
+            OptimizedInstruction& operation = instructions[i + 3];
+            if (right.opcode != Opcode::LoadNumber || store.opcode != Opcode::StoreRegister ||
+                left.opcode != Opcode::LoadNumber || operation.instruction.reg != store.reg ||
+                instructions[i + 1].is_target || instructions[i + 2].is_target || operation.is_target) {
+                continue;
+            }
+
+            const double l = left.immediate_int32;
+            const double r = right.immediate_int32;
+            Instruction result {};
+            switch (operation.instruction.opcode) {
+                case Opcode::Add: result = LoadNumber(l + r, chunk); break;
+                case Opcode::Sub: result = LoadNumber(l - r, chunk); break;
+                case Opcode::Mul: result = LoadNumber(l * r, chunk); break;
+                case Opcode::Div: result = LoadNumber(l / r, chunk); break;
+                case Opcode::CheckEqual: result = LoadBool(l == r); break;
+                case Opcode::CheckNotEqual: result = LoadBool(l != r); break;
+                case Opcode::CheckLess: result = LoadBool(l < r); break;
+                case Opcode::CheckGreater: result = LoadBool(l > r); break;
+                case Opcode::CheckLessOrEqual: result = LoadBool(l <= r); break;
+                case Opcode::CheckGreaterOrEqual: result = LoadBool(l >= r); break;
+                default: continue;
+            }
+            left = result;
+            operation.removed = true;
+            ++changes;
+            i += 3;
+        }
+        return changes;
+    }
+
+private:
+    static Instruction LoadNumber(double number, BytecodeChunk& chunk) {
+        Instruction instruction {};
+        if (IsImmediateInt32(number)) {
+            instruction.opcode = Opcode::LoadNumber;
+            instruction.immediate_int32 = static_cast<int32_t>(number);
+        } else {
+            instruction.opcode = Opcode::LoadConstant;
+            instruction.const_index = chunk.constant_pool.size();
+            chunk.constant_pool.emplace_back(Number::New(number));
+        }
+        return instruction;
+    }
+
+    static Instruction LoadBool(bool value) {
+        Instruction instruction {};
+        instruction.opcode = value ? Opcode::LoadTrue : Opcode::LoadFalse;
+        return instruction;
+    }
+};
+
+/**
+ * Removes:
+ * - load of the register right after the store to it and store right after the load (value is already there);
+ * - load to the accumulator, which is overwritten by the next load;
+ * - store to the register, which isn't read before it is stored again or the function returns (liveness analysis).
+ */
+class RedundantLoadStoreEliminationPass : public IBytecodePass {
+public:
+    const char* GetName() const override {
+        return BytecodeOptimizer::REDUNDANT_LOAD_STORE_ELIMINATION;
+    }
+
+    size_t Run(std::vector<OptimizedInstruction>& instructions, BytecodeChunk& chunk) override {
+        size_t changes = EliminateDeadStores(instructions, chunk);
+        for (size_t i = 0; i + 1 < instructions.size(); ++i) {
+            OptimizedInstruction& current = instructions[i];
+            OptimizedInstruction& next = instructions[i + 1];
+            if (current.removed || next.removed) {
+                continue;
+            }
+            const Opcode current_opcode = current.instruction.opcode;
+            const Opcode next_opcode = next.instruction.opcode;
+            if (((current_opcode == Opcode::StoreRegister && next_opcode == Opcode::LoadRegister) ||
+                 (current_opcode == Opcode::LoadRegister && next_opcode == Opcode::StoreRegister)) &&
+                current.instruction.reg == next.instruction.reg && !next.is_target) {
+                next.removed = true;
+                ++changes;
+            } else if (IsAccumulatorLoad(current_opcode) &&
+                       (IsAccumulatorLoad(next_opcode) || next_opcode == Opcode::LoadContext)) {
+                // jumps to the removed load lead to the next one, which overwrites the accumulator anyway
+                current.removed = true;
+                ++changes;
+            }
+        }
+        return changes;
+    }
+
+private:
+    static size_t EliminateDeadStores(std::vector<OptimizedInstruction>& instructions, const BytecodeChunk& chunk) {
+        // arguments are negative registers
+        const int32_t first = -chunk.arguments_count;
+        const int32_t count = chunk.arguments_count + chunk.registers_count;
+        auto in_range = [&](int32_t reg) { return reg >= first && reg < first + count; };
+        for (const auto& optimized : instructions) {
+            const Instruction& instruction = optimized.instruction;
+            const RegisterOperand registers = GetFormat(instruction).registers;
+            const RegistersRange range = instruction.reg_range;
+            if ((registers == RegisterOperand::Register && !in_range(instruction.reg)) ||
+                (registers == RegisterOperand::Range && range.count > 0 &&
+                 (!in_range(range.first) || !in_range(range.first + range.count - 1)))) {
+                // unknown register layout, nothing is proven dead
+                return 0;
+            }
+        }
+
+        const auto live = ComputeLiveness(instructions, chunk.arguments_count, chunk.registers_count);
+        std::vector<bool> out(count);
+        std::vector<size_t> successors;
+
+        size_t changes = 0;
+        for (size_t i = 0; i < instructions.size(); ++i) {
+            if (instructions[i].instruction.opcode != Opcode::StoreRegister) {
+                continue;
+            }
+            LiveOut(instructions, live, i, out, successors);
+            if (!out[instructions[i].instruction.reg - first]) {
+                instructions[i].removed = true;
+                ++changes;
+            }
+        }
+        return changes;
+    }
+};
+
+/**
+ * Retargets jumps to unconditional jumps to their final destination and removes jumps to the next instruction
+ * (conditional jumps, which compare with a register, are left, as the comparison may throw)
+ */
+class JumpThreadingPass : public IBytecodePass {
+public:
+    const char* GetName() const override {
+        return BytecodeOptimizer::JUMP_THREADING;
+    }
+
+    size_t Run(std::vector<OptimizedInstruction>& instructions, BytecodeChunk& chunk) override {
+        const int32_t size = instructions.size();
+        size_t changes = 0;
+        for (int32_t i = 0; i < size; ++i) {
+            OptimizedInstruction& jump = instructions[i];
+            if (jump.target < 0) {
+                continue;
+            }
+
+            int32_t target = jump.target;
+            // loop of jumps is left as is
+            for (int32_t steps = 0; steps < size && target < size &&
+                    instructions[target].instruction.opcode == Opcode::Jump &&
+                    instructions[target].target != target; ++steps) {
+                target = instructions[target].target;
+            }
+            if (target != jump.target) {
+                jump.target = target;
+                ++changes;
+            }
+
+            const Opcode opcode = jump.instruction.opcode;
+            if (target == i + 1 &&
+                (opcode == Opcode::Jump || opcode == Opcode::JumpIfTrue || opcode == Opcode::JumpIfFalse)) {
+                jump.removed = true;
+                ++changes;
+            }
+        }
+        return changes;
+    }
+};
+
+/**
+ * Removes instructions, that aren't reachable from the first one
+ */
+class DeadCodeEliminationPass : public IBytecodePass {
+public:
+    const char* GetName() const override {
+        return BytecodeOptimizer::DEAD_CODE_ELIMINATION;
+    }
+
+    size_t Run(std::vector<OptimizedInstruction>& instructions, BytecodeChunk& chunk) override {
+        if (instructions.empty()) {
+            return 0;
+        }
+
+        std::vector<bool> reachable(instructions.size());
+        std::vector<size_t> worklist { 0 };
+        std::vector<size_t> successors;
+        reachable[0] = true;
+        while (!worklist.empty()) {
+            const size_t current = worklist.back();
+            worklist.pop_back();
+            GetSuccessors(instructions, current, successors);
+            for (size_t successor : successors) {
+                if (!reachable[successor]) {
+                    reachable[successor] = true;
+                    worklist.push_back(successor);
+                }
+            }
+        }
+
+        size_t changes = 0;
+        for (size_t i = 0; i < instructions.size(); ++i) {
+            if (!reachable[i]) {
+                instructions[i].removed = true;
+                ++changes;
+            }
+        }
+        return changes;
+    }
+};
+
+}
+
+void GetSuccessors(const std::vector<OptimizedInstruction>& instructions, size_t index, std::vector<size_t>& successors) {
+    successors.clear();
+    const OptimizedInstruction& current = instructions[index];
+    const Opcode opcode = current.instruction.opcode;
+    if (opcode != Opcode::Return && opcode != Opcode::TailCall && opcode != Opcode::Jump &&
+        index + 1 < instructions.size()) {
+        successors.push_back(index + 1);
+    }
+    if (current.target >= 0 && static_cast<size_t>(current.target) < instructions.size()) {
+        successors.push_back(current.target);
+    }
+}
+
+std::vector<OptimizedInstruction> DecodeForOptimization(const std::vector<uint8_t>& code) {
+    std::vector<OptimizedInstruction> instructions;
+    std::vector<size_t> ends;
+    // index of the instruction by its position, jump to the end of the code leads past the last instruction
+    std::vector<int32_t> indices(code.size() + 1, -1);
+    for (size_t position = 0; position < code.size();) {
+        indices[position] = instructions.size();
+        instructions.push_back({ {}, -1, false, false });
+        position += DecodeInstruction(code.data() + position, instructions.back().instruction);
+        ends.push_back(position);
+    }
+    indices[code.size()] = instructions.size();
+
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        const OperandFormat format = GetFormat(instructions[i].instruction);
+        if (format.offset) {
+            const int64_t destination = ends[i] + instructions[i].instruction.fields[format.scalars];
+            NLANG_ASSERT(destination >= 0 && destination <= static_cast<int64_t>(code.size()));
+            instructions[i].target = indices[destination];
+            NLANG_ASSERT(instructions[i].target >= 0);
+        }
+    }
+    Compact(instructions);
+    return instructions;
+}
+
+std::vector<uint8_t> EncodeOptimized(std::vector<OptimizedInstruction>& instructions) {
+    // offsets are always 4 bytes, so sizes don't depend on them
+    std::vector<int32_t> positions(instructions.size() + 1);
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        positions[i + 1] = positions[i] + GetSize(instructions[i].instruction);
+    }
+
+    std::vector<uint8_t> code;
+    code.reserve(positions.back());
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        Instruction& instruction = instructions[i].instruction;
+        const OperandFormat format = GetFormat(instruction);
+        if (format.offset) {
+            instruction.fields[format.scalars] = positions[instructions[i].target] - positions[i + 1];
+        }
+        EncodeInstruction(instruction, code);
+    }
+    return code;
+}
+
+std::vector<std::vector<bool>> ComputeLiveness(const std::vector<OptimizedInstruction>& instructions,
+                                               int32_t arguments_count,
+                                               int32_t registers_count) {
+    // arguments are negative registers
+    const int32_t first = -arguments_count;
+    const int32_t count = arguments_count + registers_count;
+    std::vector<std::vector<bool>> live(instructions.size(), std::vector<bool>(count));
+    std::vector<bool> out(count);
+    std::vector<size_t> successors;
+    // backward data flow until the fixed point
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = instructions.size(); i-- > 0;) {
+            LiveOut(instructions, live, i, out, successors);
+            const Instruction& instruction = instructions[i].instruction;
+            if (instruction.opcode == Opcode::StoreRegister) {
+                out[instruction.reg - first] = false;
+            } else if (GetFormat(instruction).registers == RegisterOperand::Range) {
+                for (int32_t reg = 0; reg < instruction.reg_range.count; ++reg) {
+                    out[instruction.reg_range.first + reg - first] = true;
+                }
+            } else if (ReadsRegister(instruction)) {
+                out[instruction.reg - first] = true;
+            }
+            if (out != live[i]) {
+                live[i] = out;
+                changed = true;
+            }
+        }
+    }
+    return live;
+}
+
+BytecodeOptimizer::BytecodeOptimizer()
+    : BytecodeOptimizer(Options())
+{}
+
+BytecodeOptimizer::BytecodeOptimizer(const Options& options) {
+    if (options.fold_constants) {
+        AddPass(MakeUnique<ConstantFoldingPass>());
+    }
+    if (options.eliminate_redundant_loads_stores) {
+        AddPass(MakeUnique<RedundantLoadStoreEliminationPass>());
+    }
+    if (options.thread_jumps) {
+        AddPass(MakeUnique<JumpThreadingPass>());
+    }
+    if (options.eliminate_dead_code) {
+        AddPass(MakeUnique<DeadCodeEliminationPass>());
+    }
+}
+
+void BytecodeOptimizer::AddPass(UniquePtr<IBytecodePass> pass) {
+    passes.push_back({ std::move(pass), 0 });
+}
+
+void BytecodeOptimizer::Optimize(BytecodeChunk& chunk) {
+    if (passes.empty() || chunk.bytecode.empty()) {
+        return;
+    }
+
+    auto instructions = DecodeForOptimization(chunk.bytecode);
+    // each pass may open opportunities for the others, the limit guards against passes, that undo each other
+    constexpr int32_t MAX_ITERATIONS = 16;
+    for (int32_t iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
+        size_t changes = 0;
+        for (auto& pass : passes) {
+            const size_t pass_changes = pass.pass->Run(instructions, chunk);
+            pass.changes += pass_changes;
+            changes += pass_changes;
+            Compact(instructions);
+        }
+        if (!changes) {
+            break;
+        }
+    }
+    chunk.bytecode = EncodeOptimized(instructions);
+}
+
+std::vector<BytecodeOptimizer::PassStats> BytecodeOptimizer::GetStats() const {
+    std::vector<PassStats> stats;
+    stats.reserve(passes.size());
+    for (const auto& pass : passes) {
+        stats.push_back({ pass.pass->GetName(), pass.changes });
+    }
+    return stats;
+}
+
+size_t BytecodeOptimizer::GetChanges(const std::string& name) const {
+    size_t changes = 0;
+    for (const auto& pass : passes) {
+        if (name == pass.pass->GetName()) {
+            changes += pass.changes;
+        }
+    }
+    return changes;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include <compiler/module_loader.hpp>
+
+#include <compiler/compiler.hpp>
+#include <compiler/semantic_analyser.hpp>
+
+#include <parser/parser.hpp>
+#include <parser/scanner.hpp>
+#include <parser/token_stream.hpp>
+
+#include <exception>
+#include <future>
+
+namespace nlang {
+
+std::vector<UniquePtr<ast::Module>> ModuleLoader::Load(const std::vector<std::string>& paths) {
+    std::vector<std::future<UniquePtr<ast::Module>>> futures;
+    futures.reserve(paths.size());
+    for (const auto& path : paths) {
+        futures.push_back(pool.Enqueue([&path]() {
+            return LoadModule(Source::FromFile(path));
+        }));
+    }
+
+    // all the tasks must be finished before leaving, because they refer to paths
+    std::vector<UniquePtr<ast::Module>> modules;
+    modules.reserve(paths.size());
+    std::exception_ptr error;
+    for (auto& future : futures) {
+        try {
+            modules.push_back(future.get());
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return modules;
+}
+
+std::vector<Handle<Function>> ModuleLoader::Compile(Heap* heap, const std::vector<UniquePtr<ast::Module>>& modules) {
+    std::vector<Handle<Function>> functions;
+    functions.reserve(modules.size());
+    for (const auto& module : modules) {
+        Compiler compiler;
+        functions.push_back(compiler.Compile(heap, *module));
+    }
+    return functions;
+}
+
+UniquePtr<ast::Module> ModuleLoader::LoadModule(SharedPtr<Source> source) {
+    auto parser = Parser::New(Scanner::New(TokenStream::New(std::move(source))));
+    auto module = parser->ParseModule();
+
+    SemanticAnalyser semantic_analyser;
+    semantic_analyser.Process(*module);
+    return module;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <compiler/registers_shape.hpp>
+
+#include <compiler/bytecode_optimizer.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace nlang {
+
+void RegistersShape::Allocate(bytecode::BytecodeChunk& chunk) const {
+    using namespace bytecode;
+
+    auto instructions = DecodeForOptimization(chunk.bytecode);
+    const int32_t count = chunk.registers_count;
+    const auto live = ComputeLiveness(instructions, chunk.arguments_count, count);
+
+    // registers of the call arguments are allocated together, as the window of the first one
+    std::vector<int32_t> group(count);
+    std::iota(group.begin(), group.end(), 0);
+    std::vector<int32_t> width(count, 1);
+    // index of the call, which takes the window, -1 if the register is not a window
+    std::vector<int32_t> window_call(count, -1);
+    std::vector<int32_t> empty_calls;
+    for (int32_t i = 0; i < static_cast<int32_t>(instructions.size()); ++i) {
+        const Instruction& instruction = instructions[i].instruction;
+        if (operand_formats[static_cast<uint8_t>(instruction.opcode)].registers != RegisterOperand::Range) {
+            continue;
+        }
+        if (!instruction.reg_range.count) {
+            empty_calls.push_back(i);
+            continue;
+        }
+        for (int32_t reg = 0; reg < instruction.reg_range.count; ++reg) {
+            group[instruction.reg_range.first + reg] = instruction.reg_range.first;
+        }
+        width[instruction.reg_range.first] = std::max(width[instruction.reg_range.first], instruction.reg_range.count);
+        window_call[instruction.reg_range.first] = i;
+    }
+
+    struct LiveRange {
+        int32_t start = std::numeric_limits<int32_t>::max();
+        int32_t end = -1;
+    };
+    std::vector<LiveRange> ranges(count);
+    auto extend = [&](Register reg, int32_t position) {
+        // arguments aren't allocated
+        if (reg < 0) {
+            return;
+        }
+        LiveRange& range = ranges[group[reg]];
+        range.start = std::min(range.start, position);
+        range.end = std::max(range.end, position);
+    };
+    for (int32_t i = 0; i < static_cast<int32_t>(instructions.size()); ++i) {
+        for (Register reg = 0; reg < count; ++reg) {
+            if (live[i][reg + chunk.arguments_count]) {
+                extend(reg, i);
+            }
+        }
+        const Instruction& instruction = instructions[i].instruction;
+        switch (operand_formats[static_cast<uint8_t>(instruction.opcode)].registers) {
+            case RegisterOperand::Register:
+                extend(instruction.reg, i);
+                break;
+            case RegisterOperand::Range:
+                for (int32_t reg = 0; reg < instruction.reg_range.count; ++reg) {
+                    extend(instruction.reg_range.first + reg, i);
+                }
+                break;
+            case RegisterOperand::None:
+                break;
+        }
+    }
+
+    std::vector<Register> order;
+    for (Register reg = 0; reg < count; ++reg) {
+        if (group[reg] == reg && ranges[reg].end >= 0) {
+            order.push_back(reg);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](Register a, Register b) {
+        return ranges[a].start < ranges[b].start;
+    });
+
+    // live ranges, that occupy each frame register
+    std::vector<std::vector<LiveRange>> occupied;
+    std::vector<Register> allocated(count, -1);
+    auto place = [&](Register reg, Register floor) {
+        const LiveRange& range = ranges[reg];
+        Register first = floor;
+        for (int32_t i = 0; i < width[reg]; ++i) {
+            if (first + i >= static_cast<int32_t>(occupied.size())) {
+                continue;
+            }
+            for (const LiveRange& other : occupied[first + i]) {
+                if (other.start <= range.end && range.start <= other.end) {
+                    first += i + 1;
+                    i = -1;
+                    break;
+                }
+            }
+        }
+        if (first + width[reg] > static_cast<int32_t>(occupied.size())) {
+            occupied.resize(first + width[reg]);
+        }
+        for (int32_t i = 0; i < width[reg]; ++i) {
+            occupied[first + i].push_back(range);
+        }
+        allocated[reg] = first;
+    };
+    // callee frame starts at the window and may overwrite everything above it, so the window must be above all the
+    // registers, which are live after the call (nothing is live after TailCall, which has no successors)
+    std::vector<size_t> successors;
+    auto above_live = [&](int32_t call) {
+        Register floor = 0;
+        GetSuccessors(instructions, call, successors);
+        for (size_t successor : successors) {
+            for (Register reg = 0; reg < count; ++reg) {
+                if (live[successor][reg + chunk.arguments_count] && allocated[group[reg]] >= 0) {
+                    floor = std::max(floor, allocated[group[reg]] + reg - group[reg] + 1);
+                }
+            }
+        }
+        return floor;
+    };
+
+    // windows are placed after the other registers, as they depend on them
+    for (Register reg : order) {
+        if (window_call[reg] < 0) {
+            place(reg, 0);
+        }
+    }
+    for (Register reg : order) {
+        if (window_call[reg] >= 0) {
+            place(reg, above_live(window_call[reg]));
+        }
+    }
+
+    auto map = [&](Register reg) {
+        return reg < 0 ? reg : allocated[group[reg]] + reg - group[reg];
+    };
+    for (int32_t call : empty_calls) {
+        instructions[call].instruction.reg_range.first = above_live(call);
+    }
+    for (auto& optimized : instructions) {
+        Instruction& instruction = optimized.instruction;
+        switch (operand_formats[static_cast<uint8_t>(instruction.opcode)].registers) {
+            case RegisterOperand::Register:
+                instruction.reg = map(instruction.reg);
+                break;
+            case RegisterOperand::Range:
+                if (instruction.reg_range.count) {
+                    instruction.reg_range.first = map(instruction.reg_range.first);
+                }
+                break;
+            case RegisterOperand::None:
+                break;
+        }
+    }
+
+    chunk.bytecode = EncodeOptimized(instructions);
+    chunk.registers_count = occupied.size();
+}
+
+}
\ No newline at end of file
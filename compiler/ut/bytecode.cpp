@@ -0,0 +1,68 @@
+#include <catch2/catch.hpp>
+
+#include <compiler/bytecode.hpp>
+
+#include <vector>
+
+TEST_CASE("bytecode encoding") {
+    using namespace nlang::bytecode;
+
+    BytecodeGenerator generator;
+    generator.SetArgumentsCount(1);
+    generator.SetRegistersCount(2);
+    const Label return_label = generator.EmitInstruction<Opcode::Return>();
+    const Label narrow_label = generator.EmitInstruction<Opcode::LoadRegister>(-128);
+    const Label wide_label = generator.EmitInstruction<Opcode::LoadRegister>(300);
+    const Label call_label = generator.EmitInstruction<Opcode::Call>(RegistersRange { 200, 2 });
+    const Label context_label = generator.EmitInstruction<Opcode::LoadContext>(ContextDescriptor { 1, 2 });
+    const JumpLabel jump_label = generator.EmitJump<Opcode::Jump>(return_label);
+    const JumpLabel narrow_jump_label = generator.EmitRegisterJump<Opcode::JumpIfLess>(3);
+    const JumpLabel wide_jump_label = generator.EmitRegisterJump<Opcode::JumpIfNotEqual>(-1000);
+    const Label end_label = generator.GetLabel();
+    generator.UpdateJumpToHere(narrow_jump_label);
+    generator.UpdateJump(wide_jump_label, narrow_label);
+
+    // opcode, scalars by 1 byte, offsets by 4 bytes, Wide prefix with 4-byte scalars
+    REQUIRE(narrow_label - return_label == 1);
+    REQUIRE(wide_label - narrow_label == 2);
+    REQUIRE(call_label - wide_label == 6);
+    REQUIRE(context_label - call_label == 10);
+    REQUIRE(jump_label - context_label == 3);
+    REQUIRE(narrow_jump_label - jump_label == 5);
+    REQUIRE(wide_jump_label - narrow_jump_label == 6);
+    REQUIRE(end_label - wide_jump_label == 10);
+    REQUIRE(generator.GetLastEmmittedInstructionAddress() == wide_jump_label);
+
+    auto chunk = generator.Flush();
+    REQUIRE(chunk.bytecode.size() == static_cast<size_t>(end_label));
+
+    const auto instructions = DecodeInstructions(chunk.bytecode);
+    REQUIRE(instructions.size() == 8);
+    REQUIRE(instructions[0].opcode == Opcode::Return);
+    REQUIRE(instructions[1].opcode == Opcode::LoadRegister);
+    REQUIRE(instructions[1].reg == -128);
+    REQUIRE(instructions[2].opcode == Opcode::LoadRegister);
+    REQUIRE(instructions[2].reg == 300);
+    REQUIRE(instructions[3].opcode == Opcode::Call);
+    REQUIRE(instructions[3].reg_range.first == 200);
+    REQUIRE(instructions[3].reg_range.count == 2);
+    REQUIRE(instructions[4].context_descriptor.index == 1);
+    REQUIRE(instructions[4].context_descriptor.depth == 2);
+    REQUIRE(instructions[5].offset == return_label - narrow_jump_label);
+    REQUIRE(instructions[6].register_jump.reg == 3);
+    REQUIRE(instructions[6].register_jump.offset == end_label - wide_jump_label);
+    REQUIRE(instructions[7].opcode == Opcode::JumpIfNotEqual);
+    REQUIRE(instructions[7].register_jump.reg == -1000);
+    REQUIRE(instructions[7].register_jump.offset == narrow_label - end_label);
+
+    REQUIRE(BytecodeDisassembler::Disassemble(chunk) == nlang::UString(
+            "arguments: 1 registers: 2\n"
+            "\nReturn "
+            "\nLoadRegister -128"
+            "\nLoadRegister 300"
+            "\nCall 200 2"
+            "\nLoadContext 1 2"
+            "\nJump -27"
+            "\nJumpIfLess 3 10"
+            "\nJumpIfNotEqual -1000 -42"));
+}
\ No newline at end of file
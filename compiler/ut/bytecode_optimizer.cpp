@@ -0,0 +1,169 @@
+#include <catch2/catch.hpp>
+
+#include <compiler/bytecode_optimizer.hpp>
+#include <compiler/compiler.hpp>
+#include <compiler/module_loader.hpp>
+
+#include <interpreter/bytecode_function.hpp>
+#include <interpreter/objects/primitives.hpp>
+#include <interpreter/thread.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<nlang::bytecode::Opcode> GetOpcodes(const nlang::bytecode::BytecodeChunk& chunk) {
+    std::vector<nlang::bytecode::Opcode> opcodes;
+    for (const auto& instruction : nlang::bytecode::DecodeInstructions(chunk.bytecode)) {
+        opcodes.push_back(instruction.opcode);
+    }
+    return opcodes;
+}
+
+class CountingPass : public nlang::bytecode::IBytecodePass {
+public:
+    const char* GetName() const override {
+        return "counting";
+    }
+
+    size_t Run(std::vector<nlang::bytecode::OptimizedInstruction>& instructions,
+               nlang::bytecode::BytecodeChunk& chunk) override {
+        ++runs;
+        return 0;
+    }
+
+    int32_t runs = 0;
+};
+
+}
+
+TEST_CASE("bytecode optimizer passes") {
+    using namespace nlang;
+    using namespace nlang::bytecode;
+
+    BytecodeGenerator generator;
+    generator.SetArgumentsCount(1);
+    generator.SetRegistersCount(2);
+    // r0 = 3 - 1; r1 = r0; if (r1 < a0) r0 = r1 else r0 = a0; return r0
+    generator.EmitInstruction<Opcode::LoadNumber>(1);
+    generator.EmitInstruction<Opcode::StoreRegister>(1);
+    generator.EmitInstruction<Opcode::LoadNumber>(3);
+    generator.EmitInstruction<Opcode::Sub>(1);
+    generator.EmitInstruction<Opcode::StoreRegister>(0);
+    generator.EmitInstruction<Opcode::LoadRegister>(0);
+    generator.EmitInstruction<Opcode::StoreRegister>(1);
+    generator.EmitInstruction<Opcode::LoadRegister>(1);
+    auto else_jump = generator.EmitRegisterJump<Opcode::JumpIfNotLess>(-1);
+    generator.EmitInstruction<Opcode::LoadRegister>(1);
+    generator.EmitInstruction<Opcode::StoreRegister>(0);
+    auto end_jump = generator.EmitJump<Opcode::Jump>();
+    generator.UpdateJumpToHere(else_jump);
+    generator.EmitInstruction<Opcode::LoadRegister>(-1);
+    generator.EmitInstruction<Opcode::StoreRegister>(0);
+    auto return_jump = generator.EmitJump<Opcode::Jump>();
+    generator.UpdateJumpToHere(end_jump);
+    auto inner_jump = generator.EmitJump<Opcode::Jump>();
+    generator.UpdateJumpToHere(return_jump);
+    generator.UpdateJumpToHere(inner_jump);
+    generator.EmitInstruction<Opcode::LoadRegister>(0);
+    generator.EmitInstruction<Opcode::Return>();
+    generator.EmitInstruction<Opcode::LoadNull>();
+    generator.EmitInstruction<Opcode::Return>();
+
+    SECTION("all passes") {
+        auto chunk = generator.Flush();
+        BytecodeOptimizer optimizer;
+        optimizer.Optimize(chunk);
+
+        REQUIRE(GetOpcodes(chunk) == std::vector<Opcode> {
+            // r0 is stored in both branches, so only r1 is left
+            Opcode::LoadNumber, Opcode::StoreRegister,
+            Opcode::JumpIfNotLess,
+            Opcode::LoadRegister, Opcode::StoreRegister, Opcode::Jump,
+            Opcode::LoadRegister, Opcode::StoreRegister,
+            Opcode::LoadRegister, Opcode::Return,
+        });
+        REQUIRE(optimizer.GetChanges(BytecodeOptimizer::CONSTANT_FOLDING) == 1);
+        REQUIRE(optimizer.GetChanges(BytecodeOptimizer::REDUNDANT_LOAD_STORE_ELIMINATION) > 0);
+        REQUIRE(optimizer.GetChanges(BytecodeOptimizer::JUMP_THREADING) > 0);
+        REQUIRE(optimizer.GetChanges(BytecodeOptimizer::DEAD_CODE_ELIMINATION) == 2);
+
+        // offsets are laid out again
+        Heap heap;
+        auto function = BytecodeFunction::New(&heap, std::move(chunk));
+        for (double argument : { 1.0, 5.0 }) {
+            Handle<Value> arguments[] { Number::New(argument) };
+            Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 1, arguments);
+            REQUIRE(thread.Join().As<Number>()->Value() == (2 < argument ? 2 : argument));
+        }
+    }
+
+    SECTION("disabled passes") {
+        auto chunk = generator.Flush();
+        const auto original = chunk.bytecode;
+        BytecodeOptimizer::Options options;
+        options.fold_constants = false;
+        options.eliminate_redundant_loads_stores = false;
+        options.thread_jumps = false;
+        options.eliminate_dead_code = false;
+        BytecodeOptimizer optimizer(options);
+        auto counting = MakeUnique<CountingPass>();
+        auto& pass = *counting;
+        optimizer.AddPass(std::move(counting));
+        optimizer.Optimize(chunk);
+
+        REQUIRE(chunk.bytecode == original);
+        REQUIRE(pass.runs == 1);
+        REQUIRE(optimizer.GetStats().size() == 1);
+        REQUIRE(optimizer.GetStats()[0].name == "counting");
+        REQUIRE(optimizer.GetChanges(BytecodeOptimizer::DEAD_CODE_ELIMINATION) == 0);
+    }
+}
+
+TEST_CASE("optimized programs") {
+    using namespace nlang;
+
+    const std::vector<std::string> programs {
+        "let a = 2 * 3 + 4\n"
+        "let b = 0\n"
+        "let c = a\n"
+        "b = c\n"
+        "if (a > 5) {\n"
+        "    if (b < 100) {\n"
+        "        b = b + 1\n"
+        "    } else {\n"
+        "        b = b - 1\n"
+        "    }\n"
+        "} else {\n"
+        "    b = 0\n"
+        "}\n"
+        "while (b < 20) {\n"
+        "    b = b + 10 / 4\n"
+        "}\n"
+        "b\n",
+
+        "fn f(n) {\n"
+        "    if (n < 2) {\n"
+        "        return n\n"
+        "    }\n"
+        "    return f(n - 1) + f(n - 2)\n"
+        "}\n"
+        "f(15)\n",
+    };
+
+    Heap heap;
+    for (const auto& program : programs) {
+        auto module = ModuleLoader::LoadModule(Source::New(UString(program)));
+
+        Compiler optimizing_compiler;
+        auto optimized = optimizing_compiler.Compile(&heap, *module).As<BytecodeFunction>();
+        Compiler compiler({ false, false, false, false });
+        auto plain = compiler.Compile(&heap, *module).As<BytecodeFunction>();
+        REQUIRE(optimized->bytecode_chunk.bytecode.size() < plain->bytecode_chunk.bytecode.size());
+
+        Thread optimized_thread(&heap, Closure::New(&heap, Handle<Context>(), optimized), 0, nullptr);
+        Thread plain_thread(&heap, Closure::New(&heap, Handle<Context>(), plain), 0, nullptr);
+        REQUIRE(optimized_thread.Join().As<Number>()->Value() == plain_thread.Join().As<Number>()->Value());
+    }
+}
\ No newline at end of file
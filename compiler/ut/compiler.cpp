@@ -0,0 +1,417 @@
+#include <catch2/catch.hpp>
+
+#include <compiler/module_loader.hpp>
+
+#include <interpreter/bytecode_function.hpp>
+#include <interpreter/thread.hpp>
+
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+nlang::Handle<nlang::BytecodeFunction> Compile(nlang::Heap* heap, const std::string& text) {
+    using namespace nlang;
+
+    std::vector<UniquePtr<ast::Module>> modules;
+    modules.push_back(ModuleLoader::LoadModule(Source::New(UString(text))));
+    return ModuleLoader::Compile(heap, modules)[0].As<BytecodeFunction>();
+}
+
+}
+
+TEST_CASE("fused comparison and jump") {
+    using namespace nlang;
+    using namespace nlang::bytecode;
+
+    struct Case {
+        std::string condition;
+        double expected;
+    };
+    const std::vector<Case> cases {
+        { "i < 10", 10 }, { "i <= 10", 11 }, { "10 > i", 10 }, { "10 >= i", 11 },
+        { "i != 7", 7 }, { "i == 0", 1 }, { "i < 1 / 0", -1 },
+    };
+
+    Heap heap;
+    for (const auto& c : cases) {
+        // loop stops early, if condition is never false
+        auto function = Compile(&heap,
+                "let i = 0\n"
+                "while (" + c.condition + ") {\n"
+                "    i = i + 1\n"
+                "    if (i == 100) {\n"
+                "        i = 0 - 1\n"
+                "        return i\n"
+                "    }\n"
+                "}\n"
+                "i\n");
+
+        for (const auto& instruction : DecodeInstructions(function->bytecode_chunk.bytecode)) {
+            REQUIRE(instruction.opcode != Opcode::JumpIfFalse);
+            REQUIRE(instruction.opcode != Opcode::JumpIfTrue);
+            REQUIRE(instruction.opcode != Opcode::CheckEqual);
+            REQUIRE(instruction.opcode != Opcode::CheckLess);
+        }
+
+        Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+        REQUIRE(thread.Join().As<Number>()->Value() == c.expected);
+    }
+}
+
+TEST_CASE("fused comparison and jump with strings") {
+    using namespace nlang;
+
+    Heap heap;
+    auto function = Compile(&heap,
+            "let s = \"a\"\n"
+            "let n = 0\n"
+            "while (s < \"aaaa\") {\n"
+            "    s = s + \"a\"\n"
+            "    n = n + 1\n"
+            "}\n"
+            "if (s == \"aaaa\") {\n"
+            "    n = n + 10\n"
+            "}\n"
+            "n\n");
+
+    Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 13);
+}
+TEST_CASE("binary operations with local variables and constants") {
+    using namespace nlang;
+
+    struct Case {
+        std::string text;
+        double expected;
+        int32_t registers_count;
+    };
+    const std::vector<Case> cases {
+        // no temporaries
+        { "let a = 3\nlet b = 4\na - b\n", -1, 2 },
+        { "let a = 3\n2 * a + a\n", 9, 0 },
+        { "let a = 3\nlet b = 0\nif (2 < a) {\n    b = 1\n}\nb\n", 1, 2 },
+        // constant is loaded to a temporary before the left operand
+        { "let a = 3\na - 1\n", 2, 2 },
+        // left operand is evaluated first
+        { "let a = 1\na + (a = 5)\n", 6, 2 },
+        { "let a = 1\na * (a = 5)\n", 5, 0 },
+        { "let a = 2\nlet b = (a = 5) - a\nb\n", 0, 1 },
+        // + is not swapped, as it concatenates strings
+        { "let s = \"b\"\nlet r = 0\nif (\"a\" + s == \"ab\") {\n    r = 1\n}\nr\n", 1, 3 },
+    };
+
+    Heap heap;
+    for (const auto& c : cases) {
+        INFO(c.text);
+        auto function = Compile(&heap, c.text);
+        Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+        REQUIRE(thread.Join().As<Number>()->Value() == c.expected);
+        REQUIRE(function->bytecode_chunk.registers_count == c.registers_count);
+    }
+}
+TEST_CASE("register allocation") {
+    using namespace nlang;
+
+    struct Case {
+        std::string text;
+        double expected;
+        int32_t registers_count;
+    };
+    const std::vector<Case> cases {
+        // locals and temporaries with disjoint lifetimes share registers
+        {
+            "fn f(x) {\n"
+            "    let a = x * 2\n"
+            "    let b = a + 1\n"
+            "    let c = b * x\n"
+            "    return c\n"
+            "}\n"
+            "f(4)\n",
+            36, 2
+        },
+        // variables, used in the loop, are live in the whole loop, arguments of the calls stay consecutive
+        {
+            "fn g(n) {\n"
+            "    let s = 0\n"
+            "    let i = 0\n"
+            "    while (i < n) {\n"
+            "        let t = i * 2\n"
+            "        s = s + t\n"
+            "        i = i + 1\n"
+            "    }\n"
+            "    return s\n"
+            "}\n"
+            "fn h(a, b, c) {\n"
+            "    return a + b + c\n"
+            "}\n"
+            "h(g(4), h(1, g(2), 3), g(3))\n",
+            24, 3
+        },
+        // arguments are in order of declaration, windows are above the values, which are live after the calls
+        {
+            "fn sub(a, b) {\n"
+            "    return a - b\n"
+            "}\n"
+            "let x = 100\n"
+            "let y = sub(10, 3)\n"
+            "x + sub(y, sub(4, 1))\n",
+            104, 0
+        },
+    };
+
+    Heap heap;
+    for (const auto& c : cases) {
+        INFO(c.text);
+        auto function = Compile(&heap, c.text);
+        Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+        REQUIRE(thread.Join().As<Number>()->Value() == c.expected);
+        const auto& callee = function->bytecode_chunk.constant_pool[0].As<BytecodeFunction>()->bytecode_chunk;
+        REQUIRE(callee.registers_count == c.registers_count);
+    }
+}
+TEST_CASE("tail calls") {
+    using namespace nlang;
+    using namespace nlang::bytecode;
+
+    Heap heap;
+    // recursion is deeper than the stack, so it works only with the frames reused
+    auto function = Compile(&heap,
+            "fn sum(n, acc) {\n"
+            "    if (n == 0) {\n"
+            "        return acc\n"
+            "    }\n"
+            "    return sum(n - 1, acc + n)\n"
+            "}\n"
+            "fn is_even(n) {\n"
+            "    if (n == 0) {\n"
+            "        return true\n"
+            "    }\n"
+            "    return is_odd(n - 1)\n"
+            "}\n"
+            "fn is_odd(n) {\n"
+            "    if (n == 0) {\n"
+            "        return false\n"
+            "    }\n"
+            "    return is_even(n - 1)\n"
+            "}\n"
+            "let odd = 0\n"
+            "if (is_odd(1000001)) {\n"
+            "    odd = 1\n"
+            "}\n"
+            "sum(1000000, odd)\n");
+
+    // call in the return statement ends the function
+    for (const auto& constant : function->bytecode_chunk.constant_pool) {
+        auto instructions = DecodeInstructions(constant.As<BytecodeFunction>()->bytecode_chunk.bytecode);
+        REQUIRE(instructions.back().opcode == Opcode::TailCall);
+        for (const auto& instruction : instructions) {
+            REQUIRE(instruction.opcode != Opcode::Call);
+        }
+    }
+
+    Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 500000500001.0);
+}
+TEST_CASE("stack overflow") {
+    using namespace nlang;
+
+    auto program = [](const std::string& n) {
+        return
+            "fn depth(n) {\n"
+            "    if (n == 0) {\n"
+            "        return 0\n"
+            "    }\n"
+            "    return depth(n - 1) + 1\n"
+            "}\n"
+            "depth(" + n + ")\n";
+    };
+    const size_t stack_size = 64 * 1024;
+
+    Heap heap;
+    // stack grows on demand up to its size
+    Thread thread(&heap, Closure::New(&heap, Handle<Context>(), Compile(&heap, program("500"))), 0, nullptr, stack_size);
+    REQUIRE(thread.Join().As<Number>()->Value() == 500);
+
+    Thread overflowing_thread(&heap, Closure::New(&heap, Handle<Context>(), Compile(&heap, program("1000000"))), 0, nullptr, stack_size);
+    REQUIRE_THROWS_AS(overflowing_thread.Join(), StackOverflowError);
+
+    // missing arguments are cleared above the committed part of the stack
+    auto omitting_program = [](const std::string& n) {
+        return
+            "fn depth(n, p0, p1, p2, p3, p4, p5, p6, p7) {\n"
+            "    if (n == 0) {\n"
+            "        return 0\n"
+            "    }\n"
+            "    let r = 1 + depth(n - 1)\n"
+            "    return r\n"
+            "}\n"
+            "depth(" + n + ")\n";
+    };
+    Thread omitting_thread(&heap, Closure::New(&heap, Handle<Context>(), Compile(&heap, omitting_program("200"))), 0, nullptr, stack_size);
+    REQUIRE(omitting_thread.Join().As<Number>()->Value() == 200);
+
+    Thread omitting_overflowing_thread(&heap, Closure::New(&heap, Handle<Context>(), Compile(&heap, omitting_program("1000000"))), 0, nullptr, stack_size);
+    REQUIRE_THROWS_AS(omitting_overflowing_thread.Join(), StackOverflowError);
+
+    // stack, which can't be reserved, is reported to the caller
+    REQUIRE_THROWS_AS(Thread(&heap, Closure::New(&heap, Handle<Context>(), Compile(&heap, program("1"))), 0, nullptr, size_t(1) << 62), std::bad_alloc);
+}
+TEST_CASE("allocation-triggered garbage collection") {
+    using namespace nlang;
+
+    GCPolicy policy;
+    policy.initial_threshold = 256;
+    // old generation only, so the full collections are triggered
+    policy.nursery_size = 0;
+    Heap heap(policy);
+
+    // each iteration allocates a context and a closure, the previous ones are garbage
+    auto function = Compile(&heap,
+            "let s = 0\n"
+            "let i = 0\n"
+            "while (i < 10000) {\n"
+            "    let k = i\n"
+            "    fn get() {\n"
+            "        return k\n"
+            "    }\n"
+            "    s = s + get()\n"
+            "    i = i + 1\n"
+            "}\n"
+            "s\n");
+
+    Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 49995000);
+    REQUIRE(heap.GetCollectionsCount() > 0);
+    REQUIRE(heap.GetSize() < 2 * policy.initial_threshold);
+
+    // compiled functions are persistent roots, so the function can be run again after the collections
+    Thread second_thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+    REQUIRE(second_thread.Join().As<Number>()->Value() == 49995000);
+}
+
+TEST_CASE("dropped modules are collected") {
+    using namespace nlang;
+
+    Heap heap;
+    // a module per request, e.g. in a service, which runs scripts for a long time
+    for (size_t i = 0; i < 100; ++i) {
+        auto function = Compile(&heap,
+                "fn get(n) {\n"
+                "    let s = 'string constant'\n"
+                "    return n + " + std::to_string(i) + "\n"
+                "}\n"
+                "get(1)\n");
+        Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+        REQUIRE(thread.Join().As<Number>()->Value() == i + 1);
+        heap.RemoveRoot(function);
+    }
+
+    heap.Collect();
+    REQUIRE(heap.GetSize() == 0);
+}
+
+TEST_CASE("values of running threads survive garbage collection") {
+    using namespace nlang;
+
+    GCPolicy policy;
+    policy.initial_threshold = 64;
+    // young values of the frames are promoted by the minor collections
+    policy.nursery_size = 4096;
+    Heap heap(policy);
+
+    // closures of the outer calls are referenced only by the frames and registers, while the inner ones allocate
+    auto function = Compile(&heap,
+            "fn make(n) {\n"
+            "    let k = n\n"
+            "    fn get() {\n"
+            "        return k\n"
+            "    }\n"
+            "    return get\n"
+            "}\n"
+            "fn sum(n) {\n"
+            "    if (n == 0) {\n"
+            "        return 0\n"
+            "    }\n"
+            "    let g = make(n)\n"
+            "    let rest = sum(n - 1)\n"
+            "    return g() + rest\n"
+            "}\n"
+            "sum(1000)\n");
+
+    Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 500500);
+    REQUIRE(heap.GetYoungCollectionsCount() > 0);
+    REQUIRE(heap.GetPromotedCount() > 0);
+    REQUIRE(heap.GetCollectionsCount() > 0);
+}
+
+TEST_CASE("short-lived values die in the nursery") {
+    using namespace nlang;
+
+    Heap heap;
+
+    auto function = Compile(&heap,
+            "let s = 0\n"
+            "let i = 0\n"
+            "while (i < 100000) {\n"
+            "    let k = i\n"
+            "    fn get() {\n"
+            "        return k\n"
+            "    }\n"
+            "    s = s + get()\n"
+            "    i = i + 1\n"
+            "}\n"
+            "s\n");
+
+    Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 4999950000);
+    REQUIRE(heap.GetYoungCollectionsCount() > 0);
+    // only the values, which are live at the minor collections, are promoted
+    REQUIRE(heap.GetPromotedCount() < heap.GetYoungCollectionsCount() * 16);
+    REQUIRE(heap.GetCollectionsCount() == 0);
+}
+
+TEST_CASE("incremental marking of running threads") {
+    using namespace nlang;
+
+    GCPolicy policy;
+    policy.initial_threshold = 64;
+    policy.nursery_size = 4096;
+    // each step marks the least possible values, so the marking spans many safepoints
+    policy.step_budget = std::chrono::nanoseconds(1);
+    policy.step_interval = 16;
+    Heap heap(policy);
+
+    // frames and registers don't pass the write barrier, closures of the outer calls are referenced only by them
+    auto function = Compile(&heap,
+            "fn make(n) {\n"
+            "    let k = n\n"
+            "    fn get() {\n"
+            "        return k\n"
+            "    }\n"
+            "    return get\n"
+            "}\n"
+            "fn sum(n) {\n"
+            "    if (n == 0) {\n"
+            "        return 0\n"
+            "    }\n"
+            "    let g = make(n)\n"
+            "    let rest = sum(n - 1)\n"
+            "    return g() + rest\n"
+            "}\n"
+            "let s = 0\n"
+            "let i = 0\n"
+            "while (i < 20) {\n"
+            "    s = s + sum(1000)\n"
+            "    i = i + 1\n"
+            "}\n"
+            "s\n");
+
+    Thread thread(&heap, Closure::New(&heap, Handle<Context>(), function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 20 * 500500);
+    REQUIRE(heap.GetCollectionsCount() > 0);
+    // each requested collection is a pause
+    REQUIRE(heap.GetPauses().GetCount() == heap.GetYoungCollectionsCount());
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+
+#include <compiler/module_loader.hpp>
+
+#include <interpreter/thread.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+/**
+ * Modules, written to a temporary directory of the test
+ * The directory has a random name, so tests, which run concurrently, don't share files. It is removed with the
+ * modules, when the test leaves the scope, even if it fails.
+ */
+class TempModules {
+public:
+    /**
+     * Writes the modules
+     * @param name Name of the test, is a prefix of the directory
+     * @param sources Sources of the modules
+     */
+    TempModules(const std::string& name, const std::vector<std::string>& sources)
+        : directory(std::filesystem::temp_directory_path() / (name + "_" + std::to_string(std::random_device()())))
+    {
+        std::filesystem::create_directories(directory);
+        for (size_t i = 0; i < sources.size(); ++i) {
+            const auto path = directory / ("module_" + std::to_string(i) + ".nl");
+            std::ofstream(path, std::ios::binary) << sources[i];
+            paths.push_back(path.string());
+        }
+    }
+
+    TempModules(const TempModules&) = delete;
+    TempModules& operator=(const TempModules&) = delete;
+
+    ~TempModules() {
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+
+    const std::filesystem::path directory;
+    std::vector<std::string> paths;
+};
+
+}
+
+TEST_CASE("module loader") {
+    using namespace nlang;
+
+    std::vector<std::string> sources;
+    for (int i = 0; i < 64; ++i) {
+        sources.push_back("fn f(n) {\n    return n * 2\n}\nlet x = " + std::to_string(i) + "\nf(x) + 1\n");
+    }
+    const TempModules temp_modules("nlang_module_loader_test", sources);
+    const auto& paths = temp_modules.paths;
+
+    Heap heap;
+    ModuleLoader loader(4);
+    const auto modules = loader.Load(paths);
+    REQUIRE(modules.size() == paths.size());
+    for (size_t i = 0; i < modules.size(); ++i) {
+        REQUIRE(ast::ASTStringifier().Stringify(*modules[i]) ==
+                ast::ASTStringifier().Stringify(*ModuleLoader::LoadModule(Source::FromFile(paths[i]))));
+    }
+
+    const auto functions = ModuleLoader::Compile(&heap, modules);
+    REQUIRE(functions.size() == modules.size());
+    for (size_t i = 0; i < functions.size(); ++i) {
+        Thread thread(&heap, Closure::New(&heap, Handle<Context>(), functions[i]), 0, nullptr);
+        REQUIRE(thread.Join().As<Number>()->Value() == i * 2 + 1);
+    }
+}
+
+TEST_CASE("module loader errors") {
+    using namespace nlang;
+
+    const TempModules temp_modules("nlang_module_loader_errors_test", { "let a = 1\n", "let = 2\n", "let c = 3\n", "fn (\n" });
+    const auto& paths = temp_modules.paths;
+
+    ModuleLoader loader(2);
+    REQUIRE_THROWS_AS(loader.Load(paths), std::runtime_error);
+    REQUIRE_THROWS_AS(loader.Load({ paths[0], (temp_modules.directory / "missing.nl").string() }), std::runtime_error);
+}
\ No newline at end of file
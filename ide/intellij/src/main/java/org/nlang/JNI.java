@@ -1,7 +1,5 @@
 package org.nlang;
 
-import java.lang.CharSequence;
-import java.util.TreeMap;
 import java.net.URL;
 import java.io.File;
 import java.io.InputStream;
@@ -36,5 +34,18 @@ class JNI {
         } catch (IOException e) {}
     }
 
-    public static native void tokenize(CharSequence source, int start, int end, TreeMap<Integer, String> tokens);
+    /**
+     * Returns names of native tokens, indexed by token id
+     */
+    public static native String[] getTokenNames();
+
+    public static native long createSession();
+    public static native void destroySession(long session);
+
+    /**
+     * Replaces [start, end) range of the session document and rescans affected tokens.
+     * Returns first changed token index, number of removed tokens, number of inserted tokens,
+     * then (start offset, token id) pairs of inserted tokens.
+     */
+    public static native int[] edit(long session, int start, int end, String replacement);
 }
\ No newline at end of file
@@ -1,15 +1,14 @@
 package org.nlang;
 
-import java.util.Map;
-import java.util.TreeMap;
-
 public class Main {
     public static void main(String[] args) {
-        TreeMap<Integer, String> m = new TreeMap<>();
+        String[] names = JNI.getTokenNames();
+        long session = JNI.createSession();
         String s = "kek лул \"asdfas\"\"\"\" kek";
-        JNI.tokenize(s, 0, s.length(), m);
-        for (Map.Entry<Integer, String> e : m.entrySet()) {
-            System.out.println(e.getKey() + " " + e.getValue());
+        int[] patch = JNI.edit(session, 0, 0, s);
+        for (int i = 0; i < patch[2]; ++i) {
+            System.out.println(patch[3 + 2 * i] + " " + names[patch[4 + 2 * i]]);
         }
+        JNI.destroySession(session);
     }
 }
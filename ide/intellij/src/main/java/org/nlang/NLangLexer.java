@@ -2,31 +2,42 @@ package org.nlang;
 
 import com.intellij.lexer.Lexer;
 import com.intellij.lexer.LexerPosition;
-import com.intellij.psi.TokenType;
 import com.intellij.psi.tree.IElementType;
 import org.jetbrains.annotations.NotNull;
 import org.jetbrains.annotations.Nullable;
 
-import java.util.Map;
-import java.util.TreeMap;
+import java.util.Arrays;
 
 public class NLangLexer extends Lexer {
-    private CharSequence charSequence;
+    private static final NLangToken[] TOKEN_TYPES;
+
+    static {
+        String[] names = JNI.getTokenNames();
+        TOKEN_TYPES = new NLangToken[names.length];
+        for (int i = 0; i < names.length; ++i) {
+            TOKEN_TYPES[i] = new NLangToken(names[i]);
+        }
+    }
 
-    private TreeMap<Integer, IElementType> tokens = new TreeMap<>();
-    private int currentTokenPos;
+    // native session keeps tokens of the previous text, so only the edited part is rescanned
+    private final long session = JNI.createSession();
+    private String text = "";
+    private int[] tokenStarts = new int[0];
+    private int[] tokenTypes = new int[0];
+    private int tokensCount = 0;
+
+    private CharSequence charSequence;
+    private int startOffset;
+    private int endOffset;
+    private int currentToken;
 
     @Override
     public void start(@NotNull CharSequence buffer, int startOffset, int endOffset, int initialState) {
         charSequence = buffer;
-        currentTokenPos = startOffset;
-
-        tokens.clear();
-        TreeMap<Integer, String> m = new TreeMap<>();
-        JNI.tokenize(charSequence, 0, buffer.length(), m);
-        for (Map.Entry<Integer, String> entry : m.entrySet()) {
-            tokens.put(entry.getKey(), new NLangToken(entry.getValue()));
-        }
+        this.startOffset = startOffset;
+        this.endOffset = endOffset;
+        update(buffer);
+        currentToken = findToken(startOffset);
     }
 
     @Override
@@ -37,31 +48,31 @@ public class NLangLexer extends Lexer {
     @Nullable
     @Override
     public IElementType getTokenType() {
-        return currentTokenPos < charSequence.length() ? tokens.get(currentTokenPos) : null;
+        return currentToken < tokensCount && getTokenStart() < endOffset ? TOKEN_TYPES[tokenTypes[currentToken]] : null;
     }
 
     @Override
     public int getTokenStart() {
-        return currentTokenPos;
+        return currentToken < tokensCount ? Math.max(tokenStarts[currentToken], startOffset) : endOffset;
     }
 
     @Override
     public int getTokenEnd() {
-        Integer k = tokens.higherKey(currentTokenPos);
-        return k == null ? charSequence.length() : k;
+        return currentToken + 1 < tokensCount ? Math.min(tokenStarts[currentToken + 1], endOffset) : endOffset;
     }
 
     @Override
     public void advance() {
-        Integer k = tokens.higherKey(currentTokenPos);
-        currentTokenPos = k == null ? charSequence.length() : k;
+        if (currentToken < tokensCount) {
+            ++currentToken;
+        }
     }
 
     @NotNull
     @Override
     public LexerPosition getCurrentPosition() {
         return new LexerPosition() {
-            private int offset = currentTokenPos;
+            private int offset = getTokenStart();
 
             @Override
             public int getOffset() {
@@ -77,7 +88,7 @@ public class NLangLexer extends Lexer {
 
     @Override
     public void restore(@NotNull LexerPosition position) {
-        currentTokenPos = position.getOffset();
+        currentToken = findToken(position.getOffset());
     }
 
     @NotNull
@@ -88,6 +99,70 @@ public class NLangLexer extends Lexer {
 
     @Override
     public int getBufferEnd() {
-        return charSequence.length();
+        return endOffset;
+    }
+
+    @Override
+    protected void finalize() throws Throwable {
+        JNI.destroySession(session);
+        super.finalize();
+    }
+
+    /**
+     * Finds the changed range between previous and new text and sends only it to the native session
+     */
+    private void update(CharSequence buffer) {
+        int oldLength = text.length();
+        int newLength = buffer.length();
+
+        int prefix = 0;
+        int maxPrefix = Math.min(oldLength, newLength);
+        while (prefix < maxPrefix && buffer.charAt(prefix) == text.charAt(prefix)) {
+            ++prefix;
+        }
+        int suffix = 0;
+        int maxSuffix = maxPrefix - prefix;
+        while (suffix < maxSuffix && buffer.charAt(newLength - suffix - 1) == text.charAt(oldLength - suffix - 1)) {
+            ++suffix;
+        }
+        if (prefix == oldLength && prefix == newLength) {
+            return;
+        }
+
+        String replacement = buffer.subSequence(prefix, newLength - suffix).toString();
+        applyPatch(JNI.edit(session, prefix, oldLength - suffix, replacement), newLength - oldLength);
+        text = buffer.toString();
+    }
+
+    private void applyPatch(int[] patch, int delta) {
+        int first = patch[0];
+        int removed = patch[1];
+        int inserted = patch[2];
+        int count = tokensCount - removed + inserted;
+
+        int[] starts = new int[count];
+        int[] types = new int[count];
+        System.arraycopy(tokenStarts, 0, starts, 0, first);
+        System.arraycopy(tokenTypes, 0, types, 0, first);
+        for (int i = 0; i < inserted; ++i) {
+            starts[first + i] = patch[3 + 2 * i];
+            types[first + i] = patch[4 + 2 * i];
+        }
+        for (int i = first + removed, j = first + inserted; i < tokensCount; ++i, ++j) {
+            starts[j] = tokenStarts[i] + delta;
+            types[j] = tokenTypes[i];
+        }
+
+        tokenStarts = starts;
+        tokenTypes = types;
+        tokensCount = count;
+    }
+
+    /**
+     * Finds index of the token, that contains the offset
+     */
+    private int findToken(int offset) {
+        int index = Arrays.binarySearch(tokenStarts, 0, tokensCount, offset);
+        return index >= 0 ? index : Math.max(-index - 2, 0);
     }
 }
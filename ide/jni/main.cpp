@@ -4,37 +4,65 @@
 
 #include "org_nlang_JNI.h"
 
-#include <parser/scanner.hpp>
+#include <parser/lexing_session.hpp>
 
 #include <jni.h>
 #include <cstdint>
 #include <string>
 #include <vector>
-#include <iostream>
 
 
-extern "C" JNIEXPORT void JNICALL Java_org_nlang_JNI_tokenize(JNIEnv* env, jclass, jobject source, jint start, jint end, jobject tokens_map) {
-    jclass CharSequence_class = env->FindClass("java/lang/CharSequence");
-    //jmethodID CharSequence_length = env->GetMethodID(CharSequence_class, "length", "()I");
-    jmethodID CharSequence_charAt = env->GetMethodID(CharSequence_class, "charAt", "(I)C");
+extern "C" JNIEXPORT jobjectArray JNICALL Java_org_nlang_JNI_getTokenNames(JNIEnv* env, jclass) {
+    const std::vector<nlang::Token> tokens {
+#define T(token, value) nlang::Token::token,
+        TOKENS_LIST
+#undef T
+    };
 
-    jclass TreeMap_class = env->FindClass("java/util/TreeMap");
-    jmethodID TreeMap_put = env->GetMethodID(TreeMap_class, "put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+    jclass String_class = env->FindClass("java/lang/String");
+    jobjectArray names = env->NewObjectArray((jsize)tokens.size(), String_class, nullptr);
+    for (auto token : tokens) {
+        jstring name = env->NewStringUTF(nlang::TokenUtils::GetTokenName(token).GetStdStr().c_str());
+        env->SetObjectArrayElement(names, (jsize)token, name);
+        env->DeleteLocalRef(name);
+    }
+    return names;
+}
 
-    //gjint length = env->CallIntMethod(source, CharSequence_length);
+extern "C" JNIEXPORT jlong JNICALL Java_org_nlang_JNI_createSession(JNIEnv*, jclass) {
+    return (jlong)(intptr_t)nlang::LexingSession::New().release();
+}
 
-    icu::UnicodeString s(end - start, 0, 0);
-    for (jint i = start; i < end; ++i) {
-        jchar code = env->CallCharMethod(source, CharSequence_charAt, i);
-        s.append((char16_t)code);
-    }
+extern "C" JNIEXPORT void JNICALL Java_org_nlang_JNI_destroySession(JNIEnv*, jclass, jlong session) {
+    delete (nlang::LexingSession*)(intptr_t)session;
+}
+
+/**
+ * Replaces [start, end) range of the session document and rescans affected tokens.
+ * Returns the patch as a single array: first changed token index, number of removed tokens, number of inserted
+ * tokens, then (start offset, token) pairs of inserted tokens.
+ */
+extern "C" JNIEXPORT jintArray JNICALL Java_org_nlang_JNI_edit(JNIEnv* env, jclass, jlong session_handle, jint start, jint end, jstring replacement) {
+    auto session = (nlang::LexingSession*)(intptr_t)session_handle;
 
-    jclass Integer_class = env->FindClass("java/lang/Integer");
-    jmethodID Integer_init = env->GetMethodID(Integer_class, "<init>", "(I)V");
+    const jsize replacement_length = env->GetStringLength(replacement);
+    std::u16string text(replacement_length, u'\0');
+    env->GetStringRegion(replacement, 0, replacement_length, (jchar*)text.data());
 
-    auto sc = nlang::Scanner::New(nlang::TokenStream::New(nlang::UString(std::move(s))));
-    while (sc->NextTokenLookahead().token != nlang::Token::THE_EOF) {
-        auto& token = sc->NextToken();
-        env->CallObjectMethod(tokens_map, TreeMap_put, env->NewObject(Integer_class, Integer_init, (jint)token.pos), env->NewStringUTF(nlang::TokenUtils::GetTokenName(token.token).GetStdStr().c_str()));
+    const auto patch = session->Edit(start, end, text);
+
+    std::vector<jint> result;
+    result.reserve(3 + patch.inserted * 2);
+    result.push_back((jint)patch.first);
+    result.push_back((jint)patch.removed);
+    result.push_back((jint)patch.inserted);
+    const auto& tokens = session->GetTokens();
+    for (size_t i = patch.first; i < patch.first + patch.inserted; ++i) {
+        result.push_back(tokens[i].pos);
+        result.push_back((jint)tokens[i].token);
     }
+
+    jintArray array = env->NewIntArray((jsize)result.size());
+    env->SetIntArrayRegion(array, 0, (jsize)result.size(), result.data());
+    return array;
 }
@@ -9,11 +9,35 @@ extern "C" {
 #endif
 /*
  * Class:     org_nlang_JNI
- * Method:    tokenize
- * Signature: (Ljava/lang/CharSequence;IILjava/util/TreeMap;)V
+ * Method:    getTokenNames
+ * Signature: ()[Ljava/lang/String;
  */
-JNIEXPORT void JNICALL Java_org_nlang_JNI_tokenize
-  (JNIEnv *, jclass, jobject, jint, jint, jobject);
+JNIEXPORT jobjectArray JNICALL Java_org_nlang_JNI_getTokenNames
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_nlang_JNI
+ * Method:    createSession
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_org_nlang_JNI_createSession
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_nlang_JNI
+ * Method:    destroySession
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_org_nlang_JNI_destroySession
+  (JNIEnv *, jclass, jlong);
+
+/*
+ * Class:     org_nlang_JNI
+ * Method:    edit
+ * Signature: (JIILjava/lang/String;)[I
+ */
+JNIEXPORT jintArray JNICALL Java_org_nlang_JNI_edit
+  (JNIEnv *, jclass, jlong, jint, jint, jstring);
 
 #ifdef __cplusplus
 }
@@ -5,6 +5,12 @@
 
 #include <compiler/bytecode.hpp>
 
+#include <utils/macro.hpp>
+
+#if defined(NLANG_HAS_COMPUTED_GOTO) && !defined(NLANG_DISABLE_COMPUTED_GOTO)
+#define NLANG_USE_COMPUTED_GOTO
+#endif
+
 namespace nlang {
 
 /**
@@ -14,171 +20,359 @@ namespace nlang {
 class BytecodeExecutor {
 public:
     /**
-     * Executes bytecode in given thread
+     * Executes bytecode in given thread.
+     * Instruction pointer, registers of the current frame and accumulator are kept in locals and are written back to
+     * the thread only before calls, returns and allocations. Instructions, which allocate, and back-edges of loops are
+     * GC safepoints: if the heap requested the collection, it is performed there.
+     * Dispatch is direct-threaded (computed goto), where the compiler supports it, and falls back to switch otherwise.
+     * Each handler decodes its narrow operands with the layout and advances by the size, known at compile time. Wide
+     * prefix decodes the wide operands, moves ip so that the narrow size leads to the end of the instruction and jumps
+     * into the handler past its decoding. Jump offsets are relative to the end of the instruction.
+     * Arithmetic and comparison instructions are quickened: they are rewritten in the bytecode chunk to the Number
+     * versions, which don't check types of the operands beyond a guard. Wide instructions are never quickened. Chunks
+     * are not synchronized, so a function must not be executed by several threads at once.
+     * TailCall of a bytecode function reuses the frame of the current one, so tail recursion runs in constant stack.
      * @param thread The thread
      */
     static void Execute(Thread* thread) {
         using namespace bytecode;
-        while (true) {
-            switch (thread->ip->opcode) {
-                case Opcode::LoadRegister: {
-                    thread->acc = thread->sp->registers[thread->ip->reg];
-                    break;
-                }
-                case Opcode::StoreRegister: {
-                    thread->sp->registers[thread->ip->reg] = thread->acc;
-                    break;
-                }
-                case Opcode::Add: {
-                    if (thread->acc.Is<Number>() && thread->sp->registers[thread->ip->reg].Is<Number>())
-                        thread->acc = Number::New(thread->acc.As<Number>()->Value() + thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    else if (thread->acc.Is<String>() && thread->sp->registers[thread->ip->reg].Is<String>())
-                        thread->acc = String::New(thread->heap, *thread->acc.As<String>(), *thread->sp->registers[thread->ip->reg].As<String>());
-                    else if (thread->acc.Is<String>()) {
-                        thread->acc = String::New(thread->heap, *thread->acc.As<String>(), std::to_string(thread->sp->registers[thread->ip->reg].As<Number>()->Value()));
-                    }
-                    else {
-                        thread->acc = String::New(thread->heap, std::to_string(thread->sp->registers[thread->ip->reg].As<Number>()->Value()), *thread->acc.As<String>());
-                    }
-                    break;
-                }
-                case Opcode::Sub: {
-                    thread->acc = Number::New(thread->acc.As<Number>()->Value() - thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    break;
-                }
-                case Opcode::Mul: {
-                    thread->acc = Number::New(thread->acc.As<Number>()->Value() * thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    break;
-                }
-                case Opcode::Div: {
-                    thread->acc = Number::New(thread->acc.As<Number>()->Value() / thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    break;
-                }
-                case Opcode::CheckEqual: {
-                    thread->acc = Bool::New(thread->acc.As<Number>()->Value() == thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    break;
-                }
-                case Opcode::CheckNotEqual: {
-                    thread->acc = Bool::New(thread->acc.As<Number>()->Value() != thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    break;
-                }
-                case Opcode::CheckGreater: {
-                    thread->acc = Bool::New(thread->acc.As<Number>()->Value() > thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    break;
-                }
-                case Opcode::CheckGreaterOrEqual: {
-                    thread->acc = Bool::New(
-                        thread->acc.As<Number>()->Value() == thread->sp->registers[thread->ip->reg].As<Number>()->Value() ||
-                        thread->acc.As<Number>()->Value() > thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    break;
-                }
-                case Opcode::CheckLess: {
-                    thread->acc = Bool::New(thread->acc.As<Number>()->Value() < thread->sp->registers[thread->ip->reg].As<Number>()->Value());
-                    break;
-                }
-                case Opcode::CheckLessOrEqual: {
-                    thread->acc = Bool::New(
-                        thread->acc.As<Number>()->Value() == thread->sp->registers[thread->ip->reg].As<Number>()->Value() ||
-                        thread->acc.As<Number>()->Value() < thread->sp->registers[thread->ip->reg].As<Number>()->Value()
-                    );
-                    break;
-                }
-                case Opcode::DeclareContext: {
-                    thread->sp->context->Declare({ thread->ip->context_descriptor.index, thread->ip->context_descriptor.depth });
-                    break;
-                }
-                case Opcode::LoadContext: {
-                    thread->acc = thread->sp->context->Load({ thread->ip->context_descriptor.index, thread->ip->context_descriptor.depth });
-                    break;
-                }
-                case Opcode::StoreContext: {
-                    thread->sp->context->Store({ thread->ip->context_descriptor.index, thread->ip->context_descriptor.depth }, thread->acc);
-                    break;
-                }
-                case Opcode::LoadConstant: {
-                    thread->acc = thread->sp->function.As<BytecodeFunction>()->bytecode_chunk.constant_pool[thread->ip->const_index];
-                    break;
-                }
-                case Opcode::Call: {
-                    thread->acc.As<Closure>()->Call(thread, thread->ip->reg_range.count, thread->sp->registers + thread->ip->reg_range.first);
-                    continue;
-                }
-                case Opcode::Jump: {
-                    thread->ip += thread->ip->offset;
-                    continue;
-                }
-                case Opcode::JumpIfTrue: {
-                    if (thread->acc.Is<Bool>() && thread->acc.As<Bool>()->Value()) {
-                        thread->ip += thread->ip->offset;
-                        continue;
-                    }
-                    if (thread->acc.Is<Number>() && thread->acc.As<Number>()->Value() != 0.0) {
-                        thread->ip += thread->ip->offset;
-                        continue;
-                    }
-                    if (thread->acc.Is<String>() && thread->acc.As<String>()->GetLength() != 0) {
-                        thread->ip += thread->ip->offset;
-                        continue;
-                    }
-                    break;
-                }
-                case Opcode::JumpIfFalse: {
-                    if (thread->acc.Is<Bool>() && !thread->acc.As<Bool>()->Value()) {
-                        thread->ip += thread->ip->offset;
-                        continue;
-                    }
-                    if (thread->acc.Is<Number>() && thread->acc.As<Number>()->Value() == 0.0) {
-                        thread->ip += thread->ip->offset;
-                        continue;
-                    }
-                    if (thread->acc.Is<String>() && thread->acc.As<String>()->GetLength() == 0) {
-                        thread->ip += thread->ip->offset;
-                        continue;
-                    }
-                    break;
+
+#ifdef NLANG_USE_COMPUTED_GOTO
+#if defined(NLANG_COMPILER_GCC) || defined(NLANG_COMPILER_CLANG)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+        static void* const dispatch_table[] = {
+#define O(op, OperandType) &&target_##op,
+            OPCODES
+#undef O
+        };
+        // handlers without operand decoding, used after Wide prefix
+        static void* const body_table[] = {
+#define O(op, OperandType) &&body_##op,
+            OPCODES
+#undef O
+        };
+#define NLANG_DECODE(op) case Opcode::op: target_##op: ReadNarrowOperands<Opcode::op>(ip, operand0, operand1);
+#define NLANG_DISPATCH() goto *dispatch_table[*ip]
+#else
+#define NLANG_DECODE(op) case Opcode::op: ReadNarrowOperands<Opcode::op>(ip, operand0, operand1);
+#define NLANG_DISPATCH() goto dispatch
+#endif
+// body of the handler is the if statement, so the size is in scope of it
+#define NLANG_BODY(op) body_##op: \
+            if ([[maybe_unused]] constexpr size_t instruction_size = GetInstructionSize(OpcodeTraits<Opcode::op>::format, false); true)
+#define NLANG_TARGET(op) NLANG_DECODE(op) NLANG_BODY(op)
+#define NLANG_END() (ip + instruction_size)
+#define NLANG_NEXT() do { ip = NLANG_END(); NLANG_DISPATCH(); } while (0)
+#define NLANG_SYNC() do { thread->ip = ip; thread->acc = acc; } while (0)
+// Collects the garbage, if the heap requested it. Values of the executor are written back first, so they are roots.
+#define NLANG_SAFEPOINT()                                                               \
+            do {                                                                        \
+                if (NLANG_UNLIKELY(heap->IsCollectionRequested())) {                    \
+                    NLANG_SYNC();                                                       \
+                    heap->CollectRequested();                                           \
+                }                                                                       \
+            } while (0)
+// Back-edge of a loop is a safepoint, so loops, which allocate in native functions, don't grow the heap forever
+#define NLANG_JUMP(offset)                                                              \
+            do {                                                                        \
+                if ((offset) < 0) {                                                     \
+                    NLANG_SAFEPOINT();                                                  \
+                }                                                                       \
+                ip = NLANG_END() + (offset);                                            \
+                NLANG_DISPATCH();                                                       \
+            } while (0)
+// Generic instruction is rewritten to its quickened version, when both operands are numbers, and is executed again.
+// Quickened instruction checks that operands are still numbers, otherwise it is rewritten back and the generic one is
+// executed, so a polymorphic site just switches between the versions. Guard of both operands is a single branch.
+// Wide generic instruction enters past the quickening, as ip of it doesn't point to the opcode.
+#define NLANG_QUICKENED_BINARY(generic, quickened, expression)                          \
+            NLANG_DECODE(generic) {                                                     \
+                if (acc.Is<Number>() && registers[operand0].Is<Number>()) {             \
+                    *ip = static_cast<uint8_t>(Opcode::quickened);                      \
+                    NLANG_DISPATCH();                                                   \
+                }                                                                       \
+            }                                                                           \
+            NLANG_BODY(generic) {                                                       \
+                const Handle<Value> other = registers[operand0];                        \
+                NLANG_SYNC();                                                           \
+                acc = ExecuteGeneric(heap, Opcode::generic, acc, other);                \
+                NLANG_SAFEPOINT();                                                      \
+                NLANG_NEXT();                                                           \
+            }                                                                           \
+            NLANG_TARGET(quickened) {                                                   \
+                const Handle<Value> other = registers[operand0];                         \
+                const bool left_is_number = acc.Is<Number>();                           \
+                const bool right_is_number = other.Is<Number>();                        \
+                if (NLANG_UNLIKELY(!(left_is_number & right_is_number))) {              \
+                    *ip = static_cast<uint8_t>(Opcode::generic);                        \
+                    NLANG_DISPATCH();                                                   \
+                }                                                                       \
+                const double left = acc.As<Number>()->Value();                          \
+                const double right = other.As<Number>()->Value();                       \
+                acc = expression;                                                       \
+                NLANG_NEXT();                                                           \
+            }
+// Compares the accumulator with the register and jumps, if the comparison result is equal to jump_if.
+// Numbers are compared in place, other values are compared by the generic comparison.
+#define NLANG_COMPARE_AND_JUMP(op, comparison, jump_if, expression)                     \
+            NLANG_TARGET(op) {                                                          \
+                const Handle<Value> other = registers[operand0];                        \
+                const bool left_is_number = acc.Is<Number>();                           \
+                const bool right_is_number = other.Is<Number>();                        \
+                bool result;                                                            \
+                if (NLANG_LIKELY(left_is_number & right_is_number)) {                   \
+                    const double left = acc.As<Number>()->Value();                      \
+                    const double right = other.As<Number>()->Value();                   \
+                    result = expression;                                                \
+                } else {                                                                \
+                    NLANG_SYNC();                                                       \
+                    result = ExecuteGeneric(heap, Opcode::comparison, acc, other)       \
+                            .As<Bool>()->Value();                                       \
+                }                                                                       \
+                if (result == jump_if) {                                                \
+                    NLANG_JUMP(operand1);                                               \
+                }                                                                       \
+                NLANG_NEXT();                                                           \
+            }
+
+        uint8_t* ip = thread->ip;
+        // operand fields of the current instruction
+        int32_t operand0 = 0;
+        int32_t operand1 = 0;
+        StackFrame* frame = thread->sp;
+        Handle<Value>* registers = frame->registers;
+        const Handle<Value>* constants = frame->function.As<BytecodeFunction>()->bytecode_chunk.constant_pool.data();
+        Handle<Value> acc = thread->acc;
+        Heap* const heap = thread->heap;
+
+#ifndef NLANG_USE_COMPUTED_GOTO
+    dispatch:
+#endif
+        switch (static_cast<Opcode>(*ip)) {
+            NLANG_TARGET(NoOperation) {
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(Wide) {
+                // decodes wide operands and jumps to the handler of the prefixed instruction, past its decoding
+                Instruction instruction;
+                const size_t size = DecodeInstruction(ip, instruction);
+                ip += size - GetInstructionSize(operand_formats[static_cast<uint8_t>(instruction.opcode)], false);
+                operand0 = instruction.fields[0];
+                operand1 = instruction.fields[1];
+#ifdef NLANG_USE_COMPUTED_GOTO
+                goto *body_table[static_cast<uint8_t>(instruction.opcode)];
+#else
+                switch (instruction.opcode) {
+#define O(op, OperandType) case Opcode::op: goto body_##op;
+                    OPCODES
+#undef O
                 }
-                case Opcode::PushContext: {
-                    thread->sp->context = Context::New(thread->heap, thread->sp->context, thread->ip->immediate_int32);
-                    break;
+#endif
+            }
+            NLANG_TARGET(CheckTypeEqual) {
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(LoadRegister) {
+                acc = registers[operand0];
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(StoreRegister) {
+                registers[operand0] = acc;
+                NLANG_NEXT();
+            }
+            NLANG_QUICKENED_BINARY(Add, AddNumber, Number::New(left + right))
+            NLANG_QUICKENED_BINARY(Sub, SubNumber, Number::New(left - right))
+            NLANG_QUICKENED_BINARY(Mul, MulNumber, Number::New(left * right))
+            NLANG_QUICKENED_BINARY(Div, DivNumber, Number::New(left / right))
+            NLANG_QUICKENED_BINARY(CheckEqual, CheckEqualNumber, Bool::New(left == right))
+            NLANG_QUICKENED_BINARY(CheckNotEqual, CheckNotEqualNumber, Bool::New(left != right))
+            NLANG_QUICKENED_BINARY(CheckLess, CheckLessNumber, Bool::New(left < right))
+            NLANG_QUICKENED_BINARY(CheckGreater, CheckGreaterNumber, Bool::New(left > right))
+            NLANG_QUICKENED_BINARY(CheckLessOrEqual, CheckLessOrEqualNumber, Bool::New(left <= right))
+            NLANG_QUICKENED_BINARY(CheckGreaterOrEqual, CheckGreaterOrEqualNumber, Bool::New(left >= right))
+            NLANG_TARGET(DeclareContext) {
+                frame->context->Declare({ operand0, operand1 });
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(LoadContext) {
+                acc = frame->context->Load({ operand0, operand1 });
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(StoreContext) {
+                frame->context->Store(heap, { operand0, operand1 }, acc);
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(LoadConstant) {
+                acc = constants[operand0];
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(Call) {
+                NLANG_SYNC();
+                // return address is saved in the frame of the caller
+                thread->ip = NLANG_END();
+                Handle<Closure> closure = acc.As<Closure>();
+                Handle<Value>* const arguments = registers + operand0;
+                if (NLANG_UNLIKELY(!closure->function->IsBytecode())) {
+                    closure->Call(thread, operand1, arguments);
+                    // native function has already returned
+                    acc = thread->acc;
+                    NLANG_SAFEPOINT();
+                    NLANG_NEXT();
                 }
-                case Opcode::LoadNumber: {
-                    thread->acc = Number::New(thread->ip->immediate_double);
-                    break;
+                // frame of the callee starts at the arguments window, continue with its first instruction
+                Handle<BytecodeFunction> callee = closure->function.As<BytecodeFunction>();
+                BytecodeChunk& chunk = callee->bytecode_chunk;
+                // missing arguments may lie past the committed part of the stack
+                thread->ReserveStack(frame + 2, arguments + chunk.arguments_count + chunk.registers_count);
+                for (int32_t i = operand1; i < chunk.arguments_count; ++i) {
+                    arguments[i] = Handle<Value>();
                 }
-                case Opcode::PopContext: {
-                    thread->sp->context = thread->sp->context->GetParent();
-                    break;
+                frame = thread->PushFrameInPlace(closure->context, callee, arguments, chunk.arguments_count, chunk.registers_count);
+                ip = chunk.bytecode.data();
+                registers = frame->registers;
+                constants = chunk.constant_pool.data();
+                NLANG_DISPATCH();
+            }
+            NLANG_TARGET(TailCall) {
+                Handle<Closure> closure = acc.As<Closure>();
+                Handle<Value>* const window = registers + operand0;
+                if (NLANG_UNLIKELY(!closure->function->IsBytecode())) {
+                    NLANG_SYNC();
+                    thread->ip = NLANG_END();
+                    closure->Call(thread, operand1, window);
+                    acc = thread->acc;
+                    goto body_Return;
                 }
-                case Opcode::CreateClosure: {
-                    thread->acc = Closure::New(thread->heap, thread->sp->context, thread->acc.As<Function>());
-                    break;
+                // frame of the function is reused: arguments are moved down to the place of its arguments, the
+                // window is above them, and the callee returns to the caller of the function
+                Handle<BytecodeFunction> callee = closure->function.As<BytecodeFunction>();
+                BytecodeChunk& chunk = callee->bytecode_chunk;
+                Handle<Value>* const arguments = frame->arguments;
+                thread->ReserveStack(frame + 1, arguments + chunk.arguments_count + chunk.registers_count);
+                const int32_t moved = operand1 < chunk.arguments_count ? operand1 : chunk.arguments_count;
+                for (int32_t i = 0; i < moved; ++i) {
+                    arguments[i] = window[i];
                 }
-                case Opcode::Return: {
-                    thread->PopFrame();
-                    if (!thread->sp || !thread->ip) {
-                        return;
-                    }
-                    break;
+                for (int32_t i = moved; i < chunk.arguments_count; ++i) {
+                    arguments[i] = Handle<Value>();
                 }
-                case Opcode::LoadNull: {
-                    thread->acc = Null::New();
-                    break;
+                frame->context = closure->context;
+                frame->function = callee;
+                frame->registers = arguments + chunk.arguments_count;
+                frame->end = frame->registers + chunk.registers_count;
+                std::fill(frame->registers, frame->end, Handle<Value>());
+                ip = chunk.bytecode.data();
+                registers = frame->registers;
+                constants = chunk.constant_pool.data();
+                NLANG_DISPATCH();
+            }
+            NLANG_TARGET(Jump) {
+                NLANG_JUMP(operand0);
+            }
+            NLANG_TARGET(JumpIfTrue) {
+                if ((acc.Is<Bool>() && acc.As<Bool>()->Value()) ||
+                    (acc.Is<Number>() && acc.As<Number>()->Value() != 0.0) ||
+                    (acc.Is<String>() && acc.As<String>()->GetLength() != 0)) {
+                    NLANG_JUMP(operand0);
                 }
-                case Opcode::LoadFalse: {
-                    thread->acc = Bool::New(false);
-                    break;
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(JumpIfFalse) {
+                if ((acc.Is<Bool>() && !acc.As<Bool>()->Value()) ||
+                    (acc.Is<Number>() && acc.As<Number>()->Value() == 0.0) ||
+                    (acc.Is<String>() && acc.As<String>()->GetLength() == 0)) {
+                    NLANG_JUMP(operand0);
                 }
-                case Opcode::LoadTrue: {
-                    thread->acc = Bool::New(true);
-                    break;
+                NLANG_NEXT();
+            }
+            NLANG_COMPARE_AND_JUMP(JumpIfEqual, CheckEqual, true, left == right)
+            NLANG_COMPARE_AND_JUMP(JumpIfNotEqual, CheckEqual, false, left == right)
+            NLANG_COMPARE_AND_JUMP(JumpIfNotLess, CheckLess, false, left < right)
+            NLANG_COMPARE_AND_JUMP(JumpIfNotGreater, CheckGreater, false, left > right)
+            NLANG_COMPARE_AND_JUMP(JumpIfNotLessOrEqual, CheckLessOrEqual, false, left <= right)
+            NLANG_COMPARE_AND_JUMP(JumpIfNotGreaterOrEqual, CheckGreaterOrEqual, false, left >= right)
+            NLANG_COMPARE_AND_JUMP(JumpIfLess, CheckLess, true, left < right)
+            NLANG_COMPARE_AND_JUMP(JumpIfGreater, CheckGreater, true, left > right)
+            NLANG_COMPARE_AND_JUMP(JumpIfLessOrEqual, CheckLessOrEqual, true, left <= right)
+            NLANG_COMPARE_AND_JUMP(JumpIfGreaterOrEqual, CheckGreaterOrEqual, true, left >= right)
+            NLANG_TARGET(PushContext) {
+                NLANG_SYNC();
+                frame->context = Context::New(heap, frame->context, operand0);
+                NLANG_SAFEPOINT();
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(LoadNumber) {
+                acc = Number::New(operand0);
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(PopContext) {
+                frame->context = frame->context->GetParent();
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(CreateClosure) {
+                NLANG_SYNC();
+                acc = Closure::New(heap, frame->context, acc.As<Function>());
+                NLANG_SAFEPOINT();
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(Return) {
+                NLANG_SYNC();
+                thread->PopFrame();
+                frame = thread->sp;
+                if (!frame || !thread->ip) {
+                    return;
                 }
-                default:
-                    break;
+                // continue from the return address of the caller
+                ip = thread->ip;
+                registers = frame->registers;
+                constants = frame->function.As<BytecodeFunction>()->bytecode_chunk.constant_pool.data();
+                NLANG_DISPATCH();
+            }
+            NLANG_TARGET(LoadNull) {
+                acc = Null::New();
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(LoadFalse) {
+                acc = Bool::New(false);
+                NLANG_NEXT();
+            }
+            NLANG_TARGET(LoadTrue) {
+                acc = Bool::New(true);
+                NLANG_NEXT();
             }
-
-            ++thread->ip;
         }
+
+#undef NLANG_COMPARE_AND_JUMP
+#undef NLANG_QUICKENED_BINARY
+#undef NLANG_JUMP
+#undef NLANG_SAFEPOINT
+#undef NLANG_SYNC
+#undef NLANG_NEXT
+#undef NLANG_DISPATCH
+#undef NLANG_END
+#undef NLANG_TARGET
+#undef NLANG_BODY
+#undef NLANG_DECODE
+#if defined(NLANG_USE_COMPUTED_GOTO) && (defined(NLANG_COMPILER_GCC) || defined(NLANG_COMPILER_CLANG))
+#pragma GCC diagnostic pop
+#endif
     }
+
+private:
+    /**
+     * Executes arithmetic or comparison instruction for operands of any types.
+     * Numbers are added to strings as their text representation, strings are compared lexicographically,
+     * other values are equal only if they are the same value.
+     * @param heap The heap to allocate strings in
+     * @param opcode Generic opcode of the instruction
+     * @param left Left operand (accumulator)
+     * @param right Right operand (register)
+     * @return Result of the operation
+     * @throws std::runtime_error If operation is not supported for the operands
+     */
+    static Handle<Value> ExecuteGeneric(Heap* heap, bytecode::Opcode opcode, Handle<Value> left, Handle<Value> right);
 };
 
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <interpreter/function.hpp>
 #include <interpreter/heap.hpp>
+#include <interpreter/tracer.hpp>
 
 #include <compiler/bytecode.hpp>
 
@@ -34,7 +35,8 @@ public:
     }
 
     /**
-     * Invokes the function bytecode using BytecodeExecutor and given thread
+     * Invokes the function bytecode using BytecodeExecutor and given thread, its frame is already pushed.
+     * Calls from the bytecode don't use it, the executor pushes frame of the callee itself.
      * @param thread The thread to execute in
      * @param args_count Arguments count
      * @param args Arguments
@@ -48,15 +50,20 @@ public:
      * @return Handle to created function
      */
     static Handle<BytecodeFunction> New(Heap* heap, bytecode::BytecodeChunk&& bytecode_chunk) {
-        return heap->Store(new BytecodeFunction(std::move(bytecode_chunk))).As<BytecodeFunction>();
+        return heap->Store(new (heap) BytecodeFunction(std::move(bytecode_chunk))).As<BytecodeFunction>();
+    }
+    void Trace(Tracer& tracer) override {
+        tracer.VisitAll(bytecode_chunk.constant_pool);
     }
-    void ForEachReference(std::function<void(Handle<Value>)> handler) override {
 
+    HeapValue* Promote(void* memory) override {
+        return new (memory) BytecodeFunction(std::move(bytecode_chunk));
     }
 
 private:
     explicit BytecodeFunction(bytecode::BytecodeChunk&& bytecode_chunk)
-        : bytecode_chunk(bytecode_chunk)
+        : Function(true)
+        , bytecode_chunk(std::move(bytecode_chunk))
     {}
 
 public:
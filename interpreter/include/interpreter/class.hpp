@@ -5,6 +5,7 @@
 #include <interpreter/value.hpp>
 #include <interpreter/heap.hpp>
 #include <interpreter/objects/string.hpp>
+#include <interpreter/tracer.hpp>
 
 #include <unordered_map>
 #include <array>
@@ -49,7 +50,8 @@ public:
      * @return Handle to created class
      */
     static Handle<Class> New(Heap& heap, Handle<String> class_name) {
-        return heap.Store(new Class(class_name)).As<Class>();
+        // members are written through references, so the class is old and always traced by the minor collections
+        return heap.Store(new Class(class_name), false).As<Class>();
     }
 
 
@@ -149,18 +151,18 @@ public:
         return !(*this == other);
     }
 
-    void ForEachReference(std::function<void(Handle<Value>)> handler) override {
-        handler(name);
-        std::for_each(prototype_chain.begin(), prototype_chain.end(), handler);
-        std::for_each(methods.begin(), methods.end(), handler);
-        std::for_each(overloads_mapping.begin(), overloads_mapping.end(), handler);
+    void Trace(Tracer& tracer) override {
+        tracer.Visit(name);
+        tracer.VisitAll(prototype_chain);
+        tracer.VisitAll(methods);
+        tracer.VisitAll(overloads_mapping);
 
-        for (auto kv : field_name_to_index) {
-            handler(kv.first);
+        for (const auto& kv : field_name_to_index) {
+            tracer.Visit(kv.first);
         }
 
-        for (auto kv : method_name_to_index) {
-            handler(kv.first);
+        for (const auto& kv : method_name_to_index) {
+            tracer.Visit(kv.first);
         }
     }
 
@@ -4,6 +4,7 @@
 #include <interpreter/objects/primitives.hpp>
 #include <interpreter/heap.hpp>
 #include <interpreter/objects/string.hpp>
+#include <interpreter/tracer.hpp>
 
 #include <compiler/bytecode.hpp>
 
@@ -19,7 +20,13 @@ public:
     Context() = default;
     virtual ~Context() = default;
 
-    void Store(bytecode::ContextDescriptor descriptor, Handle<Value> value) {
+    /**
+     * Stores the value to the variable of the context or of its parent, passing the write barrier of the heap
+     * @param heap The heap of the context
+     * @param descriptor Descriptor of the variable
+     * @param value The value
+     */
+    void Store(Heap* heap, bytecode::ContextDescriptor descriptor, Handle<Value> value) {
         Context* context = this;
         while (descriptor.depth--) {
             context = &*context->parent;
@@ -27,6 +34,7 @@ public:
         if (!context->values[descriptor.index]) {
             throw;
         }
+        heap->RecordWrite(context, value);
         context->values[descriptor.index] = value;
     }
 
@@ -56,13 +64,17 @@ public:
         return parent;
     }
 
-    virtual void ForEachReference(std::function<void(Handle<Value>)> handler) override {
-        handler(parent);
-        std::for_each(values.begin(), values.end(), handler);
+    virtual void Trace(Tracer& tracer) override {
+        tracer.Visit(parent);
+        tracer.VisitAll(values);
+    }
+
+    HeapValue* Promote(void* memory) override {
+        return new (memory) Context(parent, std::move(values));
     }
 
     static Handle<Context> New(Heap* heap, Handle<Context> parent, int32_t size) {
-        return heap->Store(new Context(parent, size)).As<Context>();
+        return heap->Store(new (heap) Context(parent, size)).As<Context>();
     }
 
 private:
@@ -71,6 +83,11 @@ private:
         , values(size)
     {}
 
+    Context(Handle<Context> parent, std::vector<Handle<Value>>&& values)
+        : parent(parent)
+        , values(std::move(values))
+    {}
+
     Handle<Context> parent;
     std::vector<Handle<Value>> values;
 };
@@ -5,6 +5,7 @@
 #include <interpreter/value.hpp>
 #include <interpreter/handle.hpp>
 #include <interpreter/heap.hpp>
+#include <interpreter/tracer.hpp>
 
 #include <cstdint>
 #include <vector>
@@ -25,11 +26,35 @@ public:
     virtual int32_t GetRegistersCount() const = 0;
     virtual int32_t GetArgumentsCount() const = 0;
 
+    /**
+     * Returns whether the function is a BytecodeFunction, so the executor can call it in place, without virtual calls
+     * and copying of the arguments
+     */
+    bool IsBytecode() const {
+        return is_bytecode;
+    }
+
     virtual void DoInvoke(Thread* thread, int32_t args_count, const Handle<Value>* args) = 0;
 
+    /**
+     * Pushes frame of the function, copying the arguments to it, and invokes the function
+     * @param thread The thread
+     * @param context Context of the closure
+     * @param function The function
+     * @param args_count Arguments count
+     * @param args Arguments
+     */
     static void Invoke(Thread* thread, Handle<Context> context, Handle<Function> function, int32_t args_count, const Handle<Value>* args);
 
-    virtual void ForEachReference(std::function<void(Handle<Value>)> handler) override = 0;
+    virtual void Trace(Tracer& tracer) override = 0;
+
+protected:
+    explicit Function(bool is_bytecode)
+        : is_bytecode(is_bytecode)
+    {}
+
+private:
+    bool is_bytecode = false;
 };
 
 /**
@@ -44,16 +69,20 @@ public:
     }
 
     static Handle<Closure> New(Heap* heap, Handle<Context> context, Handle<Function> function) {
-        return heap->Store(new Closure(context, function)).As<Closure>();
+        return heap->Store(new (heap) Closure(context, function)).As<Closure>();
     }
 
     static Handle<Closure> New(Heap* heap, Handle<Function> function) {
         return New(heap, Handle<Context>(), function);
     }
 
-    void ForEachReference(std::function<void(Handle<Value>)> handler) {
-        handler(context);
-        handler(function);
+    void Trace(Tracer& tracer) override {
+        tracer.Visit(context);
+        tracer.Visit(function);
+    }
+
+    HeapValue* Promote(void* memory) override {
+        return new (memory) Closure(context, function);
     }
 
 private:
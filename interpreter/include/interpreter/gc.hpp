@@ -1,11 +1,12 @@
 #pragma once
 
-#include <interpreter/stack_frame.hpp>
-
 #include <interpreter/heap.hpp>
+#include <interpreter/tracer.hpp>
+
+#include <utils/containers/segmented_stack.hpp>
 
+#include <chrono>
 #include <cstddef>
-#include <functional>
 
 namespace nlang {
 
@@ -14,21 +15,49 @@ namespace nlang {
  */
 class IGC {
 public:
+    virtual ~IGC() = default;
+
     /**
-     * Called to possibly trigger the garbage collection
+     * Collects the garbage of the old generation in one pause
      */
     virtual void Collect() = 0;
+
+    /**
+     * Starts the incremental collection of the old generation
+     */
+    virtual void StartMarking() = 0;
+
+    /**
+     * Performs a step of the incremental marking
+     * @param deadline Time, when the step should return
+     * @return Whether there is nothing left to mark
+     */
+    virtual bool MarkStep(std::chrono::steady_clock::time_point deadline) = 0;
+
+    /**
+     * Finishes the incremental collection: marks the values, which became reachable without the write barrier, and
+     * deletes the unmarked ones
+     */
+    virtual void FinishCollection() = 0;
+
+    /**
+     * Called by the write barrier during the incremental marking, when a reference to the old value is written
+     * @param slot Slot of the value
+     */
+    virtual void Shade(SlotPage<HeapValue>::Slot* slot) = 0;
 };
 
 /**
- * Basic single-pass mark-sweep-compact garbage collector
+ * Basic mark-sweep garbage collector
+ * Marks the values, which are reachable from the roots of the heap, and deletes the other ones. Marking is tri-color,
+ * so it may be split into steps, which are interleaved with the program (see Heap), then the sweep is done at once.
  */
 class BasicGC : public IGC {
 public:
     using SlotMark = SlotPage<HeapValue>::Slot::Mark;
     BasicGC() = delete;
 
-    BasicGC(StackFrame* the_stack, Heap* the_heap) : vm_stack(the_stack), vm_heap(the_heap) {}
+    explicit BasicGC(Heap* the_heap) : vm_heap(the_heap) {}
 
     virtual void Collect() override {
         Mark();
@@ -36,49 +65,75 @@ public:
         Compact();
     }
 
-protected:
-    /**
-     * Recursively marks all reachable objects
-     */
-    virtual void Mark() {
-        if (!vm_stack)
-            return;
-
-        std::function<void(Handle<Value>)> node_marker;
-
-        node_marker = [&node_marker](Handle<Value> value) {
-            if (!value.Is<HeapValue>())
-                return;
+    virtual void StartMarking() override {
+        Tracer tracer(grey, &vm_heap->GetNursery(), false);
+        vm_heap->TraceRoots(tracer);
+    }
 
-            Handle<HeapValue> heap_value = value.As<HeapValue>();
-            auto* value_slot = heap_value.GetSlot();
-            if (value_slot->GetMark() == SlotMark::WHITE) {
-                value_slot->SetMark(SlotMark::GREY);
-                value_slot->Get()->ForEachReference(node_marker);
-                value_slot->SetMark(SlotMark::BLACK);
-            }
-        };
-
-        auto* current_sf = vm_stack;
-        while (current_sf) {
-            node_marker(current_sf->context);
-            node_marker(current_sf->function);
-            for (Handle<Value>* current = current_sf->arguments; current < static_cast<void*>(current_sf->next); ++current) {
-                node_marker(current->As<HeapValue>());
+    virtual bool MarkStep(std::chrono::steady_clock::time_point deadline) override {
+        Tracer tracer(grey, &vm_heap->GetNursery(), false);
+        for (size_t traced = 1; !grey.empty(); ++traced) {
+            TraceGrey(tracer);
+            // reading the clock is much slower, than tracing a value
+            if (traced % DEADLINE_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline) {
+                break;
             }
+        }
+        return grey.empty();
+    }
 
-            current_sf = current_sf->prev;
+    virtual void FinishCollection() override {
+        Tracer tracer(grey, &vm_heap->GetNursery(), false);
+        // registers and fields of unbarriered values are written without the barrier
+        vm_heap->TraceRoots(tracer);
+        vm_heap->TraceUnbarriered(tracer);
+        while (!grey.empty()) {
+            TraceGrey(tracer);
         }
+        Sweep();
+        Compact();
+    }
+
+    virtual void Shade(SlotPage<HeapValue>::Slot* slot) override {
+        if (slot->GetMark() == SlotMark::WHITE) {
+            slot->SetMark(SlotMark::GREY);
+            grey.Push(slot);
+        }
+    }
+
+protected:
+    /** Count of the values, traced by a step of the incremental marking between the checks of the deadline */
+    static constexpr size_t DEADLINE_CHECK_INTERVAL = 256;
+
+    /**
+     * Traces the grey value from the worklist and blackens it
+     * @param tracer The tracer
+     */
+    NLANG_FORCE_INLINE void TraceGrey(Tracer& tracer) {
+        auto* slot = grey.Pop();
+        slot->Get()->Trace(tracer);
+        slot->SetMark(SlotMark::BLACK);
+    }
+
+    /**
+     * Marks all reachable objects
+     * Roots are greyed and pushed to the worklist, then grey values are popped, their references are greyed in turn,
+     * and they become black. The worklist is explicit, so the depth of the graph doesn't matter.
+     */
+    virtual void Mark() {
+        StartMarking();
+        MarkStep(std::chrono::steady_clock::time_point::max());
     }
 
     /**
      * Deletes the unreachable (= unused) objects
      */
     virtual void Sweep() {
-        vm_heap->ForEachValue([](SlotPage<HeapValue>* page, SlotPage<HeapValue>::Slot* slot) {
+        vm_heap->ForgetUnmarked();
+        vm_heap->ForEachValue([this](SlotPage<HeapValue>* page, SlotPage<HeapValue>::Slot* slot) {
             if (slot->GetMark() != SlotMark::BLACK) {
                 slot->SetMark(SlotMark::WHITE);
-                delete slot->Get();
+                vm_heap->Destroy(slot);
                 page->Release(slot);
             }
             else {
@@ -88,41 +143,16 @@ protected:
     }
 
     /**
-     * Defragments the heap to bring occupied slots closed to each other
+     * Releases the pages of the heap, which became empty.
+     * Slots are not moved (see SlotStorage::Defragment), as handles point to them directly.
      */
     virtual void Compact() {
-        vm_heap->storage.Defragment();
+        vm_heap->FreeEmptyPages();
     }
 
-    StackFrame* vm_stack;
     Heap* vm_heap;
-};
-
-/**
- * Two-pass mark-sweep-compact GC
- */
-class TwoPassGC : public BasicGC {
-    enum class PassType : uint8_t {
-        MARK = 0,
-        SWEEP_COMPACT
-    };
-
-public:
-    virtual void Collect() override {
-        if (next_pass == PassType::MARK) {
-            Mark();
-            next_pass = PassType::SWEEP_COMPACT;
-        }
-        else {
-            Sweep();
-            Compact();
-            next_pass = PassType::SWEEP_COMPACT;
-        }
-    }
-
-
-private:
-    PassType next_pass = PassType::MARK;
+    /** Worklist of the grey values, it is empty between the collections, but keeps a segment */
+    SegmentedStack<SlotPage<HeapValue>::Slot*> grey;
 };
 
 }
\ No newline at end of file
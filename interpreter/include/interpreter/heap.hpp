@@ -2,13 +2,23 @@
 
 #include <interpreter/value.hpp>
 #include <interpreter/handle.hpp>
+#include <interpreter/nursery.hpp>
 
+#include <utils/containers/segmented_stack.hpp>
 #include <utils/containers/slot_storage.hpp>
+#include <utils/pointers/unique_ptr.hpp>
 #include <utils/macro.hpp>
 
+#include <array>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
+#include <vector>
 
 
 namespace nlang {
@@ -19,39 +29,469 @@ class HeapValueHandler {
 public:
     virtual void operator()(SlotPage<HeapValue>* page, SlotPage<HeapValue>::Slot* slot) = 0;
 };
+class Tracer;
+
+/**
+ * Source of the roots of the garbage collection outside of the heap (e.g. stack of a thread)
+ */
+class IRootSource {
+public:
+    virtual ~IRootSource() = default;
+
+    /**
+     * Passes each value, which is referenced by the source, to the tracer
+     * @param tracer The tracer
+     */
+    virtual void TraceRoots(Tracer& tracer) = 0;
+};
+
+class IGC;
+
+/**
+ * Histogram of the pauses of the garbage collection
+ * Bucket 0 counts the pauses shorter than 1 microsecond, bucket i > 0 - the pauses from 2^(i - 1) to 2^i microseconds,
+ * the last bucket counts all the longer ones.
+ */
+class PauseHistogram {
+public:
+    static constexpr size_t BUCKETS_COUNT = 32;
+
+    /**
+     * Counts the pause
+     * @param pause Duration of the pause
+     */
+    void Record(std::chrono::nanoseconds pause);
+
+    /**
+     * @return Count of the pauses
+     */
+    size_t GetCount() const {
+        return count;
+    }
+
+    /**
+     * @param index Index of the bucket
+     * @return Count of the pauses in the bucket
+     */
+    size_t GetBucket(size_t index) const {
+        return buckets[index];
+    }
+
+    /**
+     * @return Duration of the longest pause
+     */
+    std::chrono::nanoseconds GetMax() const {
+        return max;
+    }
+
+    /**
+     * @return Total duration of the pauses
+     */
+    std::chrono::nanoseconds GetTotal() const {
+        return total;
+    }
+
+    /**
+     * Prints the summary and the non-empty buckets, one per line
+     * @param stream The stream
+     */
+    void Report(std::ostream& stream) const;
+
+private:
+    std::array<size_t, BUCKETS_COUNT> buckets {};
+    size_t count = 0;
+    std::chrono::nanoseconds max { 0 };
+    std::chrono::nanoseconds total { 0 };
+};
+
+/**
+ * Policy of the allocation-triggered garbage collection
+ */
+struct GCPolicy {
+    /** Count of old values in the heap, after which the first full collection is requested */
+    size_t initial_threshold = 64 * 1024;
+    /** Collection is requested again, when the heap grows this many times of the values, which survived the last one */
+    double growth_factor = 2.0;
+    /** Size of the nursery in bytes, when it is full, the minor collection is requested, 0 disables the nursery */
+    size_t nursery_size = 256 * 1024;
+    /**
+     * Time budget of a step of the incremental marking of the old generation, 0 disables it, so the old generation is
+     * collected in one pause
+     */
+    std::chrono::nanoseconds step_budget { 0 };
+    /** Count of old values, allocated between the steps of the incremental marking (besides the minor collections) */
+    size_t step_interval = 4 * 1024;
+};
+
 /**
  * Heap
- * Used for storing all runtime objects
+ * Used for storing all runtime objects.
+ * Values are allocated in the nursery (young generation) by bumping the pointer, while it has room. When it is full,
+ * the values are allocated in the old generation, and the minor collection is requested: it marks the young values,
+ * reachable from the roots and the remembered set, moves them to the old generation and resets the nursery. Handles
+ * point to the slots of the values, not to the values themselves, so promotion only updates the slots. Old values,
+ * which get references to young ones, are added to the remembered set by the write barrier (see RecordWrite).
+ * Slots of the young values are allocated in the pages of their size class, where each slot has inline storage for
+ * the value, and the value is promoted right to it. So the old value lies next to the pointer of its slot, and an
+ * access through the handle touches one cache line. Bigger values and values, created when the nursery is full, are
+ * allocated with plain new and their slots have no inline storage.
+ * When the count of old values reaches the threshold of the policy, the full collection of the old generation is
+ * requested. If the policy has the step budget, the old generation is marked incrementally: the collection greys the
+ * roots, then each requested collection (after the minor one) marks the grey values within the budget, while the
+ * program runs between them. The write barrier greys the old values, which are written to heap values (Dijkstra
+ * insertion barrier), and values, which are allocated or promoted during marking, are grey, so a black value never
+ * gets the only reference to a white one through the heap. Registers and unbarriered values don't pass the barrier,
+ * so the last step traces the roots and the marked unbarriered values again, marks the rest and sweeps.
+ * Collections are performed by the executor at the next safepoint, when all the values, that it uses, are reachable
+ * from the roots. Roots are the values of the registered sources (threads) and the persistent roots (e.g. compiled
+ * functions with their constant pools). Heap is not synchronized, so its values must be used by one running thread at
+ * a time.
  */
 class Heap {
 public:
+    using Slot = SlotStorage<HeapValue>::Slot;
+
+    /** Granularity of the strides of the slots with inline storage */
+    static constexpr size_t SIZE_CLASS_GRANULARITY = 16;
+    /** Count of the size classes, the biggest stride is SIZE_CLASS_GRANULARITY * SIZE_CLASSES_COUNT */
+    static constexpr size_t SIZE_CLASSES_COUNT = 16;
+    /** Size of the biggest value, which is allocated in the nursery and is stored inline, when it is promoted */
+    static constexpr size_t MAX_INLINE_SIZE = SIZE_CLASS_GRANULARITY * SIZE_CLASSES_COUNT - sizeof(Slot);
+
+    explicit Heap(const GCPolicy& policy = GCPolicy());
+
+    Heap(const Heap&) = delete;
+    Heap(Heap&&) = delete;
+    Heap& operator=(const Heap&) = delete;
+    Heap& operator=(Heap&&) = delete;
+
+    /**
+     * Allocates memory for a value, it is used by new (heap)
+     * @param size Size of the value
+     * @return Memory in the nursery, or in the old generation, if the nursery is full or the value is too big
+     */
+    NLANG_FORCE_INLINE void* Allocate(size_t size) {
+        if (NLANG_LIKELY(size <= MAX_INLINE_SIZE)) {
+            if (void* memory = nursery.Allocate(size)) {
+                return memory;
+            }
+            collection_requested = true;
+        }
+        return ::operator new(size);
+    }
+
+    /**
+     * Frees memory of the value, which is not stored (e.g. its constructor has thrown)
+     * @param memory The memory, allocated by Allocate
+     */
+    void Deallocate(void* memory) {
+        // memory of the nursery is freed by the minor collection
+        if (!nursery.Contains(memory)) {
+            ::operator delete(memory);
+        }
+    }
+
     /**
      * Store the object in heap
+     * Young values are collected by the minor collections. Old values (created when the nursery is full) are
+     * remembered, as they may refer to young values from the constructor. Writes to unbarriered values don't pass the
+     * write barrier (e.g. they are done through references to the fields), so they are always traced by the minor
+     * collections, such values must be allocated in the old generation with plain new.
+     * @tparam T Type of the object, it must be the exact type, as the young object is promoted to the inline storage
+     * of its size
      * @param value the object
+     * @param barriered Whether all the writes of references to the value pass the write barrier
      * @return Handle to stored object
      */
-    Handle<HeapValue> Store(HeapValue* value) {
-        auto* slot = storage.Store(value);
+    template<typename T>
+    Handle<HeapValue> Store(T* value, bool barriered = true) {
+        static_assert(std::is_base_of_v<HeapValue, T>);
+        NLANG_ASSERT(typeid(*value) == typeid(T));
+        Slot* slot = nullptr;
+        // bigger values are never allocated in the nursery
+        if constexpr (sizeof(T) <= MAX_INLINE_SIZE) {
+            if (nursery.Contains(value)) {
+                auto& size_class = *size_classes[(sizeof(T) + sizeof(Slot) - 1) / SIZE_CLASS_GRANULARITY];
+                slot = size_class.Store(value);
+                young.push_back({ slot, &size_class });
+            }
+        }
+        if (!slot) {
+            slot = storage.Store(value);
+            if (!barriered) {
+                unbarriered.push_back(slot);
+            } else if (!young.empty()) {
+                Remember(value);
+            }
+            if (NLANG_UNLIKELY(marking)) {
+                Shade(slot);
+            }
+        }
+        ++size;
+        if (NLANG_UNLIKELY(size - young.size() >= threshold)) {
+            collection_requested = true;
+            full_collection_requested = true;
+        }
         return Handle<HeapValue>(Handle<HeapValue>::BackingPrimitive(static_cast<void*>(slot)));
     }
 
+    /**
+     * Write barrier, it must be called, when a reference is written to the value
+     * Old holders of young values are remembered for the minor collection, old values are greyed during marking.
+     * @param holder The value, which is written
+     * @param value The reference
+     */
+    NLANG_FORCE_INLINE void RecordWrite(HeapValue* holder, Handle<Value> value) {
+        if (!value.Is<HeapValue>() || value.IsEmpty()) {
+            return;
+        }
+        Slot* slot = value.GetSlot();
+        if (NLANG_UNLIKELY(nursery.Contains(slot->Get()))) {
+            if (!holder->remembered && !nursery.Contains(holder)) {
+                Remember(holder);
+            }
+        } else if (NLANG_UNLIKELY(marking)) {
+            Shade(slot);
+        }
+    }
+
+    /**
+     * @return Whether the value is in the nursery
+     */
+    NLANG_FORCE_INLINE bool IsYoung(Handle<Value> value) const {
+        return value.Is<HeapValue>() && !value.IsEmpty() && nursery.Contains(value.GetSlot()->Get());
+    }
+
     /**
      * Execute function on each value in heap
      * @param function The function
      */
-    void ForEachValue(std::function<void(SlotPage<HeapValue>*, SlotPage<HeapValue>::Slot*)> function) {
-        storage.ForEachSlot(function);
+    void ForEachValue(std::function<void(SlotPage<HeapValue>*, SlotPage<HeapValue>::Slot*)> function);
+
+    /**
+     * Destroys the value of the slot, the slot is not released
+     * @param slot The slot
+     */
+    void Destroy(Slot* slot) {
+        HeapValue* value = slot->Get();
+        if (slot->IsInline() || nursery.Contains(value)) {
+            value->~HeapValue();
+        } else {
+            delete value;
+        }
     }
 
-    virtual ~Heap() {
-        ForEachValue([](SlotPage<HeapValue>* page, SlotPage<HeapValue>::Slot* slot) {
-            delete slot->Get();
-        });
+    /**
+     * Releases the pages of the heap, which became empty
+     */
+    void FreeEmptyPages();
+
+    /**
+     * @return Whether the nursery is full or the old generation has reached the threshold, so a safepoint must collect
+     * the garbage
+     */
+    NLANG_FORCE_INLINE bool IsCollectionRequested() const {
+        return collection_requested;
     }
 
-public:
+    /**
+     * Performs the requested collection: the minor one, and the full one, if the old generation has reached the
+     * threshold, or a step of the incremental marking. All the values, which are in use, must be reachable from the
+     * roots. The duration is recorded to the histogram of the pauses.
+     */
+    void CollectRequested();
+
+    /**
+     * Performs the minor collection.
+     * All the values, which are in use, must be reachable from the roots.
+     */
+    void CollectYoung();
+
+    /**
+     * Performs the minor collection and the full one (finishes the incremental marking, if it is in progress), then
+     * sets the threshold of the next full collection by the policy. All the values, which are in use, must be
+     * reachable from the roots.
+     */
+    void Collect();
+
+    /**
+     * @return Whether the incremental marking of the old generation is in progress
+     */
+    bool IsMarking() const {
+        return marking;
+    }
+
+    /**
+     * Forgets the unbarriered values, which are not marked, the collector calls it between the mark and the sweep
+     */
+    void ForgetUnmarked();
+
+    /**
+     * Passes the references of the marked unbarriered values to the tracer, the collector calls it at the end of the
+     * incremental marking, as writes to them may have stored white values after they were traced
+     * @param tracer The tracer
+     */
+    void TraceUnbarriered(Tracer& tracer);
+
+    /**
+     * Replaces the garbage collector, BasicGC is used by default
+     * @param gc The collector
+     */
+    void SetGC(UniquePtr<IGC> gc);
+
+    /**
+     * Adds the persistent root, which is never collected
+     * @param value The value
+     */
+    void AddRoot(Handle<Value> value) {
+        roots.push_back(value);
+    }
+
+    /**
+     * Removes the persistent root, so the value is collected, when nothing else refers to it
+     * @param value The heap value, which was added by AddRoot, it is removed once per addition
+     */
+    void RemoveRoot(Handle<Value> value);
+
+    void AddRootSource(IRootSource* source);
+
+    void RemoveRootSource(IRootSource* source);
+
+    /**
+     * Passes each root to the tracer: persistent roots and values of the root sources
+     * @param tracer The tracer
+     */
+    void TraceRoots(Tracer& tracer);
+
+    /**
+     * @return Count of the values in the heap
+     */
+    size_t GetSize() const {
+        return size;
+    }
+
+    /**
+     * @return Count of the values in the nursery
+     */
+    size_t GetYoungSize() const {
+        return young.size();
+    }
+
+    /**
+     * @return Count of the full collections, performed by the heap
+     */
+    size_t GetCollectionsCount() const {
+        return collections_count;
+    }
+
+    /**
+     * @return Count of the minor collections, performed by the heap
+     */
+    size_t GetYoungCollectionsCount() const {
+        return young_collections_count;
+    }
+
+    /**
+     * @return Count of the values, promoted to the old generation by the minor collections
+     */
+    size_t GetPromotedCount() const {
+        return promoted_count;
+    }
+
+    /**
+     * @return Histogram of the pauses of the requested and explicit collections
+     */
+    const PauseHistogram& GetPauses() const {
+        return pauses;
+    }
+
+    /**
+     * @return The nursery
+     */
+    const Nursery& GetNursery() const {
+        return nursery;
+    }
+
+    virtual ~Heap();
+
+private:
+    /**
+     * Performs the full collection of the old generation, the nursery must be empty
+     */
+    void CollectOld();
+
+    /**
+     * Performs a step of the incremental marking, finishes the collection, if nothing is left to mark
+     * @param start Beginning of the pause
+     */
+    void MarkStep(std::chrono::steady_clock::time_point start);
+
+    /**
+     * Finishes the incremental collection of the old generation, the nursery must be empty
+     */
+    void FinishCollection();
+
+    /**
+     * Updates the counters after the full collection and sets the threshold of the next one
+     */
+    void OnCollected();
+
+    /**
+     * Greys the white old value for the incremental marking
+     * @param slot Slot of the value
+     */
+    void Shade(Slot* slot);
+
+    void Remember(HeapValue* value) {
+        value->remembered = true;
+        remembered.push_back(value);
+    }
+
+    /** Slots of the values, which are allocated with plain new */
     SlotStorage<HeapValue> storage;
+    /** Slots with inline storage, the stride of the size class i is SIZE_CLASS_GRANULARITY * (i + 1) */
+    std::vector<UniquePtr<SlotStorage<HeapValue>>> size_classes;
+    /** Count of the values */
+    size_t size = 0;
+
+    GCPolicy policy;
+    size_t threshold;
+    bool collection_requested = false;
+    bool full_collection_requested = false;
+    size_t collections_count = 0;
+    size_t young_collections_count = 0;
+    size_t promoted_count = 0;
+    /** Whether the incremental marking is in progress */
+    bool marking = false;
+    PauseHistogram pauses;
+    UniquePtr<IGC> gc;
+    std::vector<Handle<Value>> roots;
+    std::mutex root_sources_mutex;
+    std::vector<IRootSource*> root_sources;
+
+    Nursery nursery;
+    struct YoungValue {
+        Slot* slot;
+        /** Storage of the slot, the value is promoted to its inline storage */
+        SlotStorage<HeapValue>* size_class;
+    };
+
+    /** Slots of the values in the nursery */
+    std::vector<YoungValue> young;
+    /** Old values, which may refer to young ones */
+    std::vector<HeapValue*> remembered;
+    /** Slots of the old values, whose writes don't pass the write barrier */
+    std::vector<Slot*> unbarriered;
+    /** Worklist of the minor collection */
+    SegmentedStack<Slot*> grey;
 };
 
+inline void* HeapValue::operator new(size_t size, Heap* heap) {
+    return heap->Allocate(size);
+}
 
+inline void HeapValue::operator delete(void* memory, Heap* heap) {
+    heap->Deallocate(memory);
 }
+
+}
\ No newline at end of file
@@ -32,11 +32,15 @@ public:
     }
 
     static Handle<NativeFunction> New(Heap* heap, std::function<Handle<Value>(Thread*, Handle<Context>, int32_t, const Handle<Value>*)> function) {
-        return heap->Store(new NativeFunction(std::move(function))).As<NativeFunction>();
+        return heap->Store(new (heap) NativeFunction(std::move(function))).As<NativeFunction>();
     }
 
     // No references => does nothing.
-    void ForEachReference(std::function<void(Handle<Value>)> handler) override {}
+    void Trace(Tracer& tracer) override {}
+
+    HeapValue* Promote(void* memory) override {
+        return new (memory) NativeFunction(std::move(function));
+    }
 
 private:
     explicit NativeFunction(std::function<Handle<Value>(Thread*, Handle<Context>, int32_t, const Handle<Value>*)>&& function)
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <utils/alloc/page.hpp>
+#include <utils/macro.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace nlang {
+
+/**
+ * Young generation of the heap
+ * Contiguous pages, where new values are allocated by bumping the pointer. Values, which survive the minor collection,
+ * are promoted (moved to the old generation), so the nursery is reset after it as a whole and dead values cost only
+ * their destructors.
+ */
+class Nursery {
+public:
+    /** Alignment of the allocated memory */
+    static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+
+    /**
+     * Allocates pages of the nursery
+     * @param size Size of the nursery in bytes, is rounded up to pages, 0 disables the nursery
+     */
+    explicit Nursery(size_t size)
+        : pages(size ? Page::AllocateRange((size + Page::size() - 1) / Page::size())
+                     : std::pair<Page::PageIterator, Page::PageIterator>())
+        , begin(static_cast<uint8_t*>(static_cast<void*>(pages.first.operator->())))
+        , top(begin)
+        , end(size ? begin + (pages.second - pages.first) * Page::size() : begin)
+    {}
+
+    Nursery(const Nursery&) = delete;
+    Nursery(Nursery&&) = delete;
+    Nursery& operator=(const Nursery&) = delete;
+    Nursery& operator=(Nursery&&) = delete;
+
+    ~Nursery() {
+        if (begin) {
+            Page::FreeRange(pages);
+        }
+    }
+
+    /**
+     * Allocates the memory
+     * @param size Size of the memory in bytes
+     * @return The memory, nullptr if the nursery is full
+     */
+    NLANG_FORCE_INLINE void* Allocate(size_t size) {
+        size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (NLANG_UNLIKELY(static_cast<size_t>(end - top) < size)) {
+            return nullptr;
+        }
+        void* memory = top;
+        top += size;
+        return memory;
+    }
+
+    /**
+     * @return Whether the memory is allocated in the nursery
+     */
+    NLANG_FORCE_INLINE bool Contains(const void* memory) const {
+        const auto address = reinterpret_cast<uintptr_t>(memory);
+        return address >= reinterpret_cast<uintptr_t>(begin) && address < reinterpret_cast<uintptr_t>(end);
+    }
+
+    /**
+     * Frees all the memory of the nursery, values in it must be destroyed or moved out
+     */
+    void Reset() {
+        top = begin;
+    }
+
+    /**
+     * @return Size of the allocated memory in bytes
+     */
+    size_t GetUsed() const {
+        return top - begin;
+    }
+
+    /**
+     * @return Size of the nursery in bytes
+     */
+    size_t GetSize() const {
+        return end - begin;
+    }
+
+private:
+    std::pair<Page::PageIterator, Page::PageIterator> pages;
+    uint8_t* const begin;
+    uint8_t* top;
+    uint8_t* const end;
+};
+
+}
\ No newline at end of file
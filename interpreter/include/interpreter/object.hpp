@@ -2,6 +2,7 @@
 
 #include <interpreter/value.hpp>
 #include <interpreter/handle.hpp>
+#include <interpreter/tracer.hpp>
 
 #include <interpreter/class.hpp>
 
@@ -13,7 +14,8 @@ namespace nlang {
 class Object : public HeapValue {
 public:
     static Handle<Object> New(Heap& heap, Handle<Class> the_class) {
-        return heap.Store(new Object(the_class)).As<Object>();
+        // fields are written through references, so the object is old and always traced by the minor collections
+        return heap.Store(new Object(the_class), false).As<Object>();
     }
 
     Handle<Value>& GetFieldByName(Handle<String> field_name) {
@@ -40,9 +42,9 @@ public:
         return _class->GetMethodCount();
     }
 
-    void ForEachReference(std::function<void(Handle<Value>)> handler) override {
-        handler(_class);
-        std::for_each(fields.begin(), fields.end(), handler);
+    void Trace(Tracer& tracer) override {
+        tracer.Visit(_class);
+        tracer.VisitAll(fields);
     }
 
     // TODO: checking if the object is instance of specific class
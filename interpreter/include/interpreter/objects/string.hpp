@@ -26,6 +26,10 @@ public:
 
     virtual ~String() override = default;
 
+    // UString has its own allocation functions, the ones of the heap are used
+    using HeapValue::operator new;
+    using HeapValue::operator delete;
+
     template<typename ...StrArgs>
     static Handle<String> New(Heap* heap, const StrArgs& ...strings) {
         UString s;
@@ -34,11 +38,11 @@ public:
         } else {
             s = ConvertAndConcat(strings...);
         }
-        return heap->Store(new String(s)).As<String>();
+        return heap->Store(new (heap) String(std::move(s))).As<String>();
     }
 
     static Handle<String> NewFromChar(Heap* heap, Char c) {
-        return heap->Store(new String(UString() + c)).As<String>();
+        return heap->Store(new (heap) String(UString() + c)).As<String>();
     }
 
 private:
@@ -97,7 +101,11 @@ private:
                ConvertAndConcat<S, StrTail...>(std::forward<S>(s), std::forward<StrTail>(strings)...);
     }
 
-    void ForEachReference(std::function<void(Handle<Value>)> handler) override {}
+    void Trace(Tracer& tracer) override {}
+
+    HeapValue* Promote(void* memory) override {
+        return new (memory) String(std::move(static_cast<UString&>(*this)));
+    }
 
 private:
     /**
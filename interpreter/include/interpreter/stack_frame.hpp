@@ -15,33 +15,36 @@
 namespace nlang {
 /**
  * Represents a stack frame
- * Contains context, arguments and registers for current call level
+ * Contains context, arguments and registers for current call level.
+ * Frames are laid out in the array of frames of the thread, while arguments and registers are in the separate stack
+ * of values: arguments of the frame are right below its registers, so register -1 is the last argument. Arguments of
+ * a bytecode call are the window of registers of the caller, the frame of the callee just starts at it.
  */
 struct StackFrame {
     Handle<Context> context;
     Handle<Function> function;
     Handle<Value>* arguments = nullptr;
     Handle<Value>* registers = nullptr;
-    bytecode::Instruction* ip = nullptr;
+    /** End of the registers, the values above it are free */
+    Handle<Value>* end = nullptr;
+    uint8_t* ip = nullptr;
 
-    StackFrame* next = nullptr;
     StackFrame* prev = nullptr;
 
     StackFrame(
             StackFrame* prev,
             Handle<Context> context,
-            Handle<Function> function)
+            Handle<Function> function,
+            Handle<Value>* arguments,
+            int32_t arguments_count,
+            int32_t registers_count)
             : context(context)
             , function(function)
-            , arguments(reinterpret_cast<Handle<Value>*>(this + 1))
-            , registers(arguments + function->GetArgumentsCount())
-            , next(reinterpret_cast<StackFrame*>(registers + function->GetRegistersCount()))
+            , arguments(arguments)
+            , registers(arguments + arguments_count)
+            , end(registers + registers_count)
             , prev(prev)
-    {
-        for (Handle<Value>* current = arguments; current < static_cast<void*>(next); ++current) {
-            new (current) Handle<Value>;
-        }
-    }
+    {}
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <utils/alloc/page.hpp>
+#include <utils/macro.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+namespace nlang {
+
+/**
+ * Thrown, when the VM stack of the thread is exhausted (e.g. by too deep recursion)
+ */
+class StackOverflowError : public std::runtime_error {
+public:
+    StackOverflowError()
+        : std::runtime_error("stack overflow")
+    {}
+};
+
+/**
+ * Region of the VM stack, which grows on demand.
+ * Pages of the maximum size are reserved up front, but are committed only when the stack reaches them, so a thread,
+ * that doesn't recurse deeply, takes only a few pages. The page past the maximum size is never committed and guards the
+ * region: limit checks of the users keep the stack below it, so it is touched only if they are missed.
+ * @tparam T Type of the elements
+ */
+template<typename T>
+class StackRegion {
+public:
+    /**
+     * Reserves the region
+     * @param size Maximum size of the region in bytes, is rounded up to pages
+     */
+    explicit StackRegion(size_t size)
+        : pages(Page::AllocateRange((size + Page::size() - 1) / Page::size() + 1, false))
+        , begin(static_cast<T*>(pages.first->data()))
+        , committed(begin)
+        , limit(begin + ((pages.second - pages.first) - 1) * Page::size() / sizeof(T))
+    {
+        Grow(begin + 1);
+    }
+
+    StackRegion(const StackRegion&) = delete;
+    StackRegion(StackRegion&&) = delete;
+    StackRegion& operator=(const StackRegion&) = delete;
+    StackRegion& operator=(StackRegion&&) = delete;
+
+    ~StackRegion() {
+        Page::FreeRange(pages);
+    }
+
+    /**
+     * @return The first element of the region
+     */
+    NLANG_FORCE_INLINE T* Begin() const {
+        return begin;
+    }
+
+    /**
+     * @return End of the committed part of the region, elements below it can be accessed
+     */
+    NLANG_FORCE_INLINE T* End() const {
+        return committed;
+    }
+
+    /**
+     * Commits the region up to the end, at least doubling the committed part
+     * @param end End of the elements, that must be accessible
+     * @throws StackOverflowError If the end is beyond the maximum size
+     */
+    void Grow(const T* end) {
+        if (end > limit) {
+            throw StackOverflowError();
+        }
+        const size_t required_pages = (reinterpret_cast<const uint8_t*>(end) - reinterpret_cast<uint8_t*>(begin) +
+                Page::size() - 1) / Page::size();
+        const size_t max_pages = (pages.second - 1) - pages.first;
+        const size_t new_pages = std::min(std::max(required_pages, committed_pages * 2), max_pages);
+        if (new_pages <= committed_pages) {
+            return;
+        }
+        Page::CommitRange({ pages.first + committed_pages, pages.first + new_pages });
+        committed_pages = new_pages;
+        // elements, that don't fit in the committed pages entirely, are not accessible
+        committed = begin + committed_pages * Page::size() / sizeof(T);
+    }
+
+private:
+    std::pair<Page::PageIterator, Page::PageIterator> pages;
+    T* const begin;
+    T* committed;
+    size_t committed_pages = 0;
+    /** End of the region before the guard page */
+    T* const limit;
+};
+
+}
\ No newline at end of file
@@ -3,14 +3,18 @@
 #include <interpreter/function.hpp>
 #include <interpreter/context.hpp>
 #include <interpreter/stack_frame.hpp>
+#include <interpreter/stack_region.hpp>
 #include <interpreter/value.hpp>
 #include <interpreter/handle.hpp>
 #include <interpreter/heap.hpp>
+#include <interpreter/tracer.hpp>
 
 #include <compiler/bytecode.hpp>
 
-#include <utils/alloc.hpp>
+#include <utils/macro.hpp>
 
+#include <algorithm>
+#include <exception>
 #include <vector>
 #include <cstdint>
 #include <thread>
@@ -19,33 +23,137 @@
 namespace nlang {
 /**
  * Represents a thread that can execute bytecode independently from other threads
- * Has own heap, main entry (closure), bytecode and registers
+ * Has own heap, main entry (closure), bytecode and registers.
+ * Thread is a root source of the heap while it exists: the entry closure, its arguments, the accumulator and the
+ * values of the frames are roots of the garbage collection.
  */
-class Thread {
+class Thread : public IRootSource {
 public:
-    Thread(Heap* heap, Handle<Closure> closure, int32_t args_count, const Handle<Value>* args) noexcept
+    /** Default maximum size of the stack of values and of the array of frames in bytes */
+    static constexpr size_t DEFAULT_STACK_SIZE = 8 * 1024 * 1024;
+
+    /**
+     * Starts the thread, which calls the closure
+     * @param heap The heap
+     * @param closure The closure
+     * @param args_count Arguments count
+     * @param args Arguments
+     * @param stack_size Maximum size of the stack of values and of the array of frames in bytes, they are reserved and
+     * are committed, as the thread uses them
+     * @throws std::bad_alloc If the stack can't be reserved
+     * @throws std::system_error If the thread can't be started
+     */
+    Thread(Heap* heap,
+           Handle<Closure> closure,
+           int32_t args_count,
+           const Handle<Value>* args,
+           size_t stack_size = DEFAULT_STACK_SIZE)
         : heap(heap)
-        , mem(AlignedAlloc(alignof(StackFrame), 8 * 1024 * 1024))
+        , values(stack_size)
+        , frames(stack_size)
+        , entry(closure)
+        , entry_args(args, args + args_count)
     {
-        thread = std::thread(&Thread::Run, this, closure, std::vector<Handle<Value>>(args, args + args_count));
+        heap->AddRootSource(this);
+        try {
+            thread = std::thread(&Thread::Run, this);
+        } catch (...) {
+            // destructor isn't called for the thread, that isn't constructed
+            heap->RemoveRootSource(this);
+            throw;
+        }
     }
 
-    ~Thread() noexcept {
-        AlignedFree(mem);
+    ~Thread() noexcept override {
+        heap->RemoveRootSource(this);
     }
 
+    /**
+     * Waits for the thread to finish
+     * @return Result of the closure
+     * @throws StackOverflowError If the stack of the thread is exhausted, or other exception, thrown by the thread
+     */
     Handle<Value> Join() {
         thread.join();
+        if (error) {
+            std::rethrow_exception(error);
+        }
         return acc;
     }
 
 public:
-    void PushFrame(Handle<Context> context, Handle<Function> function) {
+    /**
+     * Pushes frame of the function above the current one and copies the arguments to it.
+     * Missing arguments are empty, extra ones are dropped.
+     * @param context Context of the closure
+     * @param function The function
+     * @param args_count Arguments count
+     * @param args Arguments
+     */
+    void PushFrame(Handle<Context> context, Handle<Function> function, int32_t args_count, const Handle<Value>* args) {
+        Handle<Value>* arguments = sp ? sp->end : values.Begin();
+        const int32_t arguments_count = function->GetArgumentsCount();
+        ReserveStack(sp ? sp + 2 : frames.Begin() + 1, arguments + arguments_count + function->GetRegistersCount());
+        for (int32_t i = 0; i < arguments_count; ++i) {
+            arguments[i] = i < args_count ? args[i] : Handle<Value>();
+        }
+        PushFrameInPlace(context, function, arguments, arguments_count, function->GetRegistersCount());
+    }
+
+    /**
+     * Pushes frame of the function, which arguments are already in place (window of registers of the caller).
+     * Pushing is a bump of the frame pointer after the limit check, registers are cleared, as they aren't written yet.
+     * @param context Context of the closure
+     * @param function The function
+     * @param arguments The arguments
+     * @param arguments_count Count of the arguments of the function
+     * @param registers_count Count of the registers of the function
+     * @return The frame
+     * @throws StackOverflowError If the stack is exhausted
+     */
+    NLANG_FORCE_INLINE StackFrame* PushFrameInPlace(Handle<Context> context,
+                                                    Handle<Function> function,
+                                                    Handle<Value>* arguments,
+                                                    int32_t arguments_count,
+                                                    int32_t registers_count) {
+        StackFrame* const frame = sp ? sp + 1 : frames.Begin();
+        ReserveStack(frame + 1, arguments + arguments_count + registers_count);
         if (sp) {
             sp->ip = ip;
         }
-        sp = new (sp ? sp->next : static_cast<StackFrame*>(mem)) StackFrame(sp, context, function);
+        sp = new (frame) StackFrame(sp, context, function, arguments, arguments_count, registers_count);
+        std::fill(sp->registers, sp->end, Handle<Value>());
         ip = nullptr;
+        return sp;
+    }
+
+    /**
+     * Makes sure, that the frames and the values below the ends can be accessed, commits the stack, if they can't
+     * @param frames_end End of the frames
+     * @param values_end End of the values
+     * @throws StackOverflowError If the ends are beyond the maximum size of the stack
+     */
+    NLANG_FORCE_INLINE void ReserveStack(const StackFrame* frames_end, const Handle<Value>* values_end) {
+        if (NLANG_UNLIKELY(frames_end > frames.End() || values_end > values.End())) {
+            frames.Grow(frames_end);
+            values.Grow(values_end);
+        }
+    }
+
+    /**
+     * Passes the roots of the thread to the tracer. Values of the executor must be written back to the thread before
+     * it, so it is called only at safepoints of the running thread.
+     * @param tracer The tracer
+     */
+    void TraceRoots(Tracer& tracer) override {
+        tracer.Visit(entry);
+        tracer.VisitAll(entry_args);
+        tracer.Visit(acc);
+        for (StackFrame* frame = sp; frame; frame = frame->prev) {
+            tracer.Visit(frame->context);
+            tracer.Visit(frame->function);
+            tracer.VisitRange(frame->arguments, frame->end);
+        }
     }
 
     void PopFrame() {
@@ -56,19 +164,30 @@ public:
     }
 
 private:
-    void Run(Handle<Closure> closure, std::vector<Handle<Value>>&& args) {
-        closure->Invoke(this, args.size(), args.data());
+    void Run() {
+        try {
+            entry->Invoke(this, entry_args.size(), entry_args.data());
+        } catch (...) {
+            // rethrown by Join
+            error = std::current_exception();
+            sp = nullptr;
+            ip = nullptr;
+        }
     }
 
 public:
     Heap* heap;
-    bytecode::Instruction* ip = nullptr;
+    uint8_t* ip = nullptr;
     StackFrame* sp = nullptr;
     Handle<Value> acc;
 
 private:
     std::thread thread;
-    void* mem = nullptr;
+    StackRegion<Handle<Value>> values;
+    StackRegion<StackFrame> frames;
+    Handle<Closure> entry;
+    std::vector<Handle<Value>> entry_args;
+    std::exception_ptr error;
 };
 
 }
\ No newline at end of file
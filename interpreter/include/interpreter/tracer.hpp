@@ -0,0 +1,91 @@
+#pragma once
+
+#include <interpreter/value.hpp>
+#include <interpreter/handle.hpp>
+#include <interpreter/nursery.hpp>
+
+#include <utils/containers/segmented_stack.hpp>
+#include <utils/containers/slot_storage.hpp>
+#include <utils/macro.hpp>
+
+#include <iterator>
+
+namespace nlang {
+
+/**
+ * Visitor of the references for the mark phase of the garbage collection
+ * Heap values pass their references to Visit from Trace, which is the only virtual call per value. Visit greys the
+ * white values and pushes them to the worklist of the collector, which traces them later, so marking doesn't recurse
+ * and deep graphs (e.g. long chains of contexts) don't overflow the native stack.
+ * Tracer of the minor collection skips the old values, so only the young ones are marked, and tracer of the incremental
+ * marking skips the young values, as the minor collections promote them (see Heap).
+ */
+class Tracer {
+public:
+    using Slot = SlotStorage<HeapValue>::Slot;
+
+    /**
+     * Creates the tracer
+     * @param worklist Worklist of the grey values
+     * @param nursery Nursery, which splits the values into the generations, nullptr if all the values are marked
+     * @param young Whether only the values of the nursery are marked, or only the values outside of it
+     */
+    explicit Tracer(SegmentedStack<Slot*>& worklist, const Nursery* nursery = nullptr, bool young = true)
+        : worklist(worklist)
+        , nursery(nursery)
+        , young(young)
+    {}
+
+    Tracer(const Tracer&) = delete;
+    Tracer(Tracer&&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+    Tracer& operator=(Tracer&&) = delete;
+
+    /**
+     * Greys the value, if it is a white heap value, other values are skipped
+     * @param value The value, may be an immediate value or empty (e.g. registers, that aren't written yet)
+     */
+    template<typename T>
+    NLANG_FORCE_INLINE void Visit(const Handle<T>& value) {
+        const Handle<Value> handle = value;
+        if (!handle.Is<HeapValue>() || handle.IsEmpty()) {
+            return;
+        }
+        Slot* slot = handle.GetSlot();
+        if (nursery && nursery->Contains(slot->Get()) != young) {
+            return;
+        }
+        if (slot->GetMark() == Slot::Mark::WHITE) {
+            slot->SetMark(Slot::Mark::GREY);
+            worklist.Push(slot);
+        }
+    }
+
+    /**
+     * Visits each value of the range
+     * @param begin Beginning of the range
+     * @param end End of the range
+     */
+    template<typename Iterator>
+    NLANG_FORCE_INLINE void VisitRange(Iterator begin, Iterator end) {
+        for (; begin != end; ++begin) {
+            Visit(*begin);
+        }
+    }
+
+    /**
+     * Visits each value of the container
+     * @param container The container
+     */
+    template<typename Container>
+    NLANG_FORCE_INLINE void VisitAll(const Container& container) {
+        VisitRange(std::begin(container), std::end(container));
+    }
+
+private:
+    SegmentedStack<Slot*>& worklist;
+    const Nursery* const nursery;
+    const bool young;
+};
+
+}
\ No newline at end of file
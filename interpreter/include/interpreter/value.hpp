@@ -4,10 +4,11 @@
 #include <utils/macro.hpp>
 #include <utils/traits.hpp>
 
+#include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <new>
 #include <type_traits>
-#include <functional>
 
 
 namespace nlang {
@@ -33,13 +34,56 @@ class StackValue : public NanBoxedPrimitive, public Value {};
 template<typename T>
 class Handle;
 
+class Tracer;
+class Heap;
+
 /**
  * Represents a value that is stored in heap
+ * Values, created with new (heap), are allocated in the nursery of the heap while it has room, the other ones are
+ * allocated in the old generation.
  */
 class HeapValue : public Value {
 public:
-    virtual void ForEachReference(std::function<void(Handle<Value>)> handler) = 0;
+    /**
+     * Passes each value, referenced by this one, to the tracer
+     * @param tracer The tracer
+     */
+    virtual void Trace(Tracer& tracer) = 0;
+
+    /**
+     * Moves the value out of the nursery, when it survives the minor collection.
+     * Values, which are allocated only in the old generation, don't implement it.
+     * @param memory Inline storage of the slot of the value, it fits the type of the value
+     * @return New value, constructed in the memory, this one is destroyed after it
+     */
+    virtual HeapValue* Promote(void* memory) {
+        return nullptr;
+    }
+
     virtual ~HeapValue() = default;
+
+    static void* operator new(size_t size, Heap* heap);
+    static void operator delete(void* memory, Heap* heap);
+
+    static void* operator new(size_t size) {
+        return ::operator new(size);
+    }
+
+    static void operator delete(void* memory) {
+        ::operator delete(memory);
+    }
+
+    static void* operator new(size_t size, void* memory) {
+        return memory;
+    }
+
+    static void operator delete(void* memory, void* place) {}
+
+private:
+    friend class Heap;
+
+    /** Whether the old value is in the remembered set of the heap */
+    bool remembered = false;
 };
 
 
@@ -0,0 +1,74 @@
+#include <interpreter/bytecode_executor.hpp>
+#include <interpreter/objects/primitives.hpp>
+#include <interpreter/objects/string.hpp>
+
+#include <stdexcept>
+#include <string>
+
+namespace nlang {
+
+namespace {
+
+bool AreSame(Handle<Value> left, Handle<Value> right) {
+    if (left.Is<Number>() && right.Is<Number>()) {
+        return left.As<Number>()->Value() == right.As<Number>()->Value();
+    }
+    if (left.Is<Bool>() && right.Is<Bool>()) {
+        return left.As<Bool>()->Value() == right.As<Bool>()->Value();
+    }
+    if (left.Is<Null>() || right.Is<Null>()) {
+        return left.Is<Null>() && right.Is<Null>();
+    }
+    if (left.Is<String>() && right.Is<String>()) {
+        return static_cast<const UString&>(*left.As<String>()) == static_cast<const UString&>(*right.As<String>());
+    }
+    return left.Is<HeapValue>() && right.Is<HeapValue>() && left.GetSlot() == right.GetSlot();
+}
+
+}
+
+Handle<Value> BytecodeExecutor::ExecuteGeneric(Heap* heap, bytecode::Opcode opcode, Handle<Value> left, Handle<Value> right) {
+    using bytecode::Opcode;
+
+    if (opcode == Opcode::CheckEqual) {
+        return Bool::New(AreSame(left, right));
+    }
+    if (opcode == Opcode::CheckNotEqual) {
+        return Bool::New(!AreSame(left, right));
+    }
+
+    if (left.Is<Number>() && right.Is<Number>()) {
+        const double l = left.As<Number>()->Value();
+        const double r = right.As<Number>()->Value();
+        switch (opcode) {
+            case Opcode::Add: return Number::New(l + r);
+            case Opcode::Sub: return Number::New(l - r);
+            case Opcode::Mul: return Number::New(l * r);
+            case Opcode::Div: return Number::New(l / r);
+            case Opcode::CheckLess: return Bool::New(l < r);
+            case Opcode::CheckGreater: return Bool::New(l > r);
+            case Opcode::CheckLessOrEqual: return Bool::New(l <= r);
+            case Opcode::CheckGreaterOrEqual: return Bool::New(l >= r);
+            default: break;
+        }
+    } else if (left.Is<String>() && right.Is<String>()) {
+        const UString& l = *left.As<String>();
+        const UString& r = *right.As<String>();
+        switch (opcode) {
+            case Opcode::Add: return String::New(heap, l, r);
+            case Opcode::CheckLess: return Bool::New(l < r);
+            case Opcode::CheckGreater: return Bool::New(r < l);
+            case Opcode::CheckLessOrEqual: return Bool::New(l <= r);
+            case Opcode::CheckGreaterOrEqual: return Bool::New(r <= l);
+            default: break;
+        }
+    } else if (opcode == Opcode::Add && left.Is<String>() && right.Is<Number>()) {
+        return String::New(heap, *left.As<String>(), std::to_string(right.As<Number>()->Value()));
+    } else if (opcode == Opcode::Add && left.Is<Number>() && right.Is<String>()) {
+        return String::New(heap, std::to_string(left.As<Number>()->Value()), *right.As<String>());
+    }
+
+    throw std::runtime_error("unsupported operand types");
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include <interpreter/heap.hpp>
+#include <interpreter/gc.hpp>
+#include <interpreter/tracer.hpp>
+
+#include <algorithm>
+
+namespace nlang {
+
+void PauseHistogram::Record(std::chrono::nanoseconds pause) {
+    auto microseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(pause).count());
+    size_t bucket = 0;
+    while (microseconds && bucket < BUCKETS_COUNT - 1) {
+        microseconds >>= 1;
+        ++bucket;
+    }
+    ++buckets[bucket];
+    ++count;
+    max = std::max(max, pause);
+    total += pause;
+}
+
+void PauseHistogram::Report(std::ostream& stream) const {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    stream << "pauses: " << count << ", total: " << duration_cast<microseconds>(total).count() << " us, max: "
+           << duration_cast<microseconds>(max).count() << " us" << std::endl;
+    for (size_t i = 0; i < BUCKETS_COUNT; ++i) {
+        if (buckets[i]) {
+            stream << "  < " << (size_t(1) << i) << " us: " << buckets[i] << std::endl;
+        }
+    }
+}
+
+Heap::Heap(const GCPolicy& policy)
+    : policy(policy)
+    , threshold(policy.initial_threshold)
+    , gc(MakeUnique<BasicGC>(this))
+    , nursery(policy.nursery_size)
+{
+    for (size_t i = 0; i < SIZE_CLASSES_COUNT; ++i) {
+        size_classes.push_back(MakeUnique<SlotStorage<HeapValue>>(SIZE_CLASS_GRANULARITY * (i + 1) - sizeof(Slot)));
+    }
+}
+
+Heap::~Heap() {
+    ForEachValue([this](SlotPage<HeapValue>* page, SlotPage<HeapValue>::Slot* slot) {
+        Destroy(slot);
+    });
+}
+
+void Heap::ForEachValue(std::function<void(SlotPage<HeapValue>*, SlotPage<HeapValue>::Slot*)> function) {
+    storage.ForEachSlot(function);
+    for (auto& size_class : size_classes) {
+        size_class->ForEachSlot(function);
+    }
+}
+
+void Heap::FreeEmptyPages() {
+    storage.FreeEmptyPages();
+    for (auto& size_class : size_classes) {
+        size_class->FreeEmptyPages();
+    }
+}
+
+void Heap::CollectRequested() {
+    const auto start = std::chrono::steady_clock::now();
+    CollectYoung();
+    if (marking) {
+        MarkStep(start);
+    } else if (full_collection_requested || size >= threshold) {
+        // promoted values may reach the threshold
+        if (policy.step_budget.count() > 0) {
+            marking = true;
+            gc->StartMarking();
+            MarkStep(start);
+        } else {
+            CollectOld();
+        }
+    }
+    pauses.Record(std::chrono::steady_clock::now() - start);
+}
+
+void Heap::MarkStep(std::chrono::steady_clock::time_point start) {
+    if (gc->MarkStep(start + policy.step_budget)) {
+        FinishCollection();
+        return;
+    }
+    // the nursery is empty, the next step is requested by the minor collection or by allocation of old values
+    threshold = size + policy.step_interval;
+    full_collection_requested = false;
+    collection_requested = false;
+}
+
+void Heap::CollectYoung() {
+    Tracer tracer(grey, &nursery, true);
+    TraceRoots(tracer);
+    for (HeapValue* value : remembered) {
+        value->Trace(tracer);
+        value->remembered = false;
+    }
+    remembered.clear();
+    for (Slot* slot : unbarriered) {
+        slot->Get()->Trace(tracer);
+    }
+    while (!grey.empty()) {
+        Slot* slot = grey.Pop();
+        slot->Get()->Trace(tracer);
+        slot->SetMark(Slot::Mark::BLACK);
+    }
+
+    // handles point to the slots, so the survivors are moved to the inline storage of their slots, which just
+    // updates the slots
+    for (const YoungValue& young_value : young) {
+        Slot* slot = young_value.slot;
+        HeapValue* value = slot->Get();
+        if (slot->GetMark() == Slot::Mark::BLACK) {
+            HeapValue* promoted = value->Promote(slot->GetInlineStorage());
+            NLANG_ASSERT(promoted);
+            slot->Set(promoted);
+            slot->SetMark(Slot::Mark::WHITE);
+            // promoted values may hold the only references to white old values
+            if (marking) {
+                Shade(slot);
+            }
+            ++promoted_count;
+        } else {
+            young_value.size_class->Release(slot);
+            --size;
+        }
+        value->~HeapValue();
+    }
+    young.clear();
+    nursery.Reset();
+    ++young_collections_count;
+    collection_requested = full_collection_requested;
+}
+
+void Heap::Collect() {
+    const auto start = std::chrono::steady_clock::now();
+    CollectYoung();
+    if (marking) {
+        FinishCollection();
+    } else {
+        CollectOld();
+    }
+    pauses.Record(std::chrono::steady_clock::now() - start);
+}
+
+void Heap::CollectOld() {
+    gc->Collect();
+    OnCollected();
+}
+
+void Heap::FinishCollection() {
+    gc->FinishCollection();
+    marking = false;
+    OnCollected();
+}
+
+void Heap::OnCollected() {
+    ++collections_count;
+    size = storage.size();
+    for (auto& size_class : size_classes) {
+        size += size_class->size();
+    }
+    const auto grown = static_cast<size_t>(static_cast<double>(size) * policy.growth_factor);
+    threshold = std::max(policy.initial_threshold, grown);
+    full_collection_requested = false;
+    collection_requested = false;
+}
+
+void Heap::ForgetUnmarked() {
+    unbarriered.erase(std::remove_if(unbarriered.begin(), unbarriered.end(), [](Slot* slot) {
+        return slot->GetMark() != Slot::Mark::BLACK;
+    }), unbarriered.end());
+}
+
+void Heap::TraceUnbarriered(Tracer& tracer) {
+    for (Slot* slot : unbarriered) {
+        if (slot->GetMark() == Slot::Mark::BLACK) {
+            slot->Get()->Trace(tracer);
+        }
+    }
+}
+
+void Heap::Shade(Slot* slot) {
+    gc->Shade(slot);
+}
+
+void Heap::SetGC(UniquePtr<IGC> the_gc) {
+    NLANG_ASSERT(!marking);
+    gc = std::move(the_gc);
+}
+
+void Heap::RemoveRoot(Handle<Value> value) {
+    NLANG_ASSERT(value.Is<HeapValue>() && !value.IsEmpty());
+    auto it = std::find_if(roots.begin(), roots.end(), [&](const Handle<Value>& root) {
+        return root.Is<HeapValue>() && !root.IsEmpty() && root.GetSlot() == value.GetSlot();
+    });
+    NLANG_ASSERT(it != roots.end());
+    roots.erase(it);
+}
+
+void Heap::AddRootSource(IRootSource* source) {
+    std::lock_guard<std::mutex> lock(root_sources_mutex);
+    root_sources.push_back(source);
+}
+
+void Heap::RemoveRootSource(IRootSource* source) {
+    std::lock_guard<std::mutex> lock(root_sources_mutex);
+    root_sources.erase(std::find(root_sources.begin(), root_sources.end(), source));
+}
+
+void Heap::TraceRoots(Tracer& tracer) {
+    tracer.VisitAll(roots);
+    std::lock_guard<std::mutex> lock(root_sources_mutex);
+    for (IRootSource* source : root_sources) {
+        source->TraceRoots(tracer);
+    }
+}
+
+}
\ No newline at end of file
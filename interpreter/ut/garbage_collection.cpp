@@ -0,0 +1,158 @@
+#include <catch2/catch.hpp>
+
+#include <interpreter/context.hpp>
+#include <interpreter/heap.hpp>
+#include <interpreter/objects/primitives.hpp>
+#include <interpreter/objects/string.hpp>
+
+#include <chrono>
+
+TEST_CASE("mark of a deep graph") {
+    using namespace nlang;
+
+    Heap heap;
+    // chain of contexts is much deeper than the native stack would allow with recursive marking
+    const size_t depth = 1000000;
+
+    Handle<Context> chain;
+    for (size_t i = 0; i < depth; ++i) {
+        chain = Context::New(&heap, chain, 1);
+        chain->Declare({ 0, 0 });
+        chain->Store(&heap, { 0, 0 }, Number::New(i));
+        // garbage between the links
+        Context::New(&heap, Handle<Context>(), 0);
+    }
+    heap.AddRoot(chain);
+    REQUIRE(heap.GetSize() == depth * 2);
+
+    heap.Collect();
+    REQUIRE(heap.GetSize() == depth);
+
+    // links are intact
+    Handle<Context> context = chain;
+    for (size_t i = depth; i > 0; --i) {
+        REQUIRE(context->Load({ 0, 0 }).As<Number>()->Value() == i - 1);
+        context = context->GetParent();
+    }
+    REQUIRE(context.IsEmpty());
+
+    // marks are reset, so the next collection keeps the same values
+    heap.Collect();
+    REQUIRE(heap.GetSize() == depth);
+}
+
+TEST_CASE("minor collection") {
+    using namespace nlang;
+
+    Heap heap;
+
+    auto context = Context::New(&heap, Handle<Context>(), 2);
+    context->Declare({ 0, 0 });
+    context->Declare({ 1, 0 });
+    context->Store(&heap, { 0, 0 }, String::New(&heap, "first"));
+    for (size_t i = 0; i < 100; ++i) {
+        String::New(&heap, "garbage");
+    }
+    heap.AddRoot(context);
+    REQUIRE(heap.IsYoung(context));
+    REQUIRE(heap.GetYoungSize() == 102);
+
+    // survivors are promoted, handles stay valid
+    heap.CollectYoung();
+    REQUIRE(heap.GetYoungSize() == 0);
+    REQUIRE(heap.GetSize() == 2);
+    REQUIRE(heap.GetPromotedCount() == 2);
+    REQUIRE(!heap.IsYoung(context));
+    // promoted value lies next to its slot
+    REQUIRE(context.GetSlot()->IsInline());
+    REQUIRE(*context->Load({ 0, 0 }).As<String>() == UString("first"));
+
+    // young value is referenced only by the old context, the write barrier remembers the context
+    context->Store(&heap, { 1, 0 }, String::New(&heap, "second"));
+    for (size_t i = 0; i < 100; ++i) {
+        String::New(&heap, "garbage");
+    }
+    heap.CollectYoung();
+    REQUIRE(heap.GetSize() == 3);
+    REQUIRE(heap.GetPromotedCount() == 3);
+    REQUIRE(*context->Load({ 1, 0 }).As<String>() == UString("second"));
+
+    heap.Collect();
+    REQUIRE(heap.GetSize() == 3);
+    REQUIRE(heap.GetYoungCollectionsCount() == 3);
+    REQUIRE(heap.GetCollectionsCount() == 1);
+}
+
+TEST_CASE("incremental marking") {
+    using namespace nlang;
+
+    GCPolicy policy;
+    policy.initial_threshold = 1024;
+    // old generation only, so the steps are performed only by the test
+    policy.nursery_size = 0;
+    policy.step_budget = std::chrono::nanoseconds(1);
+    Heap heap(policy);
+
+    auto root = Context::New(&heap, Handle<Context>(), 2);
+    root->Declare({ 0, 0 });
+    root->Declare({ 1, 0 });
+    heap.AddRoot(root);
+
+    const size_t depth = 10000;
+    auto tail = Context::New(&heap, Handle<Context>(), 2);
+    tail->Declare({ 0, 0 });
+    tail->Declare({ 1, 0 });
+    tail->Store(&heap, { 0, 0 }, String::New(&heap, "moved"));
+    tail->Store(&heap, { 1, 0 }, String::New(&heap, "rooted"));
+    Handle<Context> chain = tail;
+    for (size_t i = 1; i < depth; ++i) {
+        chain = Context::New(&heap, chain, 0);
+        // garbage between the links
+        Context::New(&heap, Handle<Context>(), 0);
+    }
+    root->Store(&heap, { 0, 0 }, chain);
+    REQUIRE(heap.IsCollectionRequested());
+
+    // the step is shorter than the marking of the chain
+    heap.CollectRequested();
+    REQUIRE(heap.IsMarking());
+
+    // the root is black, and the string is moved to it from the unmarked tail, so only the barrier greys it
+    root->Store(&heap, { 1, 0 }, tail->Load({ 0, 0 }));
+    tail->Store(&heap, { 0, 0 }, Number::New(0));
+    // roots (e.g. registers) don't pass the barrier, they are traced again by the last step
+    auto rooted = tail->Load({ 1, 0 });
+    heap.AddRoot(rooted);
+    tail->Store(&heap, { 1, 0 }, Number::New(0));
+
+    size_t steps = 1;
+    while (heap.IsMarking()) {
+        heap.CollectRequested();
+        ++steps;
+    }
+    REQUIRE(steps > 1);
+    REQUIRE(heap.GetCollectionsCount() == 1);
+    REQUIRE(heap.GetPauses().GetCount() == steps);
+    REQUIRE(heap.GetSize() == depth + 3);
+    REQUIRE(*root->Load({ 1, 0 }).As<String>() == UString("moved"));
+    REQUIRE(*rooted.As<String>() == UString("rooted"));
+}
+
+TEST_CASE("pause histogram") {
+    using namespace nlang;
+
+    PauseHistogram histogram;
+    histogram.Record(std::chrono::nanoseconds(500));
+    histogram.Record(std::chrono::microseconds(1));
+    histogram.Record(std::chrono::microseconds(3));
+    histogram.Record(std::chrono::milliseconds(3));
+
+    REQUIRE(histogram.GetCount() == 4);
+    REQUIRE(histogram.GetBucket(0) == 1);
+    REQUIRE(histogram.GetBucket(1) == 1);
+    REQUIRE(histogram.GetBucket(2) == 1);
+    // 2048 <= 3000 < 4096 microseconds
+    REQUIRE(histogram.GetBucket(12) == 1);
+    REQUIRE(histogram.GetMax() == std::chrono::milliseconds(3));
+    REQUIRE(histogram.GetTotal() == std::chrono::nanoseconds(3004500));
+}
\ No newline at end of file
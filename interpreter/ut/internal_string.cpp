@@ -22,20 +22,20 @@ TEST_CASE("string creation & manipulation") {
 
     SECTION("strings can be created from STL strings") {
         auto s = String::New(&heap, a, b, c);
-        REQUIRE(s->GetLength() == a.length() + b.length() + c.length());
+        REQUIRE(s->GetLength() == static_cast<int32_t>(a.length() + b.length() + c.length()));
 //        REQUIRE(s->GetCharCodeAt(0)->Value() == int32_t(U'w'));
     }
 
     SECTION("strings can be created from combination of STL strings, literals and internal strings") {
         auto s = String::New(&heap, a, d, e, b, c, f);
-        REQUIRE(s->GetLength() ==
+        REQUIRE(s->GetLength() == static_cast<int32_t>(
                 a.length() +
                 b.length() +
                 c.length() +
                 std::string(d).length() +
                 std::u16string(e).length() +
                 std::u32string(f).length()
-        );
+        ));
 //        REQUIRE(s->GetCharCodeAt(2)->Value() == int32_t(U'ф'));
     }
 
@@ -60,7 +60,7 @@ TEST_CASE("string creation & manipulation") {
 
         std::string raw_s1;
 //        std::u32string raw_s2;
-        s1->GetRawString().toUTF8String(raw_s1);
+        s1->toUTF8String(raw_s1);
 //        s2->GetRawString().toUTF8String(raw_s2);
         REQUIRE(raw_s1 == (a + r));
 //        REQUIRE(raw_s2 == (b + w));
@@ -1,35 +1,211 @@
 #include <catch2/catch.hpp>
 
-#include <interpreter/interpreter.hpp>
+#include <interpreter/bytecode_function.hpp>
 #include <interpreter/function.hpp>
+#include <interpreter/native_function.hpp>
+#include <interpreter/thread.hpp>
+#include <interpreter/objects/primitives.hpp>
+#include <interpreter/objects/string.hpp>
 
-#include <iostream>
+#include <compiler/bytecode.hpp>
 
 TEST_CASE("thread spawn, native and interpreted function execution") {
-    // TODO fix this test
+    using namespace nlang;
+    using namespace nlang::bytecode;
 
-    /*nlang::Environment environment;
+    Heap heap;
 
-    double ctr = 0;
+    double argument = 0;
+    auto print = NativeFunction::New(&heap, [&](Thread*, Handle<Context>, int32_t args_count, const Handle<Value>* args) -> Handle<Value> {
+        REQUIRE(args_count == 1);
+        argument = args[0].As<Number>()->Value();
+        return Number::New(argument * 2);
+    });
 
-    auto print = nlang::NativeFunction::New(&environment, [&](nlang::NativeFunction::NativeFunctionInfo& info) {
-        for (size_t i = 0; i < info.GetArgumentsCount(); ++i) {
-            ctr = info.GetArgument(i).As<nlang::Number>()->Value();
-        }
-    }, 1);
+    // i = 0; while (i < 10) { i = 1 + i }; return print(i) + 1
+    BytecodeGenerator generator;
+    generator.SetArgumentsCount(0);
+    generator.SetRegistersCount(3);
+    generator.EmitInstruction<Opcode::LoadNumber>(0);
+    generator.EmitInstruction<Opcode::StoreRegister>(0);
+    generator.EmitInstruction<Opcode::LoadNumber>(10);
+    generator.EmitInstruction<Opcode::StoreRegister>(1);
+    const Label loop = generator.GetLabel();
+    generator.EmitInstruction<Opcode::LoadRegister>(0);
+    generator.EmitInstruction<Opcode::CheckLess>(1);
+    const JumpLabel exit = generator.EmitJump<Opcode::JumpIfFalse>();
+    generator.EmitInstruction<Opcode::LoadNumber>(1);
+    generator.EmitInstruction<Opcode::Add>(0);
+    generator.EmitInstruction<Opcode::StoreRegister>(0);
+    generator.EmitJump<Opcode::Jump>(loop);
+    generator.UpdateJumpToHere(exit);
+    generator.EmitInstruction<Opcode::LoadRegister>(0);
+    generator.EmitInstruction<Opcode::StoreRegister>(2);
+    generator.EmitInstruction<Opcode::LoadConstant>(generator.StoreConstant(Closure::New(&heap, print)));
+    generator.EmitInstruction<Opcode::Call>(RegistersRange { 2, 1 });
+    generator.EmitInstruction<Opcode::StoreRegister>(1);
+    generator.EmitInstruction<Opcode::LoadNumber>(1);
+    generator.EmitInstruction<Opcode::Add>(1);
+    generator.EmitInstruction<Opcode::Return>();
 
-    auto f = nlang::InterpretedFunction::New(&environment, {
-        4, 0, 0, 0, 0, 0, 0, 0, 0,
-        5, 0, 0, 0, 0, 0, 0, 0, 0,
-        4, 1, 0, 0, 0, 0, 0, 0, 0,
-        1, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0,
-        2,
-    }, 2, 1);
+    auto function = BytecodeFunction::New(&heap, generator.Flush());
 
-    nlang::Handle<nlang::Value> args[] { nlang::Number::New(123), nlang::Handle<nlang::Value>(print) };
+    Thread thread(&heap, Closure::New(&heap, function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 21);
+    REQUIRE(argument == 10);
+}
 
-    nlang::Thread thread(&environment, f, args, args + 2);
-    thread.Join();
+TEST_CASE("quickening of arithmetic and comparison instructions") {
+    using namespace nlang;
+    using namespace nlang::bytecode;
 
-    REQUIRE(ctr == 123);*/
+    Heap heap;
+
+    // a(x) { return x + x }
+    BytecodeGenerator generator;
+    generator.SetArgumentsCount(1);
+    generator.SetRegistersCount(0);
+    generator.EmitInstruction<Opcode::LoadRegister>(-1);
+    const Label add = generator.EmitInstruction<Opcode::Add>(-1);
+    generator.EmitInstruction<Opcode::Return>();
+
+    auto function = BytecodeFunction::New(&heap, generator.Flush());
+    auto closure = Closure::New(&heap, function);
+    auto opcode = [&]() { return static_cast<Opcode>(function->bytecode_chunk.bytecode[add]); };
+
+    {
+        Handle<Value> argument = Number::New(2);
+        Thread thread(&heap, closure, 1, &argument);
+        REQUIRE(thread.Join().As<Number>()->Value() == 4);
+        REQUIRE(opcode() == Opcode::AddNumber);
+    }
+    {
+        // deoptimized by non-numeric operand
+        Handle<Value> argument = String::New(&heap, "ab");
+        Thread thread(&heap, closure, 1, &argument);
+        REQUIRE(*thread.Join().As<String>() == UString("abab"));
+        REQUIRE(opcode() == Opcode::Add);
+    }
+    {
+        Handle<Value> argument = Number::New(-1.5);
+        Thread thread(&heap, closure, 1, &argument);
+        REQUIRE(thread.Join().As<Number>()->Value() == -3);
+        REQUIRE(opcode() == Opcode::AddNumber);
+    }
+}
+TEST_CASE("execution of wide instructions") {
+    using namespace nlang;
+    using namespace nlang::bytecode;
+
+    Heap heap;
+
+    // r299 = 1000; i = 0; do { i = i + constants[200] } while (i < r299); return i
+    BytecodeGenerator generator;
+    generator.SetArgumentsCount(0);
+    generator.SetRegistersCount(300);
+    for (int i = 0; i < 200; ++i) {
+        generator.StoreConstant(Null::New());
+    }
+    const ConstantIndex step = generator.StoreConstant(Number::New(0.5));
+    generator.EmitInstruction<Opcode::LoadNumber>(1000);
+    generator.EmitInstruction<Opcode::StoreRegister>(299);
+    generator.EmitInstruction<Opcode::LoadNumber>(0);
+    generator.EmitInstruction<Opcode::StoreRegister>(298);
+    const Label loop = generator.EmitInstruction<Opcode::LoadConstant>(step);
+    const Label add = generator.EmitInstruction<Opcode::Add>(298);
+    generator.EmitInstruction<Opcode::StoreRegister>(298);
+    generator.EmitRegisterJump<Opcode::JumpIfLess>(299, loop);
+    generator.EmitInstruction<Opcode::Return>();
+
+    auto function = BytecodeFunction::New(&heap, generator.Flush());
+
+    Thread thread(&heap, Closure::New(&heap, function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 1000);
+    REQUIRE(function->bytecode_chunk.bytecode[add] == static_cast<uint8_t>(Opcode::Wide));
+    // wide instructions are not quickened
+    REQUIRE(static_cast<Opcode>(function->bytecode_chunk.bytecode[add + 1]) == Opcode::Add);
+}
+TEST_CASE("calls with arguments in place") {
+    using namespace nlang;
+    using namespace nlang::bytecode;
+
+    Heap heap;
+
+    // sub(a, b) { return a - b }
+    BytecodeGenerator sub_generator;
+    sub_generator.SetArgumentsCount(2);
+    sub_generator.SetRegistersCount(1);
+    sub_generator.EmitInstruction<Opcode::LoadRegister>(-1);
+    sub_generator.EmitInstruction<Opcode::StoreRegister>(0);
+    sub_generator.EmitInstruction<Opcode::LoadRegister>(-2);
+    sub_generator.EmitInstruction<Opcode::Sub>(0);
+    sub_generator.EmitInstruction<Opcode::Return>();
+    auto sub = Closure::New(&heap, BytecodeFunction::New(&heap, sub_generator.Flush()));
+
+    // r0 = 100; r1 = sub(sub(10, 3), 4); return r0 + r1
+    // window of the inner call is above the outer one, frame of the callee starts at the window and overlaps the
+    // registers of the caller above it
+    BytecodeGenerator generator;
+    generator.SetArgumentsCount(0);
+    generator.SetRegistersCount(5);
+    const ConstantIndex sub_index = generator.StoreConstant(sub);
+    generator.EmitInstruction<Opcode::LoadNumber>(100);
+    generator.EmitInstruction<Opcode::StoreRegister>(0);
+    generator.EmitInstruction<Opcode::LoadNumber>(4);
+    generator.EmitInstruction<Opcode::StoreRegister>(2);
+    generator.EmitInstruction<Opcode::LoadNumber>(10);
+    generator.EmitInstruction<Opcode::StoreRegister>(3);
+    generator.EmitInstruction<Opcode::LoadNumber>(3);
+    generator.EmitInstruction<Opcode::StoreRegister>(4);
+    generator.EmitInstruction<Opcode::LoadConstant>(sub_index);
+    generator.EmitInstruction<Opcode::Call>(RegistersRange { 3, 2 });
+    generator.EmitInstruction<Opcode::StoreRegister>(1);
+    generator.EmitInstruction<Opcode::LoadConstant>(sub_index);
+    generator.EmitInstruction<Opcode::Call>(RegistersRange { 1, 2 });
+    generator.EmitInstruction<Opcode::StoreRegister>(1);
+    generator.EmitInstruction<Opcode::LoadRegister>(0);
+    generator.EmitInstruction<Opcode::Add>(1);
+    generator.EmitInstruction<Opcode::Return>();
+
+    auto function = BytecodeFunction::New(&heap, generator.Flush());
+
+    Thread thread(&heap, Closure::New(&heap, function), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 103);
+}
+TEST_CASE("tail call of native function") {
+    using namespace nlang;
+    using namespace nlang::bytecode;
+
+    Heap heap;
+
+    auto twice = NativeFunction::New(&heap, [&](Thread*, Handle<Context>, int32_t args_count, const Handle<Value>* args) -> Handle<Value> {
+        REQUIRE(args_count == 1);
+        return Number::New(args[0].As<Number>()->Value() * 2);
+    });
+
+    // f(x) { return twice(x + 1) }; return f(4) + 1
+    BytecodeGenerator f_generator;
+    f_generator.SetArgumentsCount(1);
+    f_generator.SetRegistersCount(1);
+    f_generator.EmitInstruction<Opcode::LoadNumber>(1);
+    f_generator.EmitInstruction<Opcode::Add>(-1);
+    f_generator.EmitInstruction<Opcode::StoreRegister>(0);
+    f_generator.EmitInstruction<Opcode::LoadConstant>(f_generator.StoreConstant(Closure::New(&heap, twice)));
+    f_generator.EmitInstruction<Opcode::TailCall>(RegistersRange { 0, 1 });
+    auto f = Closure::New(&heap, BytecodeFunction::New(&heap, f_generator.Flush()));
+
+    BytecodeGenerator generator;
+    generator.SetArgumentsCount(0);
+    generator.SetRegistersCount(2);
+    generator.EmitInstruction<Opcode::LoadNumber>(4);
+    generator.EmitInstruction<Opcode::StoreRegister>(1);
+    generator.EmitInstruction<Opcode::LoadConstant>(generator.StoreConstant(f));
+    generator.EmitInstruction<Opcode::Call>(RegistersRange { 1, 1 });
+    generator.EmitInstruction<Opcode::StoreRegister>(0);
+    generator.EmitInstruction<Opcode::LoadNumber>(1);
+    generator.EmitInstruction<Opcode::Add>(0);
+    generator.EmitInstruction<Opcode::Return>();
+
+    Thread thread(&heap, Closure::New(&heap, BytecodeFunction::New(&heap, generator.Flush())), 0, nullptr);
+    REQUIRE(thread.Join().As<Number>()->Value() == 11);
 }
\ No newline at end of file
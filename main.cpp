@@ -17,10 +17,12 @@
 
 #include <compiler/semantic_analyser.hpp>
 #include <compiler/compiler.hpp>
+#include <compiler/module_loader.hpp>
 
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <vector>
 
 /**
  * Splits up the source code string into tokens and prints them
@@ -32,7 +34,7 @@ void print(const nlang::UString &input) {
     auto scanner = Scanner::New(TokenStream::New(input));
 
     for (auto& token = scanner->NextToken(); token.token != nlang::Token::THE_EOF; token = scanner->NextToken()) {
-        std::cout << "'" << token.text << "'" << " [" << nlang::TokenUtils::GetTokenName(token.token) << ", " << static_cast<int>(token.token) << "]:"
+        std::cout << "'" << token.GetText() << "'" << " [" << nlang::TokenUtils::GetTokenName(token.token) << ", " << static_cast<int>(token.token) << "]:"
             << token.row << ":" << token.column << std::endl;
     }
 }
@@ -47,7 +49,12 @@ int main(int argc, char *argv[]) {
     using namespace nlang;
 
     Heap heap;
-    auto parser = Parser::New(Scanner::New(TokenStream::New(UString(
+    std::vector<UniquePtr<ast::Module>> modules;
+    if (argc > 1) {
+        ModuleLoader loader;
+        modules = loader.Load(std::vector<std::string>(argv + 1, argv + argc));
+    } else {
+        modules.push_back(ModuleLoader::LoadModule(Source::New(UString(
 R"(
 fn fibonacci(n) {
     if (n == 1) {
@@ -59,24 +66,19 @@ fn fibonacci(n) {
 }
 fibonacci(10)
 )"))));
+    }
 
-    auto ast = parser->ParseModule();
-
-    SemanticAnalyser semantic_analyzer;
-    semantic_analyzer.Process(*ast);
-
-    Compiler compiler;
-    auto module = compiler.Compile(&heap, *ast);
+    auto functions = ModuleLoader::Compile(&heap, modules);
 
-    ast::ASTStringifier a;
-    std::cout << a.Stringify(*ast) << std::endl;
+    for (size_t i = 0; i < modules.size(); ++i) {
+        ast::ASTStringifier a;
+        std::cout << a.Stringify(*modules[i]) << std::endl;
 
-    //std::cout << bytecode::BytecodeDisassembler::Disassemble(module.As<BytecodeFunction>()->bytecode_chunk) << std::endl << std::endl;
-    //std::cout << bytecode::BytecodeDisassembler::Disassemble(module.As<BytecodeFunction>()->bytecode_chunk.constant_pool[0].As<BytecodeFunction>()->bytecode_chunk) << std::endl << std::endl;
-    //std::cout << bytecode::BytecodeDisassembler::Disassemble(module.As<BytecodeFunction>()->bytecode_chunk.constant_pool[0].As<BytecodeFunction>()->bytecode_chunk.constant_pool[0].As<BytecodeFunction>()->bytecode_chunk) << std::endl << std::endl;
+        //std::cout << bytecode::BytecodeDisassembler::Disassemble(functions[i].As<BytecodeFunction>()->bytecode_chunk) << std::endl << std::endl;
 
-    Thread thread(&heap, Closure::New(&heap, Handle<Context>(), module), 0, nullptr);
-    std::cout << thread.Join().As<Number>()->Value() << std::endl;
+        Thread thread(&heap, Closure::New(&heap, Handle<Context>(), functions[i]), 0, nullptr);
+        std::cout << thread.Join().As<Number>()->Value() << std::endl;
+    }
     return 0;
     std::cout << "nlang " NLANG_VERSION " (" NLANG_BUILD_GIT_REVISION ", " NLANG_BUILD_PROCESSOR ",  " __DATE__ " " __TIME__  ")" << std::endl;
     std::cout << "[" << ((std::strcmp(NLANG_BUILD_COMPILER_ID, "GNU") == 0) ? "GCC" : NLANG_BUILD_COMPILER_ID) << " " NLANG_BUILD_COMPILER_VERSION << "]" << std::endl;
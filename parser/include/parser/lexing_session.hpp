@@ -0,0 +1,83 @@
+#pragma once
+
+#include <common/token.hpp>
+
+#include <utils/pointers/unique_ptr.hpp>
+#include <utils/strings.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace nlang {
+
+/**
+ * Incremental lexing session.
+ * Keeps text of the document and its full token sequence (including trivia). When the document is edited, only tokens,
+ * that could be affected by the edit, are rescanned: scanning restarts from the first token, that examined the edited
+ * range, and stops as soon as the new token boundary matches the old one after the edit.
+ */
+class LexingSession final {
+public:
+    /**
+     * Token of the document
+     */
+    struct Entry {
+        int32_t pos;
+        int32_t length;
+        /// Farthest position, examined while scanning the token
+        int32_t lookahead;
+        Token token;
+    };
+
+    /**
+     * Changes of the token sequence, made by the edit.
+     * Tokens [first, first + removed) were replaced with [first, first + inserted), following tokens were shifted.
+     */
+    struct Patch {
+        size_t first;
+        size_t removed;
+        size_t inserted;
+    };
+
+    LexingSession(const LexingSession&) = delete;
+    LexingSession(LexingSession&&) = delete;
+    LexingSession& operator=(const LexingSession&) = delete;
+    LexingSession& operator=(LexingSession&&) = delete;
+
+    /**
+     * Creates new session with empty document
+     * @return Unique pointer to created session
+     */
+    static UniquePtr<LexingSession> New() {
+        return UniquePtr<LexingSession>(new LexingSession());
+    }
+
+    /**
+     * Replaces range of the document and rescans affected tokens
+     * @param start Start of the replaced range
+     * @param end End of the replaced range (exclusive)
+     * @param replacement New text of the range
+     * @return Changes of the token sequence
+     */
+    Patch Edit(int32_t start, int32_t end, std::u16string_view replacement);
+
+    const std::vector<Entry>& GetTokens() const {
+        return tokens;
+    }
+
+    const UString& GetText() const {
+        return text;
+    }
+
+private:
+    LexingSession() = default;
+
+private:
+    UString text;
+    std::vector<Entry> tokens;
+    std::vector<Entry> scanned;
+};
+
+}
\ No newline at end of file
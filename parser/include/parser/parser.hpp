@@ -19,100 +19,157 @@ namespace nlang {
 /**
  * Parser.
  * Parses token sequences using recursive-descent algorithm, building the AST.
+ * AST nodes are placed in arena, which is owned by the caller: the module owns the arena of its nodes, and nodes of
+ * single statements and expressions are placed in the arena, passed by the caller, so it decides how long they live
+ * (e.g. statement-by-statement parsing may free them after each statement). The parser holds no nodes itself.
  */
 class Parser {
 public:
 
+    /**
+     * Parses the whole module. Module takes ownership of the arena with all its nodes.
+     * @return Parsed module
+     */
     UniquePtr<ast::Module> ParseModule() {
-        return MakeUnique<ast::Module>(ParseStatements());
+        auto module_arena = MakeUnique<ast::Arena>();
+        ArenaScope scope(*this, *module_arena);
+        auto statements = ParseStatements();
+        return MakeUnique<ast::Module>(std::move(module_arena), std::move(statements), scanner->GetSource());
+    }
+
+    /**
+     * Parses the next statement
+     * @param target Arena for the nodes of the statement, it must outlive them
+     * @return Parsed statement
+     */
+    ast::ArenaPtr<ast::IStatement> ParseStatement(ast::Arena& target) {
+        ArenaScope scope(*this, target);
+        return ParseStatement();
+    }
+
+    /**
+     * Parses the next expression
+     * @param target Arena for the nodes of the expression, it must outlive them
+     * @return Parsed expression
+     */
+    ast::ArenaPtr<ast::IExpression> ParseExpression(ast::Arena& target) {
+        ArenaScope scope(*this, target);
+        return ParseExpression();
     }
 
-    UniquePtr<ast::TypeHint> TryParseTypeHint() {
+    static UniquePtr<Parser> New(UniquePtr<Scanner>&& scanner) {
+        return UniquePtr<Parser>(new Parser(std::move(scanner)));
+    }
+
+private:
+    /**
+     * Directs the nodes to the arena, while the scope is alive
+     */
+    class ArenaScope {
+    public:
+        ArenaScope(Parser& parser, ast::Arena& target)
+            : parser(parser)
+            , previous(std::exchange(parser.arena, &target))
+        {}
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+        ~ArenaScope() {
+            parser.arena = previous;
+        }
+
+    private:
+        Parser& parser;
+        ast::Arena* const previous;
+    };
+
+    ast::ArenaPtr<ast::TypeHint> TryParseTypeHint() {
         if (scanner->NextTokenLookahead().token == Token::COLON) {
             auto colon = scanner->NextToken();
             auto identifier = scanner->NextTokenAssert(Token::IDENTIFIER);
-            return MakeUnique<ast::TypeHint>(std::move(colon),
-                                             MakeUnique<ast::IdentifierLiteral>(std::move(identifier)));
+            return arena->New<ast::TypeHint>(std::move(colon),
+                                             arena->New<ast::IdentifierLiteral>(std::move(identifier)));
         }
         return nullptr;
     }
 
-    UniquePtr<ast::DefaultValue> TryParseDefaultValue() {
+    ast::ArenaPtr<ast::DefaultValue> TryParseDefaultValue() {
         if (scanner->NextTokenLookahead().token == Token::ASSIGN) {
             auto assignment = scanner->NextToken();
-            return MakeUnique<ast::DefaultValue>(std::move(assignment), ParseExpression());
+            return arena->New<ast::DefaultValue>(std::move(assignment), ParseExpression());
         }
         return nullptr;
     }
 
-    UniquePtr<ast::ArgumentDefinitionStatementPart> ParseArgumentDefinitionStatementPart() {
+    ast::ArenaPtr<ast::ArgumentDefinitionStatementPart> ParseArgumentDefinitionStatementPart() {
         auto name = scanner->NextTokenAssert(Token::IDENTIFIER);
         auto type_hint = TryParseTypeHint();
         auto default_value = TryParseDefaultValue();
-        return MakeUnique<ast::ArgumentDefinitionStatementPart>(MakeUnique<ast::IdentifierLiteral>(std::move(name)),
+        return arena->New<ast::ArgumentDefinitionStatementPart>(arena->New<ast::IdentifierLiteral>(std::move(name)),
                                                                 std::move(type_hint), std::move(default_value));
     }
 
-    UniquePtr<ast::IStatement> ParseVariableDefinitionStatement() {
+    ast::ArenaPtr<ast::IStatement> ParseVariableDefinitionStatement() {
         auto let = scanner->NextTokenAssert(Token::LET);
         auto name = scanner->NextTokenAssert(Token::IDENTIFIER);
         auto type_hint = TryParseTypeHint();
         auto default_value = TryParseDefaultValue();
-        return MakeUnique<ast::VariableDefinitionStatement>(std::move(let),
-                                                            MakeUnique<ast::IdentifierLiteral>(std::move(name)),
+        return arena->New<ast::VariableDefinitionStatement>(std::move(let),
+                                                            arena->New<ast::IdentifierLiteral>(std::move(name)),
                                                             std::move(type_hint), std::move(default_value));
     }
 
-    UniquePtr<ast::IStatement> ParseReturnStatement() {
+    ast::ArenaPtr<ast::IStatement> ParseReturnStatement() {
         auto ret = scanner->NextTokenAssert(Token::RETURN);
         if (scanner->IsEOL() || scanner->NextTokenLookahead().token == Token::SEMICOLON) {
-            return MakeUnique<ast::ReturnStatement>(std::move(ret), nullptr);
+            return arena->New<ast::ReturnStatement>(std::move(ret), nullptr);
         }
-        return MakeUnique<ast::ReturnStatement>(std::move(ret), ParseExpression());
+        return arena->New<ast::ReturnStatement>(std::move(ret), ParseExpression());
     }
 
-    UniquePtr<ast::IStatement> ParseBreakStatement() {
+    ast::ArenaPtr<ast::IStatement> ParseBreakStatement() {
         auto brk = scanner->NextTokenAssert(Token::BREAK);
         if (scanner->IsEOL() || scanner->NextTokenLookahead().token == Token::SEMICOLON) {
-            return MakeUnique<ast::BreakStatement>(std::move(brk), nullptr);
+            return arena->New<ast::BreakStatement>(std::move(brk), nullptr);
         }
-        return MakeUnique<ast::BreakStatement>(std::move(brk), ParseExpression());
+        return arena->New<ast::BreakStatement>(std::move(brk), ParseExpression());
     }
 
-    UniquePtr<ast::IStatement> ParseContinueStatement() {
-        return MakeUnique<ast::ContinueStatement>(TokenInstance(scanner->NextTokenAssert(Token::CONTINUE)));
+    ast::ArenaPtr<ast::IStatement> ParseContinueStatement() {
+        return arena->New<ast::ContinueStatement>(TokenInstance(scanner->NextTokenAssert(Token::CONTINUE)));
     }
 
-    UniquePtr<ast::IStatement> ParseIfElseStatement() {
+    ast::ArenaPtr<ast::IStatement> ParseIfElseStatement() {
         auto if_token = scanner->NextTokenAssert(Token::IF);
         auto left_par = scanner->NextTokenAssert(Token::LEFT_PAR);
         auto expr = ParseExpression();
         auto right_par = scanner->NextTokenAssert(Token::RIGHT_PAR);
         auto body = ParseStatement();
-        UniquePtr<ast::ElseStatementPart> else_branch;
+        ast::ArenaPtr<ast::ElseStatementPart> else_branch;
         if (scanner->NextTokenLookahead().token == Token::ELSE) {
             auto else_token = scanner->NextToken();
             auto else_body = ParseStatement();
-            else_branch = MakeUnique<ast::ElseStatementPart>(std::move(else_token), std::move(else_body));
+            else_branch = arena->New<ast::ElseStatementPart>(std::move(else_token), std::move(else_body));
         }
-        return MakeUnique<ast::IfElseStatement>(std::move(if_token), std::move(left_par), std::move(expr),
+        return arena->New<ast::IfElseStatement>(std::move(if_token), std::move(left_par), std::move(expr),
                                                 std::move(right_par), std::move(body), std::move(else_branch));
     }
 
-    UniquePtr<ast::IStatement> ParseWhileStatement() {
+    ast::ArenaPtr<ast::IStatement> ParseWhileStatement() {
         auto while_token = scanner->NextTokenAssert(Token::WHILE);
         auto left_par = scanner->NextTokenAssert(Token::LEFT_PAR);
         auto expr = ParseExpression();
         auto right_par = scanner->NextTokenAssert(Token::RIGHT_PAR);
-        return MakeUnique<ast::WhileStatement>(std::move(while_token), std::move(left_par), std::move(expr),
+        return arena->New<ast::WhileStatement>(std::move(while_token), std::move(left_par), std::move(expr),
                                                std::move(right_par), ParseBlockStatement());
     }
 
-    UniquePtr<ast::IStatement> ParseExpressionStatement() {
-        return MakeUnique<ast::ExpressionStatement>(ParseExpression());
+    ast::ArenaPtr<ast::IStatement> ParseExpressionStatement() {
+        return arena->New<ast::ExpressionStatement>(ParseExpression());
     }
 
-    UniquePtr<ast::IStatement> ParseStatement() {
+    ast::ArenaPtr<ast::IStatement> ParseStatement() {
         switch (scanner->NextTokenLookahead().token) {
             case Token::FN:
                 return ParseFunctionDefinitionStatement();
@@ -143,8 +200,8 @@ public:
         }
     }
 
-    std::vector<UniquePtr<ast::IStatement>> ParseStatements() {
-        std::vector<UniquePtr<ast::IStatement>> statements;
+    std::vector<ast::ArenaPtr<ast::IStatement>> ParseStatements() {
+        std::vector<ast::ArenaPtr<ast::IStatement>> statements;
 
         while (true) {
             if (scanner->IsEOF() || scanner->NextTokenLookahead().token == Token::RIGHT_BRACE) {
@@ -159,19 +216,19 @@ public:
         return statements;
     }
 
-    UniquePtr<ast::IStatement> ParseBlockStatement() {
+    ast::ArenaPtr<ast::IStatement> ParseBlockStatement() {
         auto left_brace = scanner->NextTokenAssert(Token::LEFT_BRACE);
         auto statements = ParseStatements();
         auto right_brace = scanner->NextTokenAssert(Token::RIGHT_BRACE);
-        return MakeUnique<ast::BlockStatement>(std::move(left_brace), std::move(statements), std::move(right_brace));
+        return arena->New<ast::BlockStatement>(std::move(left_brace), std::move(statements), std::move(right_brace));
     }
 
-    UniquePtr<ast::FunctionDefinitionStatement> ParseFunctionDefinitionStatement() {
-        std::vector<UniquePtr<ast::ArgumentDefinitionStatementPart>> args;
+    ast::ArenaPtr<ast::FunctionDefinitionStatement> ParseFunctionDefinitionStatement() {
+        std::vector<ast::ArenaPtr<ast::ArgumentDefinitionStatementPart>> args;
 
         auto fn = scanner->NextTokenAssert(Token::FN);
-        UniquePtr<ast::IdentifierLiteral> name;
-        name = MakeUnique<ast::IdentifierLiteral>(TokenInstance(scanner->NextTokenAssert(Token::IDENTIFIER)));
+        ast::ArenaPtr<ast::IdentifierLiteral> name;
+        name = arena->New<ast::IdentifierLiteral>(TokenInstance(scanner->NextTokenAssert(Token::IDENTIFIER)));
         auto left_par = scanner->NextTokenAssert(Token::LEFT_PAR);
         TokenInstance right_par;
         bool default_value_required = false;
@@ -202,18 +259,18 @@ public:
 
         auto type_hint = TryParseTypeHint();
 
-        return MakeUnique<ast::FunctionDefinitionStatement>(std::move(fn), std::move(name), std::move(left_par),
+        return arena->New<ast::FunctionDefinitionStatement>(std::move(fn), std::move(name), std::move(left_par),
                                                             std::move(args), std::move(right_par),
                                                             std::move(type_hint), ParseBlockStatement());
     }
 
-    UniquePtr<ast::FunctionDefinitionExpression> ParseFunctionDefinitionExpression() {
-        std::vector<UniquePtr<ast::ArgumentDefinitionStatementPart>> args;
+    ast::ArenaPtr<ast::FunctionDefinitionExpression> ParseFunctionDefinitionExpression() {
+        std::vector<ast::ArenaPtr<ast::ArgumentDefinitionStatementPart>> args;
 
         auto fn = scanner->NextTokenAssert(Token::FN);
-        UniquePtr<ast::IdentifierLiteral> name;
+        ast::ArenaPtr<ast::IdentifierLiteral> name;
         if (scanner->NextTokenLookahead().token == Token::IDENTIFIER) {
-            name = MakeUnique<ast::IdentifierLiteral>(TokenInstance(scanner->NextToken()));
+            name = arena->New<ast::IdentifierLiteral>(TokenInstance(scanner->NextToken()));
         }
         auto left_par = scanner->NextTokenAssert(Token::LEFT_PAR);
         TokenInstance right_par;
@@ -245,19 +302,19 @@ public:
 
         auto type_hint = TryParseTypeHint();
 
-        return MakeUnique<ast::FunctionDefinitionExpression>(std::move(fn), std::move(name), std::move(left_par),
+        return arena->New<ast::FunctionDefinitionExpression>(std::move(fn), std::move(name), std::move(left_par),
                                                              std::move(args), std::move(right_par),
                                                              std::move(type_hint), ParseBlockStatement());
     }
 
-    UniquePtr<ast::IExpression> ParseParenthesizedExpression() {
+    ast::ArenaPtr<ast::IExpression> ParseParenthesizedExpression() {
         auto left_par = scanner->NextTokenAssert(Token::LEFT_PAR);
         auto expr = ParseExpression();
         auto right_par = scanner->NextTokenAssert(Token::RIGHT_PAR);
-        return MakeUnique<ast::ParenthesizedExpression>(std::move(left_par), std::move(expr), std::move(right_par));
+        return arena->New<ast::ParenthesizedExpression>(std::move(left_par), std::move(expr), std::move(right_par));
     }
 
-    UniquePtr<ast::IExpression> ParseBasicExpression() {
+    ast::ArenaPtr<ast::IExpression> ParseBasicExpression() {
         auto mark = scanner->Mark();
         auto token = scanner->NextToken();
         switch (token.token) {
@@ -266,29 +323,29 @@ public:
                 return ParseParenthesizedExpression();
 
             case Token::IDENTIFIER:
-                return MakeUnique<ast::LiteralExpression>(MakeUnique<ast::IdentifierLiteral>(std::move(token)));
+                return arena->New<ast::LiteralExpression>(arena->New<ast::IdentifierLiteral>(std::move(token)));
 
             case Token::NUMBER:
-                return MakeUnique<ast::LiteralExpression>(MakeUnique<ast::NumberLiteral>(std::move(token)));
+                return arena->New<ast::LiteralExpression>(arena->New<ast::NumberLiteral>(std::move(token)));
 
             case Token::STRING:
-                return MakeUnique<ast::LiteralExpression>(MakeUnique<ast::StringLiteral>(std::move(token)));
+                return arena->New<ast::LiteralExpression>(arena->New<ast::StringLiteral>(std::move(token)));
 
             case Token::THE_NULL:
-                return MakeUnique<ast::LiteralExpression>(MakeUnique<ast::NullLiteral>(std::move(token)));
+                return arena->New<ast::LiteralExpression>(arena->New<ast::NullLiteral>(std::move(token)));
 
             case Token::THE_TRUE:
             case Token::THE_FALSE:
-                return MakeUnique<ast::LiteralExpression>(MakeUnique<ast::BoolLiteral>(std::move(token)));
+                return arena->New<ast::LiteralExpression>(arena->New<ast::BoolLiteral>(std::move(token)));
 
             default:
                 throw std::runtime_error("Unexpected token at [" + std::to_string(token.row) + ":" + std::to_string(token.column) + "]");
         }
     }
 
-    std::vector<UniquePtr<ast::IExpression>> ParseCallOrSubscriptArguments(Token close) {
+    std::vector<ast::ArenaPtr<ast::IExpression>> ParseCallOrSubscriptArguments(Token close) {
         // TODO pass commas as tokens to ast
-        std::vector<UniquePtr<ast::IExpression>> arguments;
+        std::vector<ast::ArenaPtr<ast::IExpression>> arguments;
         while (true) {
             if (scanner->NextTokenLookahead().token == close) {
                 break;
@@ -304,26 +361,26 @@ public:
         return arguments;
     }
 
-    UniquePtr<ast::IExpression> ParsePostfixExpression() {
+    ast::ArenaPtr<ast::IExpression> ParsePostfixExpression() {
         static std::unordered_set<Token> tokens_set { Token::ADD_ADD, Token::SUB_SUB };
         auto expr = ParseBasicExpression();
         while (true) {
             auto mark = scanner->Mark();
             if (auto& token = scanner->NextToken(); tokens_set.find(token.token) != tokens_set.end()) {
-                expr = MakeUnique<ast::PostfixExpression>(std::move(expr), TokenInstance(token));
+                expr = arena->New<ast::PostfixExpression>(std::move(expr), TokenInstance(token));
             } else if (token.token == Token::LEFT_PAR) {
                 auto args = ParseCallOrSubscriptArguments(Token::RIGHT_PAR);
-                expr = MakeUnique<ast::FunctionCallExpression>(std::move(expr), TokenInstance(token), std::move(args),
+                expr = arena->New<ast::FunctionCallExpression>(std::move(expr), TokenInstance(token), std::move(args),
                                                                TokenInstance(
                                                                    scanner->NextTokenAssert(Token::RIGHT_PAR)));
             } else if (token.token == Token::LEFT_BRACKET) {
                 auto args = ParseCallOrSubscriptArguments(Token::RIGHT_BRACKET);
-                expr = MakeUnique<ast::SubscriptExpression>(std::move(expr), TokenInstance(token), std::move(args),
+                expr = arena->New<ast::SubscriptExpression>(std::move(expr), TokenInstance(token), std::move(args),
                                                             TokenInstance(
                                                                 scanner->NextTokenAssert(Token::RIGHT_BRACKET)));
             } else if (token.token == Token::DOT) {
-                expr = MakeUnique<ast::MemberAccessExpression>(std::move(expr), TokenInstance(token),
-                                                               MakeUnique<ast::IdentifierLiteral>(TokenInstance(
+                expr = arena->New<ast::MemberAccessExpression>(std::move(expr), TokenInstance(token),
+                                                               arena->New<ast::IdentifierLiteral>(TokenInstance(
                                                                    scanner->NextTokenAssert(Token::IDENTIFIER))));
             } else {
                 mark.Apply();
@@ -333,9 +390,9 @@ public:
         return expr;
     }
 
-    UniquePtr<ast::IExpression> ParsePrefixExpression() {
+    ast::ArenaPtr<ast::IExpression> ParsePrefixExpression() {
         static std::unordered_set<Token> tokens_set { Token::ADD, Token::SUB, Token::ADD_ADD, Token::SUB_SUB };
-        std::stack<TokenInstance> operators;
+        std::stack<TokenInstance, std::vector<TokenInstance>> operators;
         while (true) {
             auto mark = scanner->Mark();
             if (auto& token = scanner->NextToken(); tokens_set.find(token.token) != tokens_set.end()) {
@@ -344,7 +401,7 @@ public:
                 mark.Apply();
                 auto expr = ParsePostfixExpression();
                 while (!operators.empty()) {
-                    expr = MakeUnique<ast::PrefixExpression>(std::move(operators.top()), std::move(expr));
+                    expr = arena->New<ast::PrefixExpression>(std::move(operators.top()), std::move(expr));
                     operators.pop();
                 }
                 return expr;
@@ -357,16 +414,16 @@ public:
         RIGHT
     };
 
-    UniquePtr<ast::IExpression> ParseMultiplicativeExpression() { return ParseBinaryExpression<&Parser::ParsePrefixExpression, false, Associativity::LEFT, Token::MUL, Token::DIV, Token::REMAINDER>(); }
-    UniquePtr<ast::IExpression> ParseAdditiveExpression() { return ParseBinaryExpression<&Parser::ParseMultiplicativeExpression, false, Associativity::LEFT, Token::ADD, Token::SUB>(); }
-    UniquePtr<ast::IExpression> ParseInfixCallExpression() { return ParseBinaryExpression<&Parser::ParseAdditiveExpression, false, Associativity::LEFT, Token::IDENTIFIER>(); }
-    UniquePtr<ast::IExpression> ParseComparisonExpression() { return ParseBinaryExpression<&Parser::ParseInfixCallExpression, false, Associativity::LEFT, Token::LESS_EQUALS, Token::GREATER_EQUALS, Token::LESS, Token::GREATER>(); }
-    UniquePtr<ast::IExpression> ParseEqualityExpression() { return ParseBinaryExpression<&Parser::ParseComparisonExpression, false, Associativity::LEFT, Token::EQUALS, Token::NOT_EQUALS>(); }
-    UniquePtr<ast::IExpression> ParseConjunctionExpression() { return ParseBinaryExpression<&Parser::ParseEqualityExpression, true, Associativity::LEFT, Token::AND>(); }
-    UniquePtr<ast::IExpression> ParseDisjunctionExpression() { return ParseBinaryExpression<&Parser::ParseConjunctionExpression, true, Associativity::LEFT, Token::OR>(); }
-    UniquePtr<ast::IExpression> ParseAssignmentExpression() { return ParseBinaryExpression<&Parser::ParseDisjunctionExpression, false, Associativity::RIGHT, Token::ASSIGN, Token::ASSIGN_ADD, Token::ASSIGN_SUB, Token::ASSIGN_MUL, Token::ASSIGN_DIV, Token::ASSIGN_REMAINDER>(); }
+    ast::ArenaPtr<ast::IExpression> ParseMultiplicativeExpression() { return ParseBinaryExpression<&Parser::ParsePrefixExpression, false, Associativity::LEFT, Token::MUL, Token::DIV, Token::REMAINDER>(); }
+    ast::ArenaPtr<ast::IExpression> ParseAdditiveExpression() { return ParseBinaryExpression<&Parser::ParseMultiplicativeExpression, false, Associativity::LEFT, Token::ADD, Token::SUB>(); }
+    ast::ArenaPtr<ast::IExpression> ParseInfixCallExpression() { return ParseBinaryExpression<&Parser::ParseAdditiveExpression, false, Associativity::LEFT, Token::IDENTIFIER>(); }
+    ast::ArenaPtr<ast::IExpression> ParseComparisonExpression() { return ParseBinaryExpression<&Parser::ParseInfixCallExpression, false, Associativity::LEFT, Token::LESS_EQUALS, Token::GREATER_EQUALS, Token::LESS, Token::GREATER>(); }
+    ast::ArenaPtr<ast::IExpression> ParseEqualityExpression() { return ParseBinaryExpression<&Parser::ParseComparisonExpression, false, Associativity::LEFT, Token::EQUALS, Token::NOT_EQUALS>(); }
+    ast::ArenaPtr<ast::IExpression> ParseConjunctionExpression() { return ParseBinaryExpression<&Parser::ParseEqualityExpression, true, Associativity::LEFT, Token::AND>(); }
+    ast::ArenaPtr<ast::IExpression> ParseDisjunctionExpression() { return ParseBinaryExpression<&Parser::ParseConjunctionExpression, true, Associativity::LEFT, Token::OR>(); }
+    ast::ArenaPtr<ast::IExpression> ParseAssignmentExpression() { return ParseBinaryExpression<&Parser::ParseDisjunctionExpression, false, Associativity::RIGHT, Token::ASSIGN, Token::ASSIGN_ADD, Token::ASSIGN_SUB, Token::ASSIGN_MUL, Token::ASSIGN_DIV, Token::ASSIGN_REMAINDER>(); }
 
-    UniquePtr<ast::IExpression> ParseExpression() {
+    ast::ArenaPtr<ast::IExpression> ParseExpression() {
         if (scanner->NextTokenLookahead().token == Token::FN) {
             return ParseFunctionDefinitionExpression();
         } else if (scanner->NextTokenLookahead().token == Token::OP) {
@@ -377,12 +434,12 @@ public:
         return ParseAssignmentExpression();
     }
 
-    using ParseExpressionFunctionPointer = UniquePtr<ast::IExpression> (Parser::*)();
+    using ParseExpressionFunctionPointer = ast::ArenaPtr<ast::IExpression> (Parser::*)();
 
     template<ParseExpressionFunctionPointer next, bool allow_newline_before_op, Associativity associativity, Token ...tokens>
-    UniquePtr<ast::IExpression> ParseBinaryExpression() {
+    ast::ArenaPtr<ast::IExpression> ParseBinaryExpression() {
         static std::unordered_set<Token> tokens_set { tokens... };
-        UniquePtr<ast::IExpression> expr = (this->*next)();
+        ast::ArenaPtr<ast::IExpression> expr = (this->*next)();
         while (true) {
             if constexpr (!allow_newline_before_op) {
                 if (scanner->IsEOL()) {
@@ -392,9 +449,9 @@ public:
             auto mark = scanner->Mark();
             if (auto& token = scanner->NextToken(); tokens_set.find(token.token) != tokens_set.end()) {
                 if constexpr (associativity == Associativity::LEFT) {
-                    expr = MakeUnique<ast::BinaryExpression>(std::move(expr), TokenInstance(token), (this->*next)());
+                    expr = arena->New<ast::BinaryExpression>(std::move(expr), TokenInstance(token), (this->*next)());
                 } else {
-                    expr = MakeUnique<ast::BinaryExpression>(std::move(expr), TokenInstance(token),
+                    expr = arena->New<ast::BinaryExpression>(std::move(expr), TokenInstance(token),
                                                              ParseBinaryExpression<next, allow_newline_before_op, associativity, tokens...>());
                 }
             } else {
@@ -405,11 +462,6 @@ public:
         return expr;
     }
 
-    static UniquePtr<Parser> New(UniquePtr<Scanner>&& scanner) {
-        return UniquePtr<Parser>(new Parser(std::move(scanner)));
-    }
-
-private:
     explicit Parser(UniquePtr<Scanner>&& scanner)
         : scanner(std::move(scanner))
     {
@@ -418,6 +470,8 @@ private:
 
 private:
     UniquePtr<Scanner> scanner;
+    /** Arena of the nodes, which are being parsed, it is set by the entry points */
+    ast::Arena* arena = nullptr;
 };
 
 }
\ No newline at end of file
@@ -11,24 +11,33 @@
 #include <set>
 #include <unordered_set>
 #include <cstddef>
+#include <vector>
 #include <iostream>
 
 namespace nlang {
 
 /**
  * Scanner
- * Splits the source code into tokens, generation the token sequence, understandable by parser
+ * Splits the source code into tokens, generation the token sequence, understandable by parser.
+ * Token stream is switched to skip trivia, so the cache holds significant tokens only, and lookahead is O(1).
  */
 class Scanner {
 public:
     /**
      * Reference to specific position in source code.
      * Can be used to return to this position if needed.
+     * Bookmarks are scoped: they must be destroyed in reverse order of creation.
+     * Tokens after the earliest live bookmark are kept in cache, others may be dropped.
      */
     class BookMark {
         friend class Scanner;
 
     public:
+        BookMark(const BookMark&) = delete;
+        BookMark(BookMark&&) = delete;
+        BookMark& operator=(const BookMark&) = delete;
+        BookMark& operator=(BookMark&&) = delete;
+
         void Apply();
         void ApplyOnDestroy();
         ~BookMark();
@@ -65,7 +74,9 @@ public:
     bool IsEOL() const;
 
     /**
-     * Consumes/scans next token, skipping unwanted (comment/spaces) tokens
+     * Consumes/scans next token, skipping unwanted (comment/spaces) tokens.
+     * Once EOF is reached, it is returned on every call.
+     * Returned reference is valid until the next token is consumed, or while any bookmark, created before it, is alive.
      * @return Scanned token instance
      */
     TokenInstance& NextToken();
@@ -82,6 +93,22 @@ public:
      */
     TokenInstance& NextTokenLookahead() const;
 
+    /**
+     * Returns the source buffer, that scanned tokens refer to
+     * @return Shared pointer to the source string
+     */
+    SharedPtr<const Source> GetSource() const {
+        return cache.GetStream().GetSource();
+    }
+
+    /**
+     * Returns number of tokens, that are held in cache
+     * @return Number of cached tokens
+     */
+    size_t GetCacheSize() const {
+        return cache.Size();
+    }
+
     /**
      * Creates a scanner instance from token stream
      * @param token_stream Token stream
@@ -97,6 +124,11 @@ private:
 private:
     StreamCache<TokenStream> cache;
     int32_t pos;
+    /**
+     * Live bookmarks stack. Each entry is the minimal position of the bookmark and all bookmarks below it,
+     * so the cache may be cut right up to the top entry.
+     */
+    std::vector<int32_t> marks;
 };
 
 }
\ No newline at end of file
@@ -149,11 +149,22 @@ public:
         return end_;
     }
 
+    size_t Size() const {
+        return buffer.size();
+    }
+
+    S& GetStream() const {
+        return *stream;
+    }
+
     void Cut(size_t index_to) {
         NLANG_ASSERT(index_to >= offset);
         if (index_to == (size_t)-1) {
             index_to = buffer.size() + offset;
         }
+        if (index_to == offset) {
+            return;
+        }
         buffer.erase(buffer.begin(), buffer.begin() + (index_to - offset));
         offset = index_to;
         begin_ = StreamCacheIterator(this, offset);
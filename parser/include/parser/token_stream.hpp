@@ -1,18 +1,18 @@
 #pragma once
 
+#include <common/source.hpp>
 #include <common/token.hpp>
 
 #include <utils/macro.hpp>
 #include <utils/pointers/unique_ptr.hpp>
+#include <utils/pointers/shared_ptr.hpp>
 #include <utils/strings.hpp>
 
-#include <unicode/regex.h>
-
 #include <iterator>
 #include <memory>
 #include <vector>
-#include <regex>
 #include <optional>
+#include <algorithm>
 
 
 namespace nlang {
@@ -21,10 +21,24 @@ class Heap;
 
 /**
  * Token stream
- * Actually parses the string, looking for tokens
+ * Actually parses the string, looking for tokens.
+ * Uses hand-written DFA, that does one pass over UTF-16 source buffer.
+ * Source is decoded on demand, as the stream advances.
  */
 class TokenStream final {
 public:
+    /**
+     * Handling of trivia tokens (spaces, newlines and comments)
+     */
+    enum class Trivia : uint8_t {
+        /// Trivia tokens are returned as any other tokens
+        KEEP,
+        /// Trivia tokens are skipped, line breaks are only recorded in the next significant token
+        SKIP,
+        /// Same as SKIP, but comments are also stored in the side table
+        SKIP_COLLECT_COMMENTS,
+    };
+
     TokenStream(const TokenStream&) = delete;
     TokenStream(TokenStream&&) = delete;
     TokenStream& operator=(const TokenStream&) = delete;
@@ -40,8 +54,44 @@ public:
      * @return Next token instance
      */
     TokenInstance Next();
+    /**
+     * Sets trivia handling mode. Streams keep trivia tokens by default.
+     * @param trivia Trivia handling mode
+     */
+    void SetTrivia(Trivia trivia);
+    Trivia GetTrivia() const {
+        return trivia;
+    }
+    /**
+     * Returns comments, that were skipped in SKIP_COLLECT_COMMENTS mode
+     * @return Comment tokens in order of appearance
+     */
+    const std::vector<TokenInstance>& GetComments() const {
+        return comments;
+    }
+    /**
+     * Returns the farthest position in source, that was examined while scanning the last token.
+     * The token may change only if source is changed at or before this position.
+     * @return Position in source
+     */
+    int32_t GetLookahead() const {
+        return lookahead;
+    }
+    /**
+     * Moves the stream to the given position in source, that must be a start of a token.
+     * Row and column are counted from 1:1 again.
+     * @param position Position in source
+     */
+    void Seek(int32_t position);
+    /**
+     * Returns the source buffer, that produced tokens refer to
+     * @return Shared pointer to the source string
+     */
+    SharedPtr<const Source> GetSource() const {
+        return source;
+    }
     static UniquePtr<TokenStream> New(UString&& source) {
-        return UniquePtr<TokenStream>(new TokenStream(std::move(source)));
+        return New(Source::New(std::move(source)));
     }
     /**
      * Creates new token stream instance from source string
@@ -49,23 +99,63 @@ public:
      * @return Unique pointer to created token stream
      */
     static UniquePtr<TokenStream> New(const UString& source) {
-        return UniquePtr<TokenStream>(new TokenStream(source));
+        return New(Source::New(source));
+    }
+    /**
+     * Creates new token stream instance from source
+     * @param source Source, that may be not decoded yet
+     * @return Unique pointer to created token stream
+     */
+    static UniquePtr<TokenStream> New(SharedPtr<Source> source) {
+        return UniquePtr<TokenStream>(new TokenStream(std::move(source)));
     }
 
 private:
-    TokenStream(const UString& source);
-    TokenStream(UString&& source);
+    explicit TokenStream(SharedPtr<Source> source);
+
+    /**
+     * Checks if there is a code unit at given position, decoding the source if needed
+     * @param at Position in source buffer
+     * @return True if code unit exists, otherwise false
+     */
+    NLANG_FORCE_INLINE bool Has(int32_t at) {
+        lookahead = std::max(lookahead, at);
+        return at < length || Decode(at);
+    }
+
+    bool Decode(int32_t at);
+
+    /**
+     * Scans single token of any kind, including trivia
+     * @return Token instance
+     */
+    TokenInstance ScanToken();
+
+    /**
+     * Scans single token, starting from current position
+     * @param end Position right after the scanned token
+     * @return Scanned token
+     */
+    Token Scan(int32_t& end);
+
+    int32_t ScanLineComment(int32_t from);
+    int32_t ScanBlockComment(int32_t from);
+    int32_t ScanString(int32_t from);
+    int32_t ScanNumber(int32_t from);
+    bool IsWordBoundary(int32_t at);
 
 private:
-    UString source;
-    UString source_view;
+    SharedPtr<Source> source;
+    const char16_t* buffer;
+    int32_t length;
     int32_t pos;
     int32_t row;
     int32_t col;
-    UErrorCode error_code = U_ZERO_ERROR;
-    std::vector<std::pair<UniquePtr<icu::RegexMatcher>, Token>> regex_tokens;
-
-    static constexpr uint32_t regex_flags = 0;
+    Trivia trivia;
+    /// Line break was met after the last significant token
+    bool after_newline;
+    int32_t lookahead;
+    std::vector<TokenInstance> comments;
 };
 
 }
\ No newline at end of file
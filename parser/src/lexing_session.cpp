@@ -0,0 +1,68 @@
+#include <parser/lexing_session.hpp>
+
+#include <parser/token_stream.hpp>
+
+#include <algorithm>
+
+namespace nlang {
+
+LexingSession::Patch LexingSession::Edit(int32_t start, int32_t end, std::u16string_view replacement) {
+    NLANG_ASSERT(0 <= start && start <= end && end <= text.GetLength());
+
+    const int32_t delta = static_cast<int32_t>(replacement.length()) - (end - start);
+    const int32_t new_end = start + static_cast<int32_t>(replacement.length());
+
+    // tokens, that didn't look at the edited range, are not affected by the edit
+    // lookahead is not monotonic (unterminated string examines the rest of the text), so all the tokens are checked
+    size_t first = 0;
+    while (first < tokens.size() && tokens[first].lookahead < start) {
+        ++first;
+    }
+    int32_t restart = 0;
+    if (first < tokens.size()) {
+        restart = tokens[first].pos;
+    } else if (!tokens.empty()) {
+        restart = tokens.back().pos + tokens.back().length;
+    }
+
+    text.replace(start, end - start, replacement.data(), static_cast<int32_t>(replacement.length()));
+
+    auto stream = TokenStream::New(Source::New(UString::Alias(std::u16string_view(text.getBuffer(), text.GetLength()))));
+    stream->Seek(restart);
+
+    // rescan until token boundary after the edit matches the old one, the rest of old tokens is just shifted
+    size_t old = first;
+    scanned.clear();
+    while (true) {
+        const TokenInstance token = stream->Next();
+        if (token.token == Token::THE_EOF) {
+            old = tokens.size();
+            break;
+        }
+        if (token.pos >= new_end) {
+            const int32_t old_pos = token.pos - delta;
+            while (old < tokens.size() && tokens[old].pos < old_pos) {
+                ++old;
+            }
+            if (old < tokens.size() && tokens[old].pos == old_pos) {
+                break;
+            }
+        }
+        scanned.push_back(Entry { token.pos, token.length, stream->GetLookahead(), token.token });
+    }
+
+    for (size_t i = old; i < tokens.size(); ++i) {
+        tokens[i].pos += delta;
+        tokens[i].lookahead += delta;
+    }
+    const Patch patch { first, old - first, scanned.size() };
+    if (patch.removed == patch.inserted) {
+        std::copy(scanned.begin(), scanned.end(), tokens.begin() + first);
+    } else {
+        tokens.erase(tokens.begin() + first, tokens.begin() + old);
+        tokens.insert(tokens.begin() + first, scanned.begin(), scanned.end());
+    }
+    return patch;
+}
+
+}
\ No newline at end of file
@@ -1,9 +1,22 @@
 #include <parser/scanner.hpp>
 
+#include <algorithm>
+
 namespace nlang {
 
+namespace {
+
+UniquePtr<TokenStream> SkipTrivia(UniquePtr<TokenStream>&& token_stream) {
+    if (token_stream->GetTrivia() == TokenStream::Trivia::KEEP) {
+        token_stream->SetTrivia(TokenStream::Trivia::SKIP);
+    }
+    return std::move(token_stream);
+}
+
+}
+
 Scanner::Scanner(nlang::UniquePtr<nlang::TokenStream>&& token_stream)
-    : cache(std::move(token_stream))
+    : cache(SkipTrivia(std::move(token_stream)))
     , pos(0)
 {}
 
@@ -12,35 +25,22 @@ Scanner::BookMark Scanner::Mark() const {
 }
 
 bool Scanner::IsEOF() const {
-    return NextTokenLookahead().token == Token::THE_EOF;
+    return cache[pos].token == Token::THE_EOF;
 }
 
 bool Scanner::IsEOL() const {
-    int32_t p = pos;
-    auto mark = Mark();
-    mark.ApplyOnDestroy();
-    auto tok = const_cast<Scanner*>(this)->NextToken();
-    if (tok.token == Token::THE_EOF) {
-        return true;
-    }
-    for (int32_t i = p; i < pos; ++i) {
-        if (cache[i].token == Token::NEWLINE) {
-            return true;
-        }
-    }
-    return false;
+    const TokenInstance& token = cache[pos];
+    return token.token == Token::THE_EOF || token.preceded_by_newline;
 }
 
 TokenInstance& Scanner::NextToken() {
     // TODO skip and report invalid tokens
-    static std::unordered_set<Token> tokens_to_skip { Token::NEWLINE, Token::COMMENT, Token::SPACE };
-    auto it = StreamCache<TokenStream>::StreamCacheIterator(&cache, pos);
-    while (it != cache.end() && tokens_to_skip.find(it->token) != tokens_to_skip.end()) {
-        ++it;
+    TokenInstance& to_ret = cache[pos];
+    // nothing can rewind before the earliest live bookmark
+    cache.Cut(marks.empty() ? pos : std::min(pos, marks.back()));
+    if (to_ret.token != Token::THE_EOF) {
+        ++pos;
     }
-    TokenInstance& to_ret = cache[it.GetPosition()];
-    pos = it.GetPosition() + 1;
-    // TODO cut cache by bookmarks here cache.Cut(...);
     return to_ret;
 }
 
@@ -55,16 +55,16 @@ TokenInstance& Scanner::NextTokenAssert(Token token) {
 }
 
 TokenInstance& Scanner::NextTokenLookahead() const {
-    auto mark = Mark();
-    mark.ApplyOnDestroy();
-    return const_cast<Scanner*>(this)->NextToken();
+    return cache[pos];
 }
 
 Scanner::BookMark::BookMark(Scanner* scanner)
     : scanner(scanner)
     , pos(scanner->pos)
     , apply_on_destroy(false)
-{}
+{
+    scanner->marks.push_back(scanner->marks.empty() ? pos : std::min(pos, scanner->marks.back()));
+}
 
 void Scanner::BookMark::Apply() {
     scanner->pos = pos;
@@ -78,6 +78,7 @@ Scanner::BookMark::~BookMark() {
     if (apply_on_destroy) {
         Apply();
     }
+    scanner->marks.pop_back();
 }
 
 
@@ -1,36 +1,100 @@
 #include <parser/token_stream.hpp>
 
+#include <unicode/uchar.h>
+#include <unicode/utf16.h>
+
+#include <array>
+
 
 namespace nlang {
 
+namespace {
+
+/**
+ * Classes of ASCII characters, used to select DFA branch by first character of the token
+ */
+enum class CharClass : uint8_t {
+    INVALID,
+    SPACE,
+    NEWLINE,
+    LETTER,
+    DIGIT,
+    QUOTE,
+    OPERATOR,
+};
+
+constexpr std::array<CharClass, 128> MakeCharClasses() {
+    std::array<CharClass, 128> classes {};
+    classes[' '] = classes['\t'] = classes['\r'] = CharClass::SPACE;
+    classes['\n'] = CharClass::NEWLINE;
+    for (char c = 'a'; c <= 'z'; ++c) {
+        classes[c] = CharClass::LETTER;
+    }
+    for (char c = 'A'; c <= 'Z'; ++c) {
+        classes[c] = CharClass::LETTER;
+    }
+    classes['_'] = CharClass::LETTER;
+    for (char c = '0'; c <= '9'; ++c) {
+        classes[c] = CharClass::DIGIT;
+    }
+    classes['"'] = classes['\''] = CharClass::QUOTE;
+    for (char c : "()[]{};:,.=*/+-!><~&|^%") {
+        if (c) {
+            classes[c] = CharClass::OPERATOR;
+        }
+    }
+    return classes;
+}
+
+constexpr std::array<CharClass, 128> char_classes = MakeCharClasses();
+
+NLANG_FORCE_INLINE bool IsAscii(char16_t c) {
+    return c < 0x80;
+}
 
-TokenStream::TokenStream(UString&& source_)
+NLANG_FORCE_INLINE bool IsDigit(char16_t c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Identifiers may contain ASCII letters, digits, underscores and any non-ASCII characters
+ */
+NLANG_FORCE_INLINE bool IsIdentifierPart(char16_t c) {
+    return !IsAscii(c) || char_classes[c] == CharClass::LETTER || char_classes[c] == CharClass::DIGIT;
+}
+
+/**
+ * Line terminators, as they are understood by '.' and '$' in regular expressions
+ */
+NLANG_FORCE_INLINE bool IsLineTerminator(char16_t c) {
+    return (c >= 0x0a && c <= 0x0d) || c == 0x85 || c == 0x2028 || c == 0x2029;
+}
+
+}
+
+
+TokenStream::TokenStream(SharedPtr<Source> source_)
     : source(std::move(source_))
-    , source_view(source.SubStringView())
+    , buffer(source->GetBuffer())
+    , length(source->GetLength())
     , pos(0)
     , row(1)
     , col(1)
-{
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(R"(^[ \t\r]+)", regex_flags, error_code), Token::SPACE);
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(R"(^\/\/.*?(\n|$))", regex_flags, error_code), Token::COMMENT);
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(R"(^\/\*.*?\*\/)", regex_flags, error_code), Token::COMMENT);
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(
-        R"(^((\+\+|\-\-|\+=|-=|\*=|\/=|\%=|==|!=|>=|<=|<<|>>)|\(|\)|\{|\}|\[|\]|;|:|,|\.|=|\*|\/|\+|\-|!|>|<|\~|&|\||\^))",
-        regex_flags, error_code), Token::OPERATOR_OR_PUNCTUATION);
-    regex_tokens.emplace_back(
-        MakeUnique<icu::RegexMatcher>(R"(^([^\x00-\x7F]|[a-zA-Z_])([^\x00-\x7F]|[a-zA-Z0-9_])*)", regex_flags,
-                                      error_code), Token::IDENTIFIER);
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(R"(^"[^"\\]*(?:\\.[^"\\]*)*")", regex_flags, error_code), Token::STRING);
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(R"(^'[^'\\]*(?:\\.[^'\\]*)*')", regex_flags, error_code), Token::STRING);
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(R"(^[0-9]+(\.[0-9]+)?\b)", regex_flags, error_code), Token::NUMBER);
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(R"(^\n)", regex_flags, error_code), Token::NEWLINE);
-    regex_tokens.emplace_back(MakeUnique<icu::RegexMatcher>(R"(^.)", regex_flags, error_code), Token::INVALID);
-}
-
-TokenStream::TokenStream(const UString &source_)
-    : TokenStream(UString(source_))
+    , trivia(Trivia::KEEP)
+    , after_newline(false)
+    , lookahead(0)
 {}
 
+bool TokenStream::Decode(int32_t at) {
+    while (source->DecodeNextChunk()) {
+        length = source->GetLength();
+        if (at < length) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool TokenStream::HasNext() {
     return pos != -1;
 }
@@ -38,40 +102,277 @@ bool TokenStream::HasNext() {
 TokenInstance TokenStream::Next() {
     NLANG_ASSERT(HasNext());
 
-    while (pos != source.GetLength()) {
-        for (auto& [regex, token] : regex_tokens) {
-            regex->reset(source_view);
-            if (regex->find(error_code)) {
-                UString str(regex->group(error_code));
-
-                Token actual_token = token;
-                if (token == Token::OPERATOR_OR_PUNCTUATION || token == Token::IDENTIFIER) {
-                    try {
-                        actual_token = TokenUtils::GetTokenByText(str);
-                    } catch (std::out_of_range&) {}
-                }
-
-                const int32_t saved_row = row;
-                const int32_t saved_column = col;
-
-                for (int32_t i = 0; i < str.GetLength(); ++i) {
-                    ++col;
-                    if (str.GetCharAt(i) == '\n') {
-                        row++;
-                        col = 1;
+    TokenInstance token = ScanToken();
+    while (token.token == Token::SPACE || token.token == Token::NEWLINE || token.token == Token::COMMENT) {
+        // line comment includes the line break
+        if (token.token == Token::NEWLINE || (token.token == Token::COMMENT && token.source[token.length - 1] == '\n')) {
+            after_newline = true;
+        }
+        if (trivia == Trivia::KEEP) {
+            return token;
+        }
+        if (token.token == Token::COMMENT && trivia == Trivia::SKIP_COLLECT_COMMENTS) {
+            comments.push_back(token);
+        }
+        token = ScanToken();
+    }
+    token.preceded_by_newline = after_newline;
+    after_newline = false;
+    return token;
+}
+
+void TokenStream::SetTrivia(Trivia trivia_) {
+    trivia = trivia_;
+}
+
+void TokenStream::Seek(int32_t position) {
+    NLANG_ASSERT(position >= 0);
+    pos = position;
+    row = 1;
+    col = 1;
+    after_newline = false;
+}
+
+TokenInstance TokenStream::ScanToken() {
+    lookahead = pos;
+    if (!Has(pos)) {
+        pos = -1;
+        return TokenInstance { Token::THE_EOF, false, pos, 0, row, col, buffer + length };
+    }
+
+    int32_t end;
+    Token token = Scan(end);
+
+    if (token == Token::IDENTIFIER) {
+        if (auto keyword = TokenUtils::FindTokenByText(std::u16string_view(buffer + pos, end - pos))) {
+            token = *keyword;
+        }
+    }
+
+    const int32_t saved_row = row;
+    const int32_t saved_column = col;
+
+    for (int32_t i = pos; i < end; ++i) {
+        ++col;
+        if (buffer[i] == '\n') {
+            row++;
+            col = 1;
+        }
+    }
+
+    const int32_t pos_in_string = pos;
+    pos = end;
+    return TokenInstance { token, false, pos_in_string, end - pos_in_string, saved_row, saved_column, buffer + pos_in_string };
+}
+
+Token TokenStream::Scan(int32_t& end) {
+    const char16_t c = buffer[pos];
+
+    if (!IsAscii(c)) {
+        end = pos + 1;
+        while (Has(end) && IsIdentifierPart(buffer[end])) {
+            ++end;
+        }
+        return Token::IDENTIFIER;
+    }
+
+    const char16_t next = Has(pos + 1) ? buffer[pos + 1] : 0;
+
+    switch (char_classes[c]) {
+        case CharClass::SPACE: {
+            end = pos + 1;
+            while (Has(end) && IsAscii(buffer[end]) && char_classes[buffer[end]] == CharClass::SPACE) {
+                ++end;
+            }
+            return Token::SPACE;
+        }
+
+        case CharClass::NEWLINE: {
+            end = pos + 1;
+            return Token::NEWLINE;
+        }
+
+        case CharClass::LETTER: {
+            end = pos + 1;
+            while (Has(end) && IsIdentifierPart(buffer[end])) {
+                ++end;
+            }
+            return Token::IDENTIFIER;
+        }
+
+        case CharClass::DIGIT: {
+            if ((end = ScanNumber(pos)) != -1) {
+                return Token::NUMBER;
+            }
+            break;
+        }
+
+        case CharClass::QUOTE: {
+            if ((end = ScanString(pos)) != -1) {
+                return Token::STRING;
+            }
+            break;
+        }
+
+        case CharClass::OPERATOR: {
+            end = pos + 2;
+            switch (c) {
+                case '/':
+                    if (next == '/' && (end = ScanLineComment(pos)) != -1) {
+                        return Token::COMMENT;
                     }
-                }
+                    if (next == '*' && (end = ScanBlockComment(pos)) != -1) {
+                        return Token::COMMENT;
+                    }
+                    end = pos + 2;
+                    if (next == '=') return Token::ASSIGN_DIV;
+                    break;
+                case '+':
+                    if (next == '+') return Token::ADD_ADD;
+                    if (next == '=') return Token::ASSIGN_ADD;
+                    break;
+                case '-':
+                    if (next == '-') return Token::SUB_SUB;
+                    if (next == '=') return Token::ASSIGN_SUB;
+                    break;
+                case '*':
+                    if (next == '=') return Token::ASSIGN_MUL;
+                    break;
+                case '%':
+                    if (next == '=') return Token::ASSIGN_REMAINDER;
+                    // single '%' is not an operator
+                    end = pos + 1;
+                    return Token::INVALID;
+                case '=':
+                    if (next == '=') return Token::EQUALS;
+                    break;
+                case '!':
+                    if (next == '=') return Token::NOT_EQUALS;
+                    break;
+                case '>':
+                    if (next == '=') return Token::GREATER_EQUALS;
+                    if (next == '>') return Token::RIGHT_SHIFT;
+                    break;
+                case '<':
+                    if (next == '=') return Token::LESS_EQUALS;
+                    if (next == '<') return Token::LEFT_SHIFT;
+                    break;
+                default:
+                    break;
+            }
+
+            end = pos + 1;
+            switch (c) {
+                case '(': return Token::LEFT_PAR;
+                case ')': return Token::RIGHT_PAR;
+                case '{': return Token::LEFT_BRACE;
+                case '}': return Token::RIGHT_BRACE;
+                case '[': return Token::LEFT_BRACKET;
+                case ']': return Token::RIGHT_BRACKET;
+                case ';': return Token::SEMICOLON;
+                case ':': return Token::COLON;
+                case ',': return Token::COMMA;
+                case '.': return Token::DOT;
+                case '=': return Token::ASSIGN;
+                case '*': return Token::MUL;
+                case '/': return Token::DIV;
+                case '+': return Token::ADD;
+                case '-': return Token::SUB;
+                case '>': return Token::GREATER;
+                case '<': return Token::LESS;
+                case '~': return Token::TILDE;
+                case '&': return Token::BIT_AND;
+                case '|': return Token::BIT_OR;
+                case '^': return Token::BIT_XOR;
+                default: return Token::OPERATOR_OR_PUNCTUATION;
+            }
+        }
+
+        default:
+            break;
+    }
+
+    end = pos + 1;
+    return Token::INVALID;
+}
+
+int32_t TokenStream::ScanLineComment(int32_t from) {
+    int32_t i = from + 2;
+    while (Has(i) && !IsLineTerminator(buffer[i])) {
+        ++i;
+    }
+    if (!Has(i)) {
+        return i;
+    }
+    if (buffer[i] == '\n') {
+        return i + 1;
+    }
+    // line terminator, that ends the source, is not included into the comment
+    if (!Has(i + 1) || (buffer[i] == '\r' && buffer[i + 1] == '\n' && !Has(i + 2))) {
+        return i;
+    }
+    return -1;
+}
+
+int32_t TokenStream::ScanBlockComment(int32_t from) {
+    for (int32_t i = from + 2; Has(i) && !IsLineTerminator(buffer[i]); ++i) {
+        if (buffer[i] == '*' && Has(i + 1) && buffer[i + 1] == '/') {
+            return i + 2;
+        }
+    }
+    return -1;
+}
 
-                const int32_t pos_in_string = pos;
-                pos += str.GetLength();
-                source_view = source.SubStringView(pos);
-                return TokenInstance { actual_token, pos_in_string, str.GetLength(), saved_row, saved_column, std::move(str) };
+int32_t TokenStream::ScanString(int32_t from) {
+    const char16_t quote = buffer[from];
+    int32_t i = from + 1;
+    while (Has(i)) {
+        if (buffer[i] == quote) {
+            return i + 1;
+        }
+        if (buffer[i] == '\\') {
+            if (!Has(i + 1) || IsLineTerminator(buffer[i + 1])) {
+                return -1;
             }
+            ++i;
+        }
+        ++i;
+    }
+    return -1;
+}
+
+int32_t TokenStream::ScanNumber(int32_t from) {
+    int32_t i = from;
+    while (Has(i) && IsDigit(buffer[i])) {
+        ++i;
+    }
+    if (Has(i + 1) && buffer[i] == '.' && IsDigit(buffer[i + 1])) {
+        int32_t j = i + 1;
+        while (Has(j) && IsDigit(buffer[j])) {
+            ++j;
+        }
+        if (IsWordBoundary(j)) {
+            return j;
         }
     }
+    return IsWordBoundary(i) ? i : -1;
+}
 
-    pos = -1;
-    return TokenInstance { Token::THE_EOF, pos, 0, row, col, UString() };
+bool TokenStream::IsWordBoundary(int32_t at) {
+    // Character before is always a digit, so it is a boundary if the next character is not a word character
+    if (!Has(at)) {
+        return true;
+    }
+    if (IsAscii(buffer[at])) {
+        return !IsIdentifierPart(buffer[at]);
+    }
+    // surrogate pairs are never split between decoded chunks
+    UChar32 c;
+    U16_GET(buffer, 0, at, length, c);
+    if (u_hasBinaryProperty(c, UCHAR_GRAPHEME_EXTEND) || u_charType(c) == U_FORMAT_CHAR) {
+        return false;
+    }
+    return !(u_hasBinaryProperty(c, UCHAR_ALPHABETIC) || (U_GET_GC_MASK(c) & (U_GC_M_MASK | U_GC_ND_MASK | U_GC_PC_MASK)));
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+
+#include <parser/lexing_session.hpp>
+#include <parser/token_stream.hpp>
+
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using Tokens = std::vector<std::tuple<int32_t, int32_t, nlang::Token>>;
+
+Tokens Tokenize(const nlang::UString& text) {
+    using namespace nlang;
+    Tokens tokens;
+    auto stream = TokenStream::New(text);
+    while (stream->HasNext()) {
+        auto token = stream->Next();
+        if (token.token != Token::THE_EOF) {
+            tokens.emplace_back(token.pos, token.length, token.token);
+        }
+    }
+    return tokens;
+}
+
+Tokens GetTokens(const nlang::LexingSession& session) {
+    Tokens tokens;
+    for (const auto& entry : session.GetTokens()) {
+        tokens.emplace_back(entry.pos, entry.length, entry.token);
+    }
+    return tokens;
+}
+
+}
+
+TEST_CASE("lexing session rescans only affected tokens") {
+    using namespace nlang;
+
+    auto session = LexingSession::New();
+    std::u16string text = u"let a = 1\nlet b = 'str'\nlet c = a + b // comment\n";
+    auto patch = session->Edit(0, 0, text);
+    REQUIRE(patch.first == 0);
+    REQUIRE(patch.removed == 0);
+    REQUIRE(patch.inserted == session->GetTokens().size());
+    REQUIRE(GetTokens(*session) == Tokenize(session->GetText()));
+
+    // rename 'b' in the second line, space before it looked at it too
+    patch = session->Edit(14, 15, u"bb");
+    REQUIRE(patch.first == 9);
+    REQUIRE(patch.removed == 2);
+    REQUIRE(patch.inserted == 2);
+    REQUIRE(GetTokens(*session) == Tokenize(session->GetText()));
+
+    // unterminated quote depends on the rest of the text
+    session->Edit(0, 0, u"\"");
+    REQUIRE(session->GetTokens()[0].token == Token::INVALID);
+    patch = session->Edit(session->GetText().GetLength(), session->GetText().GetLength(), u"\"");
+    REQUIRE(patch.first == 0);
+    REQUIRE(session->GetTokens().size() == 1);
+    REQUIRE(session->GetTokens()[0].token == Token::STRING);
+    REQUIRE(GetTokens(*session) == Tokenize(session->GetText()));
+}
+
+TEST_CASE("lexing session matches full scan after random edits") {
+    using namespace nlang;
+
+    const std::u16string alphabet = u"ab1.5 \n\r/*'\"\\=+-<>()\u0439";
+    std::mt19937 random(42);
+    auto random_text = [&](size_t max_length) {
+        std::u16string text(random() % (max_length + 1), u' ');
+        for (auto& c : text) {
+            c = alphabet[random() % alphabet.size()];
+        }
+        return text;
+    };
+
+    for (int session_index = 0; session_index < 50; ++session_index) {
+        auto session = LexingSession::New();
+        session->Edit(0, 0, random_text(200));
+        for (int edit = 0; edit < 100; ++edit) {
+            const int32_t length = session->GetText().GetLength();
+            const int32_t start = length ? random() % (length + 1) : 0;
+            const int32_t end = start + (length - start ? random() % std::min(length - start + 1, 10) : 0);
+            session->Edit(start, end, random_text(5));
+            REQUIRE(GetTokens(*session) == Tokenize(session->GetText()));
+        }
+    }
+}
\ No newline at end of file
@@ -4,10 +4,136 @@
 #include <parser/scanner.hpp>
 #include <parser/parser.hpp>
 
-TEST_CASE("parser test") {
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * Removes the file, when the test leaves the scope, even if it fails
+ */
+class TempFile {
+public:
+    explicit TempFile(std::filesystem::path path)
+        : path(std::move(path))
+    {}
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    ~TempFile() {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    const std::filesystem::path path;
+};
+
+/**
+ * @return Resident anonymous memory of the process in bytes (mapped files are excluded), 0 if it is unknown
+ */
+size_t GetResidentSize() {
+#ifdef __linux__
+    size_t total = 0;
+    size_t resident = 0;
+    size_t shared = 0;
+    std::ifstream("/proc/self/statm") >> total >> resident >> shared;
+    return (resident - shared) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Memory, used by statement-by-statement parsing of a module
+ */
+struct StreamingParseStats {
+    size_t statements = 0;
+    /** Maximum count of tokens, kept by the scanner */
+    size_t max_cache_size = 0;
+    /** Maximum size of the arena of a statement in bytes */
+    size_t max_arena_size = 0;
+    /** Maximum growth of the resident anonymous memory in bytes, excluding the decoded source */
+    size_t max_resident_growth = 0;
+};
+
+/**
+ * Writes the module of the repeated unit of statements
+ * @param path Path of the module
+ * @param module_size Size of the module in bytes, it is rounded up to units
+ * @return Count of the statements in the module
+ */
+size_t WriteModule(const std::filesystem::path& path, size_t module_size) {
+    const std::string unit = R"(
+fn function_name(first, second) {
+    // comment, that takes some space
+    let value = first * (second + 12.5) - call(first, 'string literal')
+    if (value > 0) {
+        return value
+    } else {
+        while (value < 100) { value += 1 }
+    }
+    return -value
+}
+let variable = function_name(1, 2) + function_name(3, 4)
+)";
+    std::ofstream file(path, std::ios::binary);
+    size_t statements = 0;
+    for (size_t size = 0; size < module_size; size += unit.size()) {
+        file << unit;
+        statements += 2;
+    }
+    return statements;
+}
+
+/**
+ * Parses the module statement by statement, nodes of each statement are freed with its arena
+ * @param path Path of the module
+ * @return Memory, used by the parsing
+ */
+StreamingParseStats ParseByStatements(const std::filesystem::path& path) {
     using namespace nlang;
 
-    Heap heap;
+    auto source = Source::FromFile(path.string());
+    auto scanner = Scanner::New(TokenStream::New(source));
+    auto scanner_ptr = scanner.get();
+    auto parser = Parser::New(std::move(scanner));
+
+    StreamingParseStats stats;
+    const size_t initial_resident_size = GetResidentSize();
+    while (!scanner_ptr->IsEOF()) {
+        {
+            ast::Arena arena;
+            parser->ParseStatement(arena);
+            stats.max_arena_size = std::max(stats.max_arena_size, arena.GetReservedSize());
+        }
+        ++stats.statements;
+        stats.max_cache_size = std::max(stats.max_cache_size, scanner_ptr->GetCacheSize());
+        if (stats.statements % 4096 == 0) {
+            // the decoded source is kept, as tokens refer to it, the rest must not grow
+            const size_t source_size = static_cast<size_t>(source->GetLength()) * sizeof(char16_t);
+            const size_t resident_size = GetResidentSize();
+            if (resident_size > initial_resident_size + source_size) {
+                stats.max_resident_growth = std::max(stats.max_resident_growth,
+                                                     resident_size - initial_resident_size - source_size);
+            }
+        }
+    }
+    return stats;
+}
+
+}
+
+TEST_CASE("parser test") {
+    using namespace nlang;
 
     const std::string source =
 R"(fn print_my_name_and_predict_age(first_name: string, last_name: string = 'Smith') : number {
@@ -30,8 +156,9 @@ R"(fn print_my_name_and_predict_age(first_name: string, last_name: string = 'Smi
     return static_age
 })";
 
-    auto parser = Parser::New(Scanner::New(TokenStream::New(&heap, String::New(&heap, source))));
-    auto ast = parser->ParseFunctionDefinitionExpression();
+    auto parser = Parser::New(Scanner::New(TokenStream::New(UString(source))));
+    ast::Arena arena;
+    auto ast = parser->ParseExpression(arena);
 
     REQUIRE(ast::ASTStringifier().Stringify(*ast) ==
 R"(fn print_my_name_and_predict_age(first_name: string, last_name: string = 'Smith'): number {
@@ -55,4 +182,46 @@ R"(fn print_my_name_and_predict_age(first_name: string, last_name: string = 'Smi
     return static_age
 })");
 
+}
+
+TEST_CASE("module outlives parser") {
+    using namespace nlang;
+
+    UniquePtr<ast::Module> module;
+    {
+        auto parser = Parser::New(Scanner::New(TokenStream::New(UString("let some_long_identifier_name = 'string \\' literal' + 12.5"))));
+        module = parser->ParseModule();
+    }
+
+    REQUIRE(module->source);
+    REQUIRE(ast::ASTStringifier().Stringify(*module) == UString("let some_long_identifier_name = 'string ' literal' + 12.500000"));
+}
+
+
+TEST_CASE("parser memory does not depend on module size") {
+    using namespace nlang;
+
+    const TempFile temp_file(std::filesystem::temp_directory_path() /
+                             ("nlang_parser_memory_test_" + std::to_string(std::random_device()()) + ".nl"));
+    const size_t statements = WriteModule(temp_file.path, 4 * 1024 * 1024);
+
+    // tokens, kept by the scanner, and nodes of a statement fit into fixed amount of memory regardless of module size
+    const size_t memory_cap = 64 * 1024;
+    const auto stats = ParseByStatements(temp_file.path);
+    REQUIRE(stats.statements == statements);
+    REQUIRE(stats.max_cache_size * sizeof(TokenInstance) <= memory_cap);
+    REQUIRE(stats.max_arena_size <= memory_cap);
+}
+
+TEST_CASE("parser memory of a big module", "[.][benchmark]") {
+    using namespace nlang;
+
+    const TempFile temp_file(std::filesystem::temp_directory_path() /
+                             ("nlang_parser_memory_benchmark_" + std::to_string(std::random_device()()) + ".nl"));
+    const size_t statements = WriteModule(temp_file.path, 100 * 1024 * 1024);
+
+    // process memory depends on the platform and the build (e.g. sanitizers), so it is only checked here
+    const auto stats = ParseByStatements(temp_file.path);
+    REQUIRE(stats.statements == statements);
+    REQUIRE(stats.max_resident_growth <= 64 * 1024 * 1024);
 }
\ No newline at end of file
@@ -10,37 +10,57 @@ TEST_CASE("scanner test") {
 
     const std::string s = "_345kek lol; for + -= \n     /*block comment*/    $$$ 0.5123   ololo()\n  kek  // line comment ";
 
-    Heap heap;
-
-    auto scanner = Scanner::New(TokenStream::New(&heap, String::New(&heap, s)));
+    auto scanner = Scanner::New(TokenStream::New(UString(s)));
 
     REQUIRE(!scanner->IsEOF());
     REQUIRE(!scanner->IsEOL());
     REQUIRE(scanner->NextTokenLookahead().token == Token::IDENTIFIER);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "_345kek"));
+    REQUIRE(scanner->NextToken().GetText() == UString("_345kek"));
     REQUIRE(scanner->NextTokenLookahead().token == Token::IDENTIFIER);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "lol"));
+    REQUIRE(scanner->NextToken().GetText() == UString("lol"));
     REQUIRE(!scanner->IsEOL());
     REQUIRE(scanner->NextToken().token == Token::SEMICOLON);
     REQUIRE(scanner->NextTokenLookahead().token == Token::FOR);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "for"));
+    REQUIRE(scanner->NextToken().GetText() == UString("for"));
     REQUIRE(scanner->NextTokenLookahead().token == Token::ADD);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "+"));
+    REQUIRE(scanner->NextToken().GetText() == UString("+"));
     REQUIRE(scanner->NextTokenLookahead().token == Token::ASSIGN_SUB);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "-="));
+    REQUIRE(scanner->NextToken().GetText() == UString("-="));
     REQUIRE(!scanner->IsEOF());
     REQUIRE(scanner->IsEOL());
-    REQUIRE(scanner->NextTokenLookahead().token == Token::INVALID);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "$$$"));
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(scanner->NextTokenLookahead().token == Token::INVALID);
+        REQUIRE(scanner->NextToken().GetText() == UString("$"));
+    }
     REQUIRE(scanner->NextTokenLookahead().token == Token::NUMBER);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "0.5123"));
+    REQUIRE(scanner->NextToken().GetText() == UString("0.5123"));
     REQUIRE(scanner->NextTokenLookahead().token == Token::IDENTIFIER);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "ololo"));
+    REQUIRE(scanner->NextToken().GetText() == UString("ololo"));
     REQUIRE(scanner->NextToken().token == Token::LEFT_PAR);
     REQUIRE(scanner->NextToken().token == Token::RIGHT_PAR);
     REQUIRE(scanner->IsEOL());
     REQUIRE(scanner->NextTokenLookahead().token == Token::IDENTIFIER);
-    REQUIRE(scanner->NextToken().text == String::New(&heap, "kek"));
+    REQUIRE(scanner->NextToken().GetText() == UString("kek"));
+    REQUIRE(scanner->IsEOL());
+    REQUIRE(scanner->IsEOF());
+}
+
+TEST_CASE("scanner line breaks") {
+    using namespace nlang;
+
+    auto scanner = Scanner::New(TokenStream::New(UString("a /* b */ + c // d\n- e\r\n\n  f")));
+
+    REQUIRE(scanner->NextToken().GetText() == UString("a"));
+    REQUIRE(!scanner->IsEOL());
+    REQUIRE(scanner->NextToken().token == Token::ADD);
+    REQUIRE(scanner->NextToken().GetText() == UString("c"));
+    // line comment ends the line
+    REQUIRE(scanner->IsEOL());
+    REQUIRE(scanner->NextToken().token == Token::SUB);
+    REQUIRE(!scanner->NextToken().preceded_by_newline);
     REQUIRE(scanner->IsEOL());
+    REQUIRE(scanner->NextToken().preceded_by_newline);
     REQUIRE(scanner->IsEOF());
+    REQUIRE(scanner->NextToken().token == Token::THE_EOF);
+    REQUIRE(scanner->NextToken().token == Token::THE_EOF);
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include <catch2/catch.hpp>
+
+#include <parser/token_stream.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+
+namespace {
+
+std::vector<std::pair<nlang::Token, nlang::UString>> Tokenize(const nlang::UString& source) {
+    using namespace nlang;
+    std::vector<std::pair<Token, UString>> tokens;
+    auto stream = TokenStream::New(source);
+    while (stream->HasNext()) {
+        auto token = stream->Next();
+        tokens.emplace_back(token.token, token.GetText());
+    }
+    return tokens;
+}
+
+}
+
+TEST_CASE("token stream edge cases") {
+    using namespace nlang;
+    using Tokens = std::vector<std::pair<Token, UString>>;
+
+    SECTION("numbers are followed by word boundary") {
+        REQUIRE(Tokenize("1.5 12a") == Tokens {
+            { Token::NUMBER, "1.5" }, { Token::SPACE, " " },
+            { Token::INVALID, "1" }, { Token::INVALID, "2" }, { Token::IDENTIFIER, "a" },
+            { Token::THE_EOF, "" } });
+        REQUIRE(Tokenize("1.5a") == Tokens {
+            { Token::NUMBER, "1" }, { Token::DOT, "." }, { Token::INVALID, "5" }, { Token::IDENTIFIER, "a" },
+            { Token::THE_EOF, "" } });
+    }
+
+    SECTION("comments do not span lines") {
+        REQUIRE(Tokenize("/* a\n*/") == Tokens {
+            { Token::DIV, "/" }, { Token::MUL, "*" }, { Token::SPACE, " " }, { Token::IDENTIFIER, "a" },
+            { Token::NEWLINE, "\n" }, { Token::MUL, "*" }, { Token::DIV, "/" },
+            { Token::THE_EOF, "" } });
+        REQUIRE(Tokenize("// a\nb") == Tokens {
+            { Token::COMMENT, "// a\n" }, { Token::IDENTIFIER, "b" },
+            { Token::THE_EOF, "" } });
+        REQUIRE(Tokenize("// a\r\n") == Tokens {
+            { Token::COMMENT, "// a" }, { Token::SPACE, "\r" }, { Token::NEWLINE, "\n" },
+            { Token::THE_EOF, "" } });
+    }
+
+    SECTION("operators, keywords and strings") {
+        REQUIRE(Tokenize("a<<=b!c%d 'x\\'y'and\"\xd0\xb9\"") == Tokens {
+            { Token::IDENTIFIER, "a" }, { Token::LEFT_SHIFT, "<<" }, { Token::ASSIGN, "=" },
+            { Token::IDENTIFIER, "b" }, { Token::OPERATOR_OR_PUNCTUATION, "!" }, { Token::IDENTIFIER, "c" },
+            { Token::INVALID, "%" }, { Token::IDENTIFIER, "d" }, { Token::SPACE, " " },
+            { Token::STRING, "'x\\'y'" }, { Token::AND, "and" }, { Token::STRING, "\"\xd0\xb9\"" },
+            { Token::THE_EOF, "" } });
+    }
+
+    SECTION("non-ascii identifiers") {
+        REQUIRE(Tokenize("\xd0\xb9\xd1\x86_1 \xf0\x9f\x98\x80") == Tokens {
+            { Token::IDENTIFIER, "\xd0\xb9\xd1\x86_1" }, { Token::SPACE, " " }, { Token::IDENTIFIER, "\xf0\x9f\x98\x80" },
+            { Token::THE_EOF, "" } });
+    }
+}
+
+TEST_CASE("token stream trivia modes") {
+    using namespace nlang;
+
+    const UString source("a // b\n/* c */ d");
+
+    auto keep = TokenStream::New(source);
+    std::vector<Token> tokens;
+    while (keep->HasNext()) {
+        tokens.push_back(keep->Next().token);
+    }
+    REQUIRE(tokens == std::vector<Token> { Token::IDENTIFIER, Token::SPACE, Token::COMMENT, Token::COMMENT, Token::SPACE, Token::IDENTIFIER, Token::THE_EOF });
+
+    auto skip = TokenStream::New(source);
+    skip->SetTrivia(TokenStream::Trivia::SKIP_COLLECT_COMMENTS);
+    auto a = skip->Next();
+    REQUIRE((a.token == Token::IDENTIFIER && !a.preceded_by_newline));
+    auto d = skip->Next();
+    REQUIRE((d.GetText() == UString("d") && d.preceded_by_newline));
+    REQUIRE(skip->Next().token == Token::THE_EOF);
+    REQUIRE(!skip->HasNext());
+    REQUIRE(skip->GetComments().size() == 2);
+    REQUIRE(skip->GetComments()[0].GetText() == UString("// b\n"));
+    REQUIRE(skip->GetComments()[1].GetText() == UString("/* c */"));
+}
+
+TEST_CASE("token stream over memory-mapped file") {
+    using namespace nlang;
+
+    std::string text = "\xef\xbb\xbf";
+    for (int i = 0; i < 100; ++i) {
+        text += "let \xd0\xb9\xd1\x86 = '\xf0\x9f\x98\x80 string' // \xd0\xba\xd0\xbe\xd0\xbc\xd0\xbc\xd0\xb5\xd0\xbd\xd1\x82\n"
+                "fn f(a, b) { return a + b * 2.5 }\r\n";
+    }
+    const auto path = std::filesystem::temp_directory_path() / "nlang_token_stream_test.nl";
+    std::ofstream(path, std::ios::binary) << text;
+
+    // small odd chunks split multibyte sequences and tokens
+    auto source = Source::FromFile(path.string(), 7);
+    REQUIRE(source->GetLength() == 0);
+
+    auto stream = TokenStream::New(source);
+    auto expected = TokenStream::New(UString(text.substr(3)));
+    REQUIRE(stream->Next().GetText() == expected->Next().GetText());
+    REQUIRE(!source->IsDecoded());
+
+    while (expected->HasNext()) {
+        REQUIRE(stream->HasNext());
+        auto token = stream->Next();
+        auto expected_token = expected->Next();
+        REQUIRE(token.token == expected_token.token);
+        REQUIRE(token.GetText() == expected_token.GetText());
+        REQUIRE(token.pos == expected_token.pos);
+        REQUIRE(token.row == expected_token.row);
+        REQUIRE(token.column == expected_token.column);
+    }
+    REQUIRE(!stream->HasNext());
+    REQUIRE(source->IsDecoded());
+
+    std::filesystem::remove(path);
+    REQUIRE_THROWS_AS(Source::FromFile(path.string()), std::runtime_error);
+}
+
+TEST_CASE("token lookup by text") {
+    using namespace nlang;
+
+#define T(token, value) \
+    if (std::string_view(value).empty()) { \
+        REQUIRE(!TokenUtils::FindTokenByText(u"")); \
+    } else { \
+        REQUIRE(TokenUtils::FindTokenByText(UString(value).getBuffer()) == Token::token); \
+        REQUIRE(TokenUtils::GetTokenByText(value) == Token::token); \
+    }
+    TOKENS_LIST
+#undef T
+
+    REQUIRE(!TokenUtils::FindTokenByText(u"iff"));
+    REQUIRE(!TokenUtils::FindTokenByText(u"retur"));
+    REQUIRE(!TokenUtils::FindTokenByText(u"continues"));
+    REQUIRE(!TokenUtils::FindTokenByText(u"!"));
+    REQUIRE_THROWS_AS(TokenUtils::GetTokenByText("identifier"), std::out_of_range);
+}
+
+TEST_CASE("token stream throughput", "[.][benchmark]") {
+    using namespace nlang;
+
+    const std::string unit = R"(
+fn fibonacci(n) {
+    // compute fibonacci number
+    if (n == 1) {
+        return 0
+    } else if (n <= 2) {
+        return 1 /* inline */
+    }
+    let s = "some string literal"
+    return fibonacci(n - 1) + fibonacci(n - 2.5)
+}
+)";
+    std::string source;
+    for (int i = 0; i < 10000; ++i) {
+        source += unit;
+    }
+
+    const UString usource(source);
+    const auto start = std::chrono::steady_clock::now();
+    auto stream = TokenStream::New(usource);
+    size_t count = 0;
+    while (stream->HasNext()) {
+        stream->Next();
+        ++count;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << count << " tokens in " << elapsed.count() << " s (" << count / elapsed.count() << " tokens/s)" << std::endl;
+    REQUIRE(count > 0);
+}
\ No newline at end of file
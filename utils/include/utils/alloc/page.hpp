@@ -29,7 +29,7 @@ public:
         NLANG_FORCE_INLINE ~PageIterator() = default;
 
         NLANG_FORCE_INLINE difference_type operator-(const PageIterator& other) const {
-            return std::distance(static_cast<uint8_t*>(data), static_cast<uint8_t*>(other.data)) / Page::size();
+            return std::distance(static_cast<uint8_t*>(other.data), static_cast<uint8_t*>(data)) / static_cast<difference_type>(Page::size());
         }
 
         NLANG_FORCE_INLINE PageIterator operator+(difference_type count) const {
@@ -116,7 +116,21 @@ public:
         void* data;
     };
 
-    static std::pair<PageIterator, PageIterator> AllocateRange(size_t count = 1);
+    /**
+     * Allocates consecutive pages
+     * @param count Count of the pages
+     * @param commit Whether the pages are accessible right away, otherwise they are only reserved and must be
+     * committed with CommitRange before the access (e.g. to grow the region on demand)
+     * @return The pages
+     */
+    static std::pair<PageIterator, PageIterator> AllocateRange(size_t count = 1, bool commit = true);
+
+    /**
+     * Makes the reserved pages accessible
+     * @param range The pages, part of the range, allocated without commit
+     */
+    static void CommitRange(const std::pair<PageIterator, PageIterator>& range);
+
     static void FreeRange(const std::pair<PageIterator, PageIterator>& range);
 
     static Page* Allocate();
@@ -2,4 +2,5 @@
 
 #include <utils/containers/forward_list_view.hpp>
 #include <utils/containers/nan_boxed_primitive.hpp>
+#include <utils/containers/segmented_stack.hpp>
 #include <utils/containers/slot_storage.hpp>
\ No newline at end of file
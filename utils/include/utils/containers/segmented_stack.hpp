@@ -0,0 +1,127 @@
+#pragma once
+
+#include <utils/macro.hpp>
+#include <utils/alloc/page.hpp>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace nlang {
+
+/**
+ * A stack of trivially copyable values, stored in a chain of pages (segments).
+ * Unlike vector, it never copies the values to grow, and its size is limited only by the memory, so it is used for
+ * worklists, whose size is not known beforehand (e.g. grey values of the garbage collector). One free segment is kept
+ * to avoid allocating a page each time the stack goes back and forth across the border of segments.
+ * @tparam T Type of the values
+ */
+template<typename T>
+class SegmentedStack {
+    static_assert(std::is_trivially_copyable_v<T>, "values must be trivially copyable");
+
+public:
+    SegmentedStack() = default;
+    SegmentedStack(const SegmentedStack&) = delete;
+    SegmentedStack(SegmentedStack&&) = delete;
+    SegmentedStack& operator=(const SegmentedStack&) = delete;
+    SegmentedStack& operator=(SegmentedStack&&) = delete;
+
+    ~SegmentedStack() {
+        while (current) {
+            Segment* prev = current->prev;
+            Free(current);
+            current = prev;
+        }
+        if (spare) {
+            Free(spare);
+        }
+    }
+
+    NLANG_FORCE_INLINE void Push(const T& value) {
+        if (NLANG_UNLIKELY(top == limit)) {
+            PushSegment();
+        }
+        *top++ = value;
+    }
+
+    NLANG_FORCE_INLINE T Pop() {
+        NLANG_ASSERT(!empty());
+        T value = *--top;
+        if (NLANG_UNLIKELY(top == current->Values() && current->prev)) {
+            PopSegment();
+        }
+        return value;
+    }
+
+    NLANG_FORCE_INLINE bool empty() const {
+        // only the first segment may be empty
+        return top == bottom;
+    }
+
+    /**
+     * @return Count of the values, it is computed over the segments
+     */
+    size_t size() const {
+        if (!current) {
+            return 0;
+        }
+        size_t count = top - current->Values();
+        for (Segment* segment = current->prev; segment; segment = segment->prev) {
+            count += Segment::Capacity();
+        }
+        return count;
+    }
+
+private:
+    struct Segment {
+        Segment* prev;
+
+        NLANG_FORCE_INLINE T* Values() {
+            return static_cast<T*>(static_cast<void*>(this + 1));
+        }
+
+        NLANG_FORCE_INLINE static size_t Capacity() {
+            return (Page::size() - sizeof(Segment)) / sizeof(T);
+        }
+    };
+
+    static void Free(Segment* segment) {
+        Page::Free(static_cast<Page*>(static_cast<void*>(segment)));
+    }
+
+    void PushSegment() {
+        Segment* segment = spare;
+        spare = nullptr;
+        if (!segment) {
+            static_assert(alignof(T) <= alignof(Segment), "values must fit the alignment of the page");
+            segment = new (Page::Allocate()->data()) Segment;
+        }
+        segment->prev = current;
+        if (!current) {
+            bottom = segment->Values();
+        }
+        current = segment;
+        top = segment->Values();
+        limit = top + Segment::Capacity();
+    }
+
+    void PopSegment() {
+        if (spare) {
+            Free(spare);
+        }
+        spare = current;
+        current = current->prev;
+        limit = current->Values() + Segment::Capacity();
+        top = limit;
+    }
+
+    Segment* current = nullptr;
+    Segment* spare = nullptr;
+    T* top = nullptr;
+    T* limit = nullptr;
+    /** Beginning of the first segment */
+    T* bottom = nullptr;
+};
+
+}
\ No newline at end of file
@@ -5,12 +5,15 @@
 #include <utils/alloc/page.hpp>
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 
 namespace nlang {
 
 /**
  * A typed slot page.
- *
+ * Slots may have inline storage right after them, so a value can be constructed in its slot and lie in the same cache
+ * line as the pointer to it. All slots of the page have the same stride.
  * @tparam T
  */
 template<typename T>
@@ -36,6 +39,28 @@ public:
             return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(data) & ~(uintptr_t)0b11u);
         }
 
+        /**
+         * Replaces the value of the slot (e.g. when it is moved), the mark is kept
+         * @param value The value
+         */
+        NLANG_FORCE_INLINE void Set(T* value) {
+            data = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(value) | static_cast<uintptr_t>(GetMark()));
+        }
+
+        /**
+         * @return Memory right after the slot, where the value can be constructed, if the page has inline storage
+         */
+        NLANG_FORCE_INLINE void* GetInlineStorage() const {
+            return const_cast<Slot*>(this) + 1;
+        }
+
+        /**
+         * @return Whether the value is constructed in the inline storage of the slot
+         */
+        NLANG_FORCE_INLINE bool IsInline() const {
+            return static_cast<void*>(Get()) == GetInlineStorage();
+        }
+
         NLANG_FORCE_INLINE Mark GetMark() const {
             return static_cast<Mark>(reinterpret_cast<uintptr_t>(data) & (uintptr_t)0b11u);
         }
@@ -74,9 +99,15 @@ public:
         void* data;
     };
 
-    static SlotPage* New() {
+    /**
+     * Creates the page
+     * @param stride Size of the slot with its inline storage, multiple of the size of the slot
+     * @return The page
+     */
+    static SlotPage* New(size_t stride = sizeof(Slot)) {
+        NLANG_ASSERT(stride >= sizeof(Slot) && stride % alignof(Slot) == 0);
         Page* page = Page::Allocate();
-        SlotPage* slot_page = new (page) SlotPage;
+        SlotPage* slot_page = new (page) SlotPage(stride);
         return slot_page;
     }
 
@@ -86,6 +117,15 @@ public:
         Page::Free(page);
     }
 
+    /**
+     * Returns the page of the slot, pages are aligned by their size, so it is found by the address
+     * @param slot The slot
+     * @return The page
+     */
+    NLANG_FORCE_INLINE static SlotPage* FromSlot(const Slot* slot) {
+        return reinterpret_cast<SlotPage*>(reinterpret_cast<uintptr_t>(slot) & ~static_cast<uintptr_t>(Page::size() - 1));
+    }
+
     NLANG_FORCE_INLINE Slot* Store(T* value) {
         NLANG_ASSERT(!full());
         FreeSlot* slot = &free_slots.front();
@@ -105,7 +145,7 @@ public:
     void ForEachSlot(F&& handler) {
         free_slots.sort([](const FreeSlot& a, const FreeSlot& b) { return &a < &b; });
         auto free_slot_it = free_slots.cbegin();
-        for (auto slot = begin(); slot != end(); ++slot) {
+        for (auto slot = begin(); slot != end(); slot = Next(slot)) {
             while (free_slot_it != free_slots.cend() && static_cast<const void*>(&*free_slot_it) < static_cast<const void*>(slot)) {
                 ++free_slot_it;
             }
@@ -117,7 +157,7 @@ public:
     }
 
     NLANG_FORCE_INLINE size_t capacity() const {
-        return end() - begin();
+        return (Page::size() - sizeof(SlotPage)) / stride;
     }
 
     NLANG_FORCE_INLINE size_t size() const {
@@ -133,9 +173,12 @@ public:
     }
 
 private:
-    SlotPage() : size_(0) {
-        for (auto& slot : *this) {
-            free_slots.push_front(*new (&slot) FreeSlot);
+    explicit SlotPage(size_t stride)
+        : size_(0)
+        , stride(stride)
+    {
+        for (auto slot = begin(); slot != end(); slot = Next(slot)) {
+            free_slots.push_front(*new (slot) FreeSlot);
         }
     }
 
@@ -146,13 +189,17 @@ private:
     }
 
     NLANG_FORCE_INLINE Slot* end() const {
-        NLANG_ASSERT((Page::size() - sizeof(SlotPage)) % sizeof(Slot) == 0);
-        return begin() + (Page::size() - sizeof(SlotPage)) / sizeof(Slot);
+        return reinterpret_cast<Slot*>(reinterpret_cast<uint8_t*>(begin()) + capacity() * stride);
+    }
+
+    NLANG_FORCE_INLINE Slot* Next(Slot* slot) const {
+        return reinterpret_cast<Slot*>(reinterpret_cast<uint8_t*>(slot) + stride);
     }
 
 private:
     IntrusiveForwardList<FreeSlot> free_slots;
     size_t size_;
+    const size_t stride;
 };
 
 /**
@@ -165,9 +212,14 @@ class SlotStorage {
 public:
     using Slot = typename SlotPage<T>::Slot;
 
-    SlotStorage()
+    /**
+     * Creates the storage
+     * @param inline_size Size of the inline storage of each slot, 0 if the values are stored elsewhere
+     */
+    explicit SlotStorage(size_t inline_size = 0)
         : size_(0)
         , capacity_(0)
+        , stride(sizeof(Slot) + (inline_size + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot))
     {
 
     }
@@ -177,8 +229,11 @@ public:
     }
 
     Slot* Store(T* value) {
+        if (pages.empty() && released_from_full_pages) {
+            ReclaimFullPages();
+        }
         if (pages.empty()) {
-            pages.push_front(*SlotPage<T>::New());
+            pages.push_front(*SlotPage<T>::New(stride));
             capacity_ += pages.front().capacity();
         }
         SlotPage<T>& page = pages.front();
@@ -191,7 +246,12 @@ public:
         return slot;
     }
 
+    /**
+     * Moves the values from the least filled pages to the other ones.
+     * Values in the inline storage of the slots are not moved, so the storage must have no inline storage.
+     */
     void Defragment() {
+        NLANG_ASSERT(inline_size() == 0);
         // sort descending by size, optional
         pages.sort([](const SlotPage<T>& a, const SlotPage<T>& b) {
             return b.size() < a.size();
@@ -226,6 +286,18 @@ public:
         }
     }
 
+    /**
+     * Releases the slot, value of the slot is not destroyed
+     * If the page of the slot was full, it is moved back to the pages with free slots lazily, when they run out.
+     * @param slot The slot
+     */
+    void Release(Slot* slot) {
+        SlotPage<T>* page = SlotPage<T>::FromSlot(slot);
+        released_from_full_pages |= page->full();
+        page->Release(slot);
+        --size_;
+    }
+
     void FreeEmptyPages() {
         FreePages(true);
     }
@@ -262,7 +334,29 @@ public:
         return capacity_;
     }
 
+    /**
+     * @return Size of the inline storage of each slot
+     */
+    NLANG_FORCE_INLINE size_t inline_size() const {
+        return stride - sizeof(Slot);
+    }
+
 private:
+    void ReclaimFullPages() {
+        auto prev = full_pages.before_begin();
+        auto current = full_pages.begin();
+        while (current != full_pages.end()) {
+            if (!current->full()) {
+                ++current;
+                pages.splice_after(pages.cbefore_begin(), full_pages, prev, current);
+            } else {
+                ++prev;
+                ++current;
+            }
+        }
+        released_from_full_pages = false;
+    }
+
     void FreePages(bool empty_only) {
         SlotPage<T>* page = nullptr;
         pages.remove_if([&](const SlotPage<T>& p) {
@@ -287,6 +381,9 @@ private:
     IntrusiveForwardList<SlotPage<T>> full_pages;
     size_t size_;
     size_t capacity_;
+    const size_t stride;
+    /** Whether slots of the full pages were released, so they may be not full anymore */
+    bool released_from_full_pages = false;
 };
 
 }
\ No newline at end of file
@@ -32,11 +32,13 @@ do {} while (0)
 
 #if defined(__clang__)
 #define NLANG_COMPILER_CLANG
+#define NLANG_HAS_COMPUTED_GOTO
 #define NLANG_FORCE_INLINE inline __attribute__((always_inline))
 #define NLANG_LIKELY(x)      __builtin_expect(!!(x), 1)
 #define NLANG_UNLIKELY(x)    __builtin_expect(!!(x), 0)
 #elif defined(__GNUC__)
 #define NLANG_COMPILER_GCC
+#define NLANG_HAS_COMPUTED_GOTO
 #define NLANG_FORCE_INLINE inline __attribute__((always_inline))
 #define NLANG_LIKELY(x)      __builtin_expect(!!(x), 1)
 #define NLANG_UNLIKELY(x)    __builtin_expect(!!(x), 0)
@@ -3,6 +3,7 @@
 #include <unicode/unistr.h>
 
 #include <string>
+#include <string_view>
 #include <iostream>
 
 namespace nlang {
@@ -25,6 +26,10 @@ public:
         : icu::UnicodeString(icu::UnicodeString::fromUTF8(text))
     {}
 
+    explicit UString(std::u16string_view text)
+        : icu::UnicodeString(text.data(), static_cast<int32_t>(text.length()))
+    {}
+
     UString(const UString& s, int32_t start)
         : icu::UnicodeString(s, start)
     {}
@@ -50,6 +55,16 @@ public:
 
     virtual ~UString() = default;
 
+    /**
+     * Creates read-only string, that aliases the buffer without copying it.
+     * The buffer must outlive the string, copies of the string own their buffers.
+     * @param text Buffer to alias
+     * @return Aliasing string
+     */
+    static UString Alias(std::u16string_view text) {
+        return UString(icu::UnicodeString(false, text.data(), static_cast<int32_t>(text.length())));
+    }
+
 
     int32_t GetLength() const {
         return getLength();
@@ -193,7 +208,7 @@ public:
     }
 
     UString operator+(const UString& other) const {
-        return UString(std::move((icu::UnicodeString(getLength() + other.getLength()) += *this) += other));
+        return UString(std::move((icu::UnicodeString(getLength() + other.getLength(), 0, 0) += *this) += other));
     }
 
 private:
@@ -1,3 +1,4 @@
 #pragma once
 
-#include <utils/threading/thread_pool.hpp>
\ No newline at end of file
+#include <utils/threading/thread_pool.hpp>
+#include <utils/threading/work_stealing_deque.hpp>
\ No newline at end of file
@@ -1,54 +1,369 @@
 #pragma once
 
-#include <thread>
-#include <vector>
-#include <mutex>
+#include <utils/macro.hpp>
+#include <utils/pointers/unique_ptr.hpp>
+#include <utils/threading/work_stealing_deque.hpp>
+
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
-#include <queue>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace nlang {
 
+class TaskGroup;
+
 /**
- * Thread pool.
- * Execute tasks (functions) using workers, returning std::future
+ * Work-stealing thread pool.
+ * Every worker owns a Chase-Lev deque: tasks, spawned by a worker, are pushed to and popped from its own deque without
+ * locks, idle workers steal tasks from the other deques. Tasks, submitted from outside of the pool, go to a shared
+ * queue. Tasks are stored in place (no std::function), so fine-grained parallelism via Join, ParallelFor and TaskGroup
+ * doesn't allocate memory for each task.
  */
 class ThreadPool {
 public:
-    ThreadPool(size_t threads = 0);
+    /**
+     * Creates pool
+     * @param threads Amount of workers, 0 means amount of hardware threads
+     */
+    explicit ThreadPool(size_t threads = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    /**
+     * Finishes all the submitted tasks and stops workers
+     */
+    ~ThreadPool();
 
+    /**
+     * Executes function in the pool
+     * @param f Function
+     * @param args Arguments of the function
+     * @return Future with the result of the function
+     */
     template<typename F, class ...Args>
-    std::future<std::result_of_t<F(Args...)>> Enqueue(F&& f, Args&&... args) {
-        auto task = std::make_shared<std::packaged_task<std::result_of_t<F(Args...)>()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-        auto future = task->get_future();
+    std::future<std::invoke_result_t<F, Args...>> Enqueue(F&& f, Args&&... args) {
+        using R = std::invoke_result_t<F, Args...>;
+
+        std::packaged_task<R()> function(
+            [f = std::forward<F>(f), args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                return std::apply(std::move(f), std::move(args));
+            });
+        auto future = function.get_future();
+
+        auto task = MakeUnique<Task>(std::move(function), nullptr);
+        Submit(task.get());
+        task.release();
+        return future;
+    }
+
+    /**
+     * Runs two functions in parallel and waits for both of them.
+     * If any function throws, the exception is rethrown after both are finished.
+     * @param a Function, which is run by the calling thread
+     * @param b Function, which may be stolen by other workers
+     */
+    template<typename A, typename B>
+    void Join(A&& a, B&& b) {
+        Counter counter;
+        counter.Add();
+        Task task([&b]() { std::forward<B>(b)(); }, &counter);
+        Submit(&task);
+        try {
+            std::forward<A>(a)();
+        } catch (...) {
+            Wait(counter);
+            throw;
+        }
+        Wait(counter);
+        counter.Rethrow();
+    }
+
+    /**
+     * Calls body for every index in [begin, end) in parallel.
+     * Range is split in halves recursively until it is not greater than grain, so idle workers steal big parts of it.
+     * @param begin First index
+     * @param end Index after the last one
+     * @param grain Maximal amount of indices, processed by one task
+     * @param body Function, that accepts index
+     */
+    template<typename F>
+    void ParallelFor(size_t begin, size_t end, size_t grain, F&& body) {
+        if (begin < end) {
+            ParallelForImpl(begin, end, std::max<size_t>(grain, 1), body);
+        }
+    }
+
+    /**
+     * Returns amount of workers
+     * @return Amount of workers
+     */
+    size_t GetThreadsCount() const {
+        return workers.size();
+    }
+
+private:
+    friend class TaskGroup;
+
+    /**
+     * Counter of unfinished tasks, which can be waited for.
+     * Keeps the first exception, thrown by the tasks.
+     */
+    class Counter final {
+    public:
+        void Add(size_t count = 1) {
+            state.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        void Done() {
+            // the waiter can destroy the counter as soon as it sees zero, so the sleeping waiter is woken under lock
+            if (state.fetch_sub(1, std::memory_order_acq_rel) == (SLEEPING | 1)) {
+                std::lock_guard guard(mutex);
+                notified = true;
+                condition.notify_all();
+            }
+        }
+
+        bool IsDone() const {
+            return (state.load(std::memory_order_acquire) & ~SLEEPING) == 0;
+        }
+
+        void Fail(std::exception_ptr exception) {
+            if (!failed.exchange(true, std::memory_order_relaxed)) {
+                error = std::move(exception);
+            }
+        }
+
+        void Rethrow() {
+            if (failed.load(std::memory_order_relaxed)) {
+                failed.store(false, std::memory_order_relaxed);
+                std::rethrow_exception(std::exchange(error, nullptr));
+            }
+        }
+
+        /**
+         * Blocks until all the tasks are done
+         */
+        void Sleep();
+
+    private:
+        static constexpr size_t SLEEPING = size_t(1) << (sizeof(size_t) * 8 - 1);
 
+        std::atomic<size_t> state { 0 };
+        std::atomic<bool> failed { false };
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool notified = false;
+    };
+
+    /**
+     * Type-erased task with inline storage for small functions.
+     * Task with counter is owned by the one, who waits for the counter. Task without counter is allocated on heap
+     * and is deleted after execution.
+     */
+    class alignas(64) Task final {
+    public:
+        /**
+         * Size of the function, which is stored in place
+         */
+        static constexpr size_t INLINE_SIZE = 64 - 2 * sizeof(void*);
+
+        template<typename F>
+        Task(F&& f, Counter* counter)
+            : counter(counter)
         {
-            std::lock_guard guard(mutex);
-            if (shutdown) {
-                throw std::runtime_error("can't enqueue on stopped pool");
+            using Function = std::decay_t<F>;
+            if constexpr (sizeof(Function) <= INLINE_SIZE && alignof(Function) <= alignof(std::max_align_t)) {
+                new (storage) Function(std::forward<F>(f));
+                invoke = &InvokeInline<Function>;
+            } else {
+                new (storage) Function*(new Function(std::forward<F>(f)));
+                invoke = &InvokeHeap<Function>;
             }
+        }
+
+        Task(const Task&) = delete;
+        Task(Task&&) = delete;
+        Task& operator=(const Task&) = delete;
+        Task& operator=(Task&&) = delete;
+
+        /**
+         * Calls the function and destroys it
+         */
+        void Run() {
+            invoke(*this);
+        }
 
-            tasks.emplace([task]() { (*task)(); });
+        Counter* GetCounter() const {
+            return counter;
         }
 
-        condition.notify_one();
+    private:
+        template<typename Function>
+        static void InvokeInline(Task& task) {
+            Function& function = *std::launder(reinterpret_cast<Function*>(task.storage));
+            struct Guard {
+                Function& function;
+                ~Guard() {
+                    function.~Function();
+                }
+            } guard { function };
+            function();
+        }
 
-        return future;
+        template<typename Function>
+        static void InvokeHeap(Task& task) {
+            UniquePtr<Function> function(*std::launder(reinterpret_cast<Function**>(task.storage)));
+            (*function)();
+        }
+
+    private:
+        void (*invoke)(Task&);
+        Counter* counter;
+        alignas(std::max_align_t) std::byte storage[INLINE_SIZE];
+    };
+
+    static_assert(sizeof(Task) == 64);
+
+    template<typename F>
+    void ParallelForImpl(size_t begin, size_t end, size_t grain, F& body) {
+        if (end - begin > grain) {
+            const size_t middle = begin + (end - begin) / 2;
+            Join([&]() { ParallelForImpl(begin, middle, grain, body); },
+                 [&]() { ParallelForImpl(middle, end, grain, body); });
+            return;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            body(i);
+        }
     }
 
-    ~ThreadPool();
+    /**
+     * Pushes task to the deque of the current worker or to the shared queue
+     */
+    void Submit(Task* task);
+
+    /**
+     * Waits for the counter. Worker executes other tasks while waiting.
+     */
+    void Wait(Counter& counter);
+
+    /**
+     * Executes task and notifies its counter
+     */
+    static void Execute(Task* task);
+
+    /**
+     * Finds task for the worker: pops own deque, then the shared queue, then steals from other workers
+     * @param index Index of the worker or NOT_WORKER
+     */
+    Task* FindWork(size_t index);
+
+    /**
+     * Wakes one sleeping worker, if any
+     */
+    void Wake();
+
+    void WorkerLoop(size_t index);
+
+    /**
+     * Returns index of the current thread in the pool or NOT_WORKER
+     */
+    size_t GetWorkerIndex() const;
 
 private:
+    static constexpr size_t NOT_WORKER = static_cast<size_t>(-1);
+    static constexpr int SPIN_COUNT = 64;
+
     std::vector<std::thread> workers;
-    std::mutex mutex;
-    std::condition_variable condition;
+    std::vector<UniquePtr<WorkStealingDeque<Task*>>> deques;
+
+    std::mutex queue_mutex;
+    std::deque<Task*> queue;
+    std::atomic<size_t> queue_size { 0 };
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_condition;
+    std::atomic<size_t> sleeping { 0 };
+    std::atomic<uint64_t> epoch { 0 };
+
+    std::atomic<bool> shutdown { false };
+};
+
+/**
+ * Group of tasks, which can be waited for together.
+ * Tasks are placed in blocks, owned by the group and reused after Wait, so running a task doesn't allocate memory.
+ * Tasks may be added only by the thread, that owns the group.
+ */
+class TaskGroup final {
+public:
+    explicit TaskGroup(ThreadPool& pool)
+        : pool(pool)
+    {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup(TaskGroup&&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    TaskGroup& operator=(TaskGroup&&) = delete;
+
+    /**
+     * Waits for the tasks, exceptions of the tasks are ignored
+     */
+    ~TaskGroup() {
+        pool.Wait(counter);
+    }
+
+    /**
+     * Runs function in the pool
+     * @param f Function
+     */
+    template<typename F>
+    void Run(F&& f) {
+        if (used == blocks.size() * BLOCK_SIZE) {
+            blocks.emplace_back(new Slot[BLOCK_SIZE]);
+        }
+        void* slot = &blocks[used / BLOCK_SIZE][used % BLOCK_SIZE];
+        ++used;
+        counter.Add();
+        pool.Submit(new (slot) ThreadPool::Task(std::forward<F>(f), &counter));
+    }
+
+    /**
+     * Waits for all the tasks of the group. Rethrows the first exception, thrown by the tasks.
+     */
+    void Wait() {
+        pool.Wait(counter);
+        used = 0;
+        counter.Rethrow();
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64;
 
-    std::queue<std::function<void()>> tasks;
+    using Slot = std::aligned_storage_t<sizeof(ThreadPool::Task), alignof(ThreadPool::Task)>;
 
-    bool shutdown;
+    ThreadPool& pool;
+    ThreadPool::Counter counter;
+    std::vector<UniquePtr<Slot[]>> blocks;
+    size_t used = 0;
 };
 
 }
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <utils/macro.hpp>
+#include <utils/pointers/unique_ptr.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace nlang {
+
+/**
+ * Chase-Lev work-stealing deque.
+ * The owner thread pushes and pops elements at the bottom without locks, other threads steal elements from the top.
+ * Elements are stored in atomics, so they must be trivially copyable (usually pointers to tasks).
+ * Memory orderings follow "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al., 2013).
+ * @tparam T Element type
+ */
+template<typename T>
+class WorkStealingDeque final {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    /**
+     * Default capacity of the deque, grows when exceeded
+     */
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+
+    explicit WorkStealingDeque(size_t capacity = DEFAULT_CAPACITY) {
+        NLANG_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+        arrays.emplace_back(new Array(capacity));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque(WorkStealingDeque&&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+    /**
+     * Pushes element to the bottom. Must be called only by the owner thread.
+     * @param element Element to push
+     */
+    void Push(T element) {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        Array* a = array.load(std::memory_order_relaxed);
+        if (NLANG_UNLIKELY(b - t > static_cast<int64_t>(a->capacity) - 1)) {
+            a = Grow(a, b, t);
+        }
+        a->Put(b, element);
+        // release store instead of release fence, so thieves' acquire of bottom makes the element visible
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    /**
+     * Pops element from the bottom. Must be called only by the owner thread.
+     * @param element Popped element
+     * @return True if element was popped, false if deque is empty
+     */
+    bool Pop(T& element) {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = array.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        element = a->Get(b);
+        if (t == b) {
+            // last element, race with thieves
+            const bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * Steals element from the top. May be called by any thread.
+     * @param element Stolen element
+     * @return True if element was stolen, false if deque is empty
+     */
+    bool Steal(T& element) {
+        while (true) {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b) {
+                return false;
+            }
+            element = array.load(std::memory_order_acquire)->Get(t);
+            if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return true;
+            }
+            // element was taken by another thread, try the next one
+        }
+    }
+
+    /**
+     * Returns approximate amount of elements
+     * @return Amount of elements
+     */
+    size_t Size() const {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    struct Array {
+        explicit Array(size_t capacity)
+            : capacity(capacity)
+            , mask(capacity - 1)
+            , buffer(new std::atomic<T>[capacity])
+        {}
+
+        T Get(int64_t index) const {
+            return buffer[index & mask].load(std::memory_order_relaxed);
+        }
+
+        void Put(int64_t index, T element) {
+            buffer[index & mask].store(element, std::memory_order_relaxed);
+        }
+
+        const size_t capacity;
+        const size_t mask;
+        UniquePtr<std::atomic<T>[]> buffer;
+    };
+
+    Array* Grow(Array* old, int64_t b, int64_t t) {
+        // thieves may still read the old array, so it is kept alive until the deque is destroyed
+        arrays.emplace_back(new Array(old->capacity * 2));
+        Array* a = arrays.back().get();
+        for (int64_t i = t; i < b; ++i) {
+            a->Put(i, old->Get(i));
+        }
+        array.store(a, std::memory_order_release);
+        return a;
+    }
+
+private:
+    alignas(64) std::atomic<int64_t> top { 0 };
+    alignas(64) std::atomic<int64_t> bottom { 0 };
+    alignas(64) std::atomic<Array*> array { nullptr };
+    std::vector<UniquePtr<Array>> arrays;
+};
+
+}
\ No newline at end of file
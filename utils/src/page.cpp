@@ -17,16 +17,20 @@
 
 namespace nlang {
 
-inline std::pair<Page::PageIterator, Page::PageIterator> Page::AllocateRange(size_t pages_count)  {
+std::pair<Page::PageIterator, Page::PageIterator> Page::AllocateRange(size_t pages_count, bool commit)  {
     void* raw_data = nullptr;
     size_t final_size = size() * pages_count;
 #if defined(NLANG_PLATFORM_LINUX) || defined(NLANG_PLATFORM_MACOS)
-    raw_data = mmap(nullptr, final_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    raw_data = commit
+            ? mmap(nullptr, final_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)
+            : mmap(nullptr, final_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
     if (raw_data == MAP_FAILED) {
         throw std::bad_alloc();
     }
 #elif defined(NLANG_PLATFORM_WINDOWS)
-    raw_data = VirtualAlloc(nullptr, final_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    raw_data = commit
+            ? VirtualAlloc(nullptr, final_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE)
+            : VirtualAlloc(nullptr, final_size, MEM_RESERVE, PAGE_NOACCESS);
     if (!raw_data) {
         throw std::bad_alloc();
     }
@@ -39,7 +43,23 @@ inline std::pair<Page::PageIterator, Page::PageIterator> Page::AllocateRange(siz
     return std::pair(PageIterator(raw_data), PageIterator(raw_data) + pages_count);
 }
 
-inline void Page::FreeRange(const std::pair<PageIterator, PageIterator>& range) {
+void Page::CommitRange(const std::pair<PageIterator, PageIterator>& range) {
+    void* raw_data = const_cast<Page*>(&*range.first);
+    size_t final_size = size() * (range.second - range.first);
+#if defined(NLANG_PLATFORM_LINUX) || defined(NLANG_PLATFORM_MACOS)
+    if (mprotect(raw_data, final_size, PROT_READ | PROT_WRITE)) {
+        throw std::bad_alloc();
+    }
+#elif defined(NLANG_PLATFORM_WINDOWS)
+    if (!VirtualAlloc(raw_data, final_size, MEM_COMMIT, PAGE_READWRITE)) {
+        throw std::bad_alloc();
+    }
+#else
+    // the memory is always accessible
+#endif
+}
+
+void Page::FreeRange(const std::pair<PageIterator, PageIterator>& range) {
     void* raw_data = const_cast<Page*>(&*range.first);
     size_t final_size = size() * (range.second - range.first);
     if (!raw_data) {
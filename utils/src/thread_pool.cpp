@@ -2,37 +2,202 @@
 
 namespace nlang {
 
-ThreadPool::ThreadPool(size_t threads)
-    : shutdown(false)
-{
-    workers.resize(threads);
-    for (auto& worker : workers) {
-        worker = std::thread([this]() {
-            while (true) {
-                std::unique_lock lock(mutex);
-                condition.wait(lock, [this]() { return shutdown || !tasks.empty(); });
-                if (shutdown && tasks.empty()) {
-                    break;
-                }
-                std::function<void()> task(std::move(tasks.front()));
-                tasks.pop();
-                lock.unlock();
-                task();
-            }
+namespace {
+
+struct WorkerInfo {
+    const ThreadPool* pool = nullptr;
+    size_t index = 0;
+    uint32_t random = 0;
+};
+
+thread_local WorkerInfo current_worker;
+
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    deques.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        deques.emplace_back(new WorkStealingDeque<Task*>());
+    }
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i]() {
+            WorkerLoop(i);
         });
     }
 }
 
 ThreadPool::~ThreadPool() {
     {
-        std::lock_guard guard(mutex);
-        shutdown = true;
+        std::lock_guard guard(sleep_mutex);
+        shutdown.store(true, std::memory_order_seq_cst);
     }
 
-    condition.notify_all();
+    sleep_condition.notify_all();
     for (auto& t : workers) {
         t.join();
     }
 }
 
+void ThreadPool::Counter::Sleep() {
+    std::unique_lock lock(mutex);
+    size_t value = state.load(std::memory_order_acquire);
+    while (value != 0 && !state.compare_exchange_weak(value, value | SLEEPING, std::memory_order_acq_rel,
+                                                      std::memory_order_acquire)) {
+        // retry
+    }
+    if (value == 0) {
+        return;
+    }
+    condition.wait(lock, [this]() { return notified; });
+    notified = false;
+    state.store(0, std::memory_order_relaxed);
+}
+
+void ThreadPool::Submit(Task* task) {
+    const size_t index = GetWorkerIndex();
+    if (index != NOT_WORKER) {
+        deques[index]->Push(task);
+    } else {
+        std::lock_guard guard(queue_mutex);
+        if (shutdown.load(std::memory_order_relaxed)) {
+            throw std::runtime_error("can't enqueue on stopped pool");
+        }
+        queue.push_back(task);
+        queue_size.fetch_add(1, std::memory_order_relaxed);
+    }
+    Wake();
+}
+
+void ThreadPool::Wait(Counter& counter) {
+    const size_t index = GetWorkerIndex();
+    if (index != NOT_WORKER) {
+        // worker executes other tasks while waiting, its own deque is popped first, so the awaited tasks are
+        // usually executed by the waiter itself, unless they were stolen
+        int spins = 0;
+        while (!counter.IsDone()) {
+            if (Task* task = FindWork(index)) {
+                Execute(task);
+                spins = 0;
+            } else if (++spins < SPIN_COUNT) {
+                std::this_thread::yield();
+            } else {
+                counter.Sleep();
+            }
+        }
+    } else {
+        for (int spins = 0; !counter.IsDone(); ++spins) {
+            if (spins < SPIN_COUNT) {
+                std::this_thread::yield();
+            } else {
+                counter.Sleep();
+            }
+        }
+    }
+}
+
+void ThreadPool::Execute(Task* task) {
+    Counter* counter = task->GetCounter();
+    if (!counter) {
+        UniquePtr<Task> owned(task);
+        owned->Run();
+        return;
+    }
+    try {
+        task->Run();
+    } catch (...) {
+        counter->Fail(std::current_exception());
+    }
+    counter->Done();
+}
+
+ThreadPool::Task* ThreadPool::FindWork(size_t index) {
+    Task* task = nullptr;
+    if (index != NOT_WORKER && deques[index]->Pop(task)) {
+        return task;
+    }
+
+    if (queue_size.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard guard(queue_mutex);
+        if (!queue.empty()) {
+            task = queue.front();
+            queue.pop_front();
+            queue_size.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    // start from random victim, so thieves don't contend on the same deque
+    auto& random = current_worker.random;
+    random = random * 1664525u + 1013904223u;
+    const size_t count = deques.size();
+    const size_t start = (random >> 16) % count;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t victim = (start + i) % count;
+        if (victim != index && deques[victim]->Steal(task)) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void ThreadPool::Wake() {
+    // pairs with the increment of sleeping counter in WorkerLoop: either the pushed task is seen by the worker,
+    // that is going to sleep, or the worker is seen here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    epoch.fetch_add(1, std::memory_order_seq_cst);
+    std::lock_guard guard(sleep_mutex);
+    sleep_condition.notify_one();
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    current_worker.pool = this;
+    current_worker.index = index;
+    current_worker.random = static_cast<uint32_t>(index) * 2654435761u + 1;
+
+    int spins = 0;
+    while (true) {
+        if (Task* task = FindWork(index)) {
+            Execute(task);
+            spins = 0;
+            continue;
+        }
+        if (++spins < SPIN_COUNT) {
+            std::this_thread::yield();
+            continue;
+        }
+        spins = 0;
+
+        const uint64_t current_epoch = epoch.load(std::memory_order_seq_cst);
+        sleeping.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (Task* task = FindWork(index)) {
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+            Execute(task);
+            continue;
+        }
+        if (shutdown.load(std::memory_order_seq_cst)) {
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+            break;
+        }
+        {
+            std::unique_lock lock(sleep_mutex);
+            sleep_condition.wait(lock, [this, current_epoch]() {
+                return epoch.load(std::memory_order_seq_cst) != current_epoch || shutdown.load(std::memory_order_seq_cst);
+            });
+        }
+        sleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+size_t ThreadPool::GetWorkerIndex() const {
+    return current_worker.pool == this ? current_worker.index : NOT_WORKER;
+}
+
 }
@@ -3,8 +3,19 @@
 #include <utils/containers/nan_boxed_primitive.hpp>
 #include <utils/traits.hpp>
 
+#include <cmath>
+#include <limits>
 #include <type_traits>
 
+namespace {
+
+bool almost_equal(double x, double y, int ulp) {
+    return std::abs(x - y) <= std::numeric_limits<double>::epsilon() * std::abs(x + y) * ulp ||
+           std::abs(x - y) < std::numeric_limits<double>::min();
+}
+
+}
+
 TEST_CASE("nan-boxing & fake nan-boxing test") {
     using namespace nlang;
 
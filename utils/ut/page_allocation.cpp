@@ -13,5 +13,20 @@ TEST_CASE("page allocation, usage and deallocation") {
         data = it->data();
     }
 
+    Page::FreeRange(page_range);
+}
+TEST_CASE("reserved pages commit") {
+    using namespace nlang;
+
+    auto page_range = Page::AllocateRange(4, false);
+    REQUIRE(page_range.second - page_range.first == 4);
+
+    Page::CommitRange({ page_range.first, page_range.first + 2 });
+    for (auto it = page_range.first; it != page_range.first + 2; ++it) {
+        static_cast<uint8_t*>(it->data())[0] = 1;
+        static_cast<uint8_t*>(it->data())[Page::size() - 1] = 2;
+    }
+    REQUIRE(static_cast<uint8_t*>((page_range.first + 1)->data())[0] == 1);
+
     Page::FreeRange(page_range);
 }
\ No newline at end of file
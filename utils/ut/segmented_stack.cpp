@@ -0,0 +1,41 @@
+#include <catch2/catch.hpp>
+
+#include <utils/containers/segmented_stack.hpp>
+
+#include <cstdint>
+
+TEST_CASE("segmented stack tests") {
+    using namespace nlang;
+
+    SegmentedStack<uint64_t> stack;
+    REQUIRE(stack.empty());
+    REQUIRE(stack.size() == 0);
+
+    // several segments
+    const uint64_t count = Page::size() * 3 + 5;
+
+    for (uint64_t i = 0; i < count; ++i) {
+        stack.Push(i);
+    }
+    REQUIRE(!stack.empty());
+    REQUIRE(stack.size() == count);
+
+    // back and forth across the borders of segments
+    for (uint64_t i = count; i > count / 2; --i) {
+        REQUIRE(stack.Pop() == i - 1);
+    }
+    for (uint64_t i = count / 2; i < count; ++i) {
+        stack.Push(i);
+    }
+    REQUIRE(stack.size() == count);
+
+    for (uint64_t i = count; i > 0; --i) {
+        REQUIRE(stack.Pop() == i - 1);
+    }
+    REQUIRE(stack.empty());
+    REQUIRE(stack.size() == 0);
+
+    stack.Push(42);
+    REQUIRE(stack.Pop() == 42);
+    REQUIRE(stack.empty());
+}
\ No newline at end of file
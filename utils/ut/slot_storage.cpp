@@ -2,6 +2,8 @@
 
 #include <utils/containers/slot_storage.hpp>
 
+#include <cstdint>
+#include <new>
 #include <vector>
 
 TEST_CASE("slot storage tests") {
@@ -82,4 +84,67 @@ TEST_CASE("slot storage tests") {
         REQUIRE(slot->GetMark() == SlotStorage<int>::Slot::Mark::BLACK);
         REQUIRE(*slot->Get() % 2 == 0);
     });
+}
+TEST_CASE("slot storage release of slots") {
+    using namespace nlang;
+
+    SlotStorage<int> storage;
+
+    std::vector<int> ints(100000);
+    std::vector<SlotStorage<int>::Slot*> slots;
+    for (auto& i : ints) {
+        slots.push_back(storage.Store(&i));
+    }
+    const size_t capacity = storage.capacity();
+
+    for (size_t i = 0; i < slots.size(); i += 2) {
+        storage.Release(slots[i]);
+    }
+    REQUIRE(storage.size() == ints.size() / 2);
+
+    // released slots of the full pages are reused
+    for (size_t i = 0; i < slots.size(); i += 2) {
+        slots[i] = storage.Store(&ints[i]);
+        slots[i]->Set(&ints[i + 1]);
+    }
+    REQUIRE(storage.size() == ints.size());
+    REQUIRE(storage.capacity() == capacity);
+    // replaced values of the reused slots are the odd ones
+    for (size_t i = 0; i < slots.size(); ++i) {
+        REQUIRE(slots[i]->Get() == &ints[i % 2 == 0 ? i + 1 : i]);
+    }
+}
+TEST_CASE("slot storage with inline storage") {
+    using namespace nlang;
+
+    struct Value {
+        uint64_t a;
+        uint64_t b;
+        uint64_t c;
+    };
+
+    SlotStorage<Value> storage(sizeof(Value));
+    REQUIRE(storage.inline_size() >= sizeof(Value));
+
+    std::vector<SlotStorage<Value>::Slot*> slots;
+    for (uint64_t i = 0; i < 10000; ++i) {
+        auto* slot = storage.Store(nullptr);
+        slot->Set(new (slot->GetInlineStorage()) Value { i, i + 1, i + 2 });
+        slots.push_back(slot);
+    }
+
+    // inline values don't overlap the neighbouring slots
+    for (uint64_t i = 0; i < slots.size(); ++i) {
+        REQUIRE(slots[i]->IsInline());
+        REQUIRE(slots[i]->Get()->a == i);
+        REQUIRE(slots[i]->Get()->c == i + 2);
+    }
+
+    size_t count = 0;
+    storage.ForEachSlot([&](SlotPage<Value>* page, SlotStorage<Value>::Slot* slot) {
+        REQUIRE(slot->IsInline());
+        REQUIRE(slot->Get()->b == slot->Get()->a + 1);
+        ++count;
+    });
+    REQUIRE(count == slots.size());
 }
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include <catch2/catch.hpp>
+
+#include <utils/threading/thread_pool.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("work stealing deque") {
+    using namespace nlang;
+
+    WorkStealingDeque<int> deque(4);
+    int value = 0;
+    REQUIRE(!deque.Pop(value));
+    REQUIRE(!deque.Steal(value));
+
+    // grows over initial capacity
+    for (int i = 0; i < 100; ++i) {
+        deque.Push(i);
+    }
+    REQUIRE(deque.Size() == 100);
+    REQUIRE(deque.Steal(value));
+    REQUIRE(value == 0);
+    REQUIRE(deque.Pop(value));
+    REQUIRE(value == 99);
+    for (int i = 98; i >= 1; --i) {
+        REQUIRE(deque.Pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE(!deque.Pop(value));
+    REQUIRE(!deque.Steal(value));
+}
+
+TEST_CASE("work stealing deque concurrent steals") {
+    using namespace nlang;
+
+    constexpr int count = 200000;
+    WorkStealingDeque<int> deque;
+    std::vector<std::atomic<int>> taken(count);
+    std::atomic<bool> done { false };
+
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; ++i) {
+        thieves.emplace_back([&]() {
+            int value = 0;
+            while (!done.load()) {
+                if (deque.Steal(value)) {
+                    taken[value].fetch_add(1);
+                }
+            }
+        });
+    }
+
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        deque.Push(i);
+        if (i % 3 == 0 && deque.Pop(value)) {
+            taken[value].fetch_add(1);
+        }
+    }
+    while (deque.Pop(value)) {
+        taken[value].fetch_add(1);
+    }
+    done.store(true);
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    for (int i = 0; i < count; ++i) {
+        REQUIRE(taken[i].load() == 1);
+    }
+}
+
+TEST_CASE("thread pool enqueue") {
+    using namespace nlang;
+
+    ThreadPool pool(4);
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.Enqueue([](int a, int b) { return a * b; }, i, 2));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(futures[i].get() == i * 2);
+    }
+
+    auto failed = pool.Enqueue([]() -> int { throw std::runtime_error("error"); });
+    REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+}
+
+TEST_CASE("thread pool parallel for") {
+    using namespace nlang;
+
+    ThreadPool pool(4);
+    REQUIRE(pool.GetThreadsCount() == 4);
+
+    std::vector<int> data(100000);
+    pool.ParallelFor(0, data.size(), 64, [&](size_t i) {
+        data[i] = static_cast<int>(i);
+    });
+    for (size_t i = 0; i < data.size(); ++i) {
+        REQUIRE(data[i] == static_cast<int>(i));
+    }
+
+    // nested loops, started from workers
+    std::atomic<size_t> sum { 0 };
+    pool.ParallelFor(0, 100, 1, [&](size_t i) {
+        pool.ParallelFor(0, 1000, 16, [&](size_t j) {
+            sum.fetch_add(i * j, std::memory_order_relaxed);
+        });
+    });
+    REQUIRE(sum.load() == size_t(99 * 100 / 2) * size_t(999 * 1000 / 2));
+
+    pool.ParallelFor(10, 10, 1, [](size_t) {
+        FAIL("empty range");
+    });
+
+    REQUIRE_THROWS_AS(pool.ParallelFor(0, 1000, 1, [](size_t i) {
+        if (i == 500) {
+            throw std::runtime_error("error");
+        }
+    }), std::runtime_error);
+}
+
+TEST_CASE("thread pool task group") {
+    using namespace nlang;
+
+    ThreadPool pool(3);
+    TaskGroup group(pool);
+
+    // group is reused after wait
+    for (int round = 0; round < 3; ++round) {
+        std::atomic<int> counter { 0 };
+        for (int i = 0; i < 1000; ++i) {
+            group.Run([&counter]() {
+                counter.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        group.Wait();
+        REQUIRE(counter.load() == 1000);
+    }
+
+    // big functions don't fit into the task and are placed on heap
+    std::array<int, 64> big {};
+    std::atomic<int> sum { 0 };
+    group.Run([big, &sum]() {
+        sum.fetch_add(std::accumulate(big.begin(), big.end(), 1));
+    });
+    group.Wait();
+    REQUIRE(sum.load() == 1);
+
+    // tasks, spawned by tasks
+    std::atomic<int> counter { 0 };
+    group.Run([&pool, &counter]() {
+        TaskGroup nested(pool);
+        for (int i = 0; i < 100; ++i) {
+            nested.Run([&counter]() {
+                counter.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+        nested.Wait();
+    });
+    group.Wait();
+    REQUIRE(counter.load() == 100);
+
+    group.Run([]() {
+        throw std::runtime_error("error");
+    });
+    group.Run([]() {});
+    REQUIRE_THROWS_AS(group.Wait(), std::runtime_error);
+    group.Run([]() {});
+    REQUIRE_NOTHROW(group.Wait());
+}
+
+namespace {
+
+/**
+ * Previous implementation of the thread pool: single queue of std::function, guarded by mutex
+ */
+class MutexThreadPool {
+public:
+    explicit MutexThreadPool(size_t threads) {
+        workers.resize(threads);
+        for (auto& worker : workers) {
+            worker = std::thread([this]() {
+                while (true) {
+                    std::unique_lock lock(mutex);
+                    condition.wait(lock, [this]() { return shutdown || !tasks.empty(); });
+                    if (shutdown && tasks.empty()) {
+                        break;
+                    }
+                    std::function<void()> task(std::move(tasks.front()));
+                    tasks.pop();
+                    lock.unlock();
+                    task();
+                }
+            });
+        }
+    }
+
+    template<typename F, class ...Args>
+    std::future<std::result_of_t<F(Args...)>> Enqueue(F&& f, Args&&... args) {
+        auto task = std::make_shared<std::packaged_task<std::result_of_t<F(Args...)>()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        auto future = task->get_future();
+        {
+            std::lock_guard guard(mutex);
+            tasks.emplace([task]() { (*task)(); });
+        }
+        condition.notify_one();
+        return future;
+    }
+
+    ~MutexThreadPool() {
+        {
+            std::lock_guard guard(mutex);
+            shutdown = true;
+        }
+        condition.notify_all();
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::queue<std::function<void()>> tasks;
+    bool shutdown = false;
+};
+
+/**
+ * Small piece of work, that is done by each task
+ */
+void Work(std::atomic<size_t>& sink, size_t i) {
+    size_t x = i;
+    for (int k = 0; k < 16; ++k) {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    sink.fetch_add(x & 1, std::memory_order_relaxed);
+}
+
+}
+
+TEST_CASE("thread pool throughput", "[.][benchmark]") {
+    using namespace nlang;
+
+    constexpr size_t tasks = 1 << 18;
+
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        std::atomic<size_t> sink { 0 };
+
+        double mutex_rate = 0;
+        {
+            MutexThreadPool pool(threads);
+            const auto start = std::chrono::steady_clock::now();
+            std::vector<std::future<void>> futures;
+            futures.reserve(tasks);
+            for (size_t i = 0; i < tasks; ++i) {
+                futures.push_back(pool.Enqueue(Work, std::ref(sink), i));
+            }
+            for (auto& future : futures) {
+                future.get();
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            mutex_rate = tasks / elapsed.count();
+        }
+
+        double group_rate = 0;
+        double parallel_for_rate = 0;
+        {
+            ThreadPool pool(threads);
+
+            auto start = std::chrono::steady_clock::now();
+            pool.Enqueue([&]() {
+                TaskGroup group(pool);
+                for (size_t i = 0; i < tasks; ++i) {
+                    group.Run([&sink, i]() { Work(sink, i); });
+                }
+                group.Wait();
+            }).get();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            group_rate = tasks / elapsed.count();
+
+            start = std::chrono::steady_clock::now();
+            pool.ParallelFor(0, tasks, 1, [&sink](size_t i) { Work(sink, i); });
+            elapsed = std::chrono::steady_clock::now() - start;
+            parallel_for_rate = tasks / elapsed.count();
+        }
+
+        std::cout << threads << " threads: mutex queue " << mutex_rate << " tasks/s, task group " << group_rate
+                  << " tasks/s, parallel for " << parallel_for_rate << " tasks/s" << std::endl;
+        REQUIRE(sink.load() > 0);
+    }
+}
\ No newline at end of file